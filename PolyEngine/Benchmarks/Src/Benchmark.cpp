@@ -0,0 +1,64 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Poly;
+
+namespace
+{
+	// Short cases are repeated more, so every case takes roughly the same time
+	constexpr size_t TARGET_ENTITY_COUNT = 200000;
+	constexpr size_t MIN_REPETITIONS = 3;
+	constexpr size_t MAX_REPETITIONS = 50;
+}
+
+//------------------------------------------------------------------------------
+void BenchmarkRunner::Add(const String& name, const BenchmarkFunction& function)
+{
+	Cases.PushBack(Case{ name, function });
+}
+
+//------------------------------------------------------------------------------
+void BenchmarkRunner::Run(const String& variant, const Dynarray<size_t>& entityCounts, size_t repetitions, const char* filter)
+{
+	for (const Case& benchmark : Cases)
+	{
+		if (filter && !strstr(benchmark.Name.GetCStr(), filter))
+			continue;
+
+		for (size_t entityCount : entityCounts)
+		{
+			const size_t runCount = repetitions > 0 ? repetitions : Clamp(TARGET_ENTITY_COUNT / entityCount, MIN_REPETITIONS, MAX_REPETITIONS);
+			Dynarray<double> times;
+			size_t memoryUsage = 0;
+			for (size_t i = 0; i < runCount; ++i)
+			{
+				BenchmarkState state(entityCount);
+				benchmark.Function(state);
+				times.PushBack(state.GetNsPerOp());
+				memoryUsage = std::max(memoryUsage, state.GetMemoryUsage());
+			}
+			std::sort(times.Begin(), times.End());
+
+			Results.PushBack(BenchmarkResult{ benchmark.Name, variant, entityCount, runCount, times[0], times[runCount / 2],
+				static_cast<double>(memoryUsage) / entityCount });
+			fprintf(stderr, "%s/%s/%zu: %.2f ns/op\n", variant.GetCStr(), benchmark.Name.GetCStr(), entityCount, times[0]);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void BenchmarkRunner::WriteJson(FILE* file) const
+{
+	fprintf(file, "{\n\t\"results\": [");
+	for (size_t i = 0; i < Results.GetSize(); ++i)
+	{
+		const BenchmarkResult& result = Results[i];
+		fprintf(file, "%s\n\t\t{ \"name\": \"%s\", \"variant\": \"%s\", \"entities\": %zu, \"repetitions\": %zu, "
+			"\"ns_per_op\": %.3f, \"median_ns_per_op\": %.3f, \"bytes_per_entity\": %.1f }",
+			i > 0 ? "," : "", result.Name.GetCStr(), result.Variant.GetCStr(), result.EntityCount, result.Repetitions,
+			result.MinNsPerOp, result.MedianNsPerOp, result.BytesPerEntity);
+	}
+	fprintf(file, "\n\t]\n}\n");
+}
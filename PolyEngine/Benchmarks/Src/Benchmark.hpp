@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+#include <Core.hpp>
+
+namespace Poly
+{
+	/// <summary>State of a single run of a benchmark case. The case prepares its data, measures the operations
+	/// between Start() and Stop() and reports how many operations were measured and how much memory they used.</summary>
+	class BenchmarkState : public BaseObject<>
+	{
+	public:
+		explicit BenchmarkState(size_t entityCount) : EntityCount(entityCount), OpCount(entityCount) {}
+
+		/// <summary>Returns count of entities the case should work on.</summary>
+		size_t GetEntityCount() const { return EntityCount; }
+
+		/// <summary>Starts measurement. Time between several Start() and Stop() pairs is summed.</summary>
+		void Start() { StartTime = Clock::now(); }
+		void Stop() { Elapsed += Clock::now() - StartTime; }
+
+		/// <summary>Sets count of measured operations, it is the entity count by default.</summary>
+		void SetOpCount(size_t count) { OpCount = count; }
+
+		/// <summary>Reports memory used by the measured state, it is divided by the entity count in results.</summary>
+		void SetMemoryUsage(size_t bytes) { MemoryUsage = bytes; }
+
+		double GetNsPerOp() const { return std::chrono::duration<double, std::nano>(Elapsed).count() / OpCount; }
+		size_t GetMemoryUsage() const { return MemoryUsage; }
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		const size_t EntityCount;
+		size_t OpCount;
+		size_t MemoryUsage = 0;
+		Clock::time_point StartTime;
+		Clock::duration Elapsed = Clock::duration::zero();
+	};
+
+	/// <summary>Result of a benchmark case for one entity count.</summary>
+	struct BenchmarkResult
+	{
+		String Name;
+		String Variant;
+		size_t EntityCount;
+		size_t Repetitions;
+		double MinNsPerOp;
+		double MedianNsPerOp;
+		double BytesPerEntity;
+	};
+
+	/// <summary>Runs benchmark cases for several entity counts and writes results as JSON.</summary>
+	/// <para>Every case is repeated with fresh data and the fastest and median run are reported,
+	/// the fastest one is the most stable between runs and should be compared between engine versions.</para>
+	class BenchmarkRunner : public BaseObject<>
+	{
+	public:
+		typedef std::function<void(BenchmarkState&)> BenchmarkFunction;
+
+		/// <summary>Registers a benchmark case. Cases are run in registration order.</summary>
+		void Add(const String& name, const BenchmarkFunction& function);
+
+		/// <summary>Runs all cases, whose name contains filter, for every entity count.</summary>
+		/// <param name="variant">Label of the configuration cases are run in, stored with results.</param>
+		/// <param name="repetitions">Count of runs of every case, 0 chooses it from the entity count.</param>
+		void Run(const String& variant, const Dynarray<size_t>& entityCounts, size_t repetitions, const char* filter);
+
+		const Dynarray<BenchmarkResult>& GetResults() const { return Results; }
+
+		/// <summary>Writes all results gathered so far as a JSON document.</summary>
+		void WriteJson(FILE* file) const;
+
+	private:
+		struct Case
+		{
+			String Name;
+			BenchmarkFunction Function;
+		};
+
+		Dynarray<Case> Cases;
+		Dynarray<BenchmarkResult> Results;
+	};
+}
@@ -0,0 +1,222 @@
+#include "EcsBenchmarks.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include <Engine.hpp>
+#include <World.hpp>
+#include <DeferredTaskSystem.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	template<int N>
+	class BenchComponent : public ComponentBase
+	{
+	public:
+		explicit BenchComponent(int value) : Value(value) {}
+		int Value;
+	};
+
+	typedef BenchComponent<0> BenchComponentA;
+	typedef BenchComponent<1> BenchComponentB;
+	typedef BenchComponent<2> BenchComponentC;
+	typedef BenchComponent<3> BenchComponentD;
+
+	enum class eBenchComponents
+	{
+		A = (int)eEngineComponents::_COUNT,
+		B,
+		C,
+		D,
+		_COUNT
+	};
+
+	// Read-only cases repeat their pass over small worlds, so that a single measurement is not dominated by timer resolution
+	constexpr size_t MIN_READ_OPS = 65536;
+
+	// Results of read-only passes are stored here, so that they are not optimized out
+	volatile int Sink = 0;
+
+	Dynarray<EntityID> SpawnEntities(World* world, size_t count)
+	{
+		return DeferredTaskSystem::SpawnEntitiesImmediate<BenchComponentA, BenchComponentB, BenchComponentC, BenchComponentD>(world, count,
+			std::make_tuple(1), std::make_tuple(2), std::make_tuple(3), std::make_tuple(4));
+	}
+
+	size_t GetPassCount(size_t entityCount)
+	{
+		return std::max<size_t>(1, MIN_READ_OPS / entityCount);
+	}
+
+	template<typename Tuple, size_t... Idx>
+	int SumValues(const Tuple& components, std::index_sequence<Idx...>)
+	{
+		int sum = 0;
+		(void)std::initializer_list<int>{ (sum += std::get<Idx>(components)->Value)... };
+		return sum;
+	}
+
+	template<typename... Components>
+	void IterateComponents(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		SpawnEntities(world.get(), state.GetEntityCount());
+		const size_t passCount = GetPassCount(state.GetEntityCount());
+
+		int sum = 0;
+		state.Start();
+		for (size_t pass = 0; pass < passCount; ++pass)
+		{
+			for (auto components : world->IterateComponents<Components...>())
+				sum += SumValues(components, std::index_sequence_for<Components...>());
+		}
+		state.Stop();
+		Sink = sum;
+		state.SetOpCount(passCount * state.GetEntityCount());
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	void SpawnEntity(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		state.Start();
+		for (size_t i = 0; i < state.GetEntityCount(); ++i)
+			DeferredTaskSystem::SpawnEntityImmediate(world.get());
+		state.Stop();
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	void SpawnEntityBatch(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		state.Start();
+		SpawnEntities(world.get(), state.GetEntityCount());
+		state.Stop();
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	void DestroyEntity(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		const Dynarray<EntityID> ids = SpawnEntities(world.get(), state.GetEntityCount());
+		state.SetMemoryUsage(world->GetMemoryUsage());
+		state.Start();
+		for (const EntityID& id : ids)
+			DeferredTaskSystem::DestroyEntityImmediate(world.get(), id);
+		state.Stop();
+	}
+
+	//------------------------------------------------------------------------------
+	void DestroyEntityBatch(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		const Dynarray<EntityID> ids = SpawnEntities(world.get(), state.GetEntityCount());
+		state.SetMemoryUsage(world->GetMemoryUsage());
+		state.Start();
+		DeferredTaskSystem::DestroyEntitiesImmediate(world.get(), ids);
+		state.Stop();
+	}
+
+	//------------------------------------------------------------------------------
+	void AddComponent(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		const Dynarray<EntityID> ids = DeferredTaskSystem::SpawnEntitiesImmediate<BenchComponentA>(world.get(), state.GetEntityCount(), std::make_tuple(1));
+		state.Start();
+		for (const EntityID& id : ids)
+			DeferredTaskSystem::AddComponentImmediate<BenchComponentB>(world.get(), id, 2);
+		state.Stop();
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	// components can be removed only with deferred tasks, so the flush is measured too
+	void RemoveComponent(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		const Dynarray<EntityID> ids = DeferredTaskSystem::SpawnEntitiesImmediate<BenchComponentA, BenchComponentB>(world.get(), state.GetEntityCount(),
+			std::make_tuple(1), std::make_tuple(2));
+		state.SetMemoryUsage(world->GetMemoryUsage());
+		state.Start();
+		for (const EntityID& id : ids)
+			DeferredTaskSystem::RemoveComponent<BenchComponentB>(world.get(), id);
+		DeferredTaskSystem::DeferredTaskPhase(world.get());
+		state.Stop();
+	}
+
+	//------------------------------------------------------------------------------
+	void GetComponent(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		Dynarray<EntityID> ids = SpawnEntities(world.get(), state.GetEntityCount());
+		// entities are looked up in random order, as gameplay code does
+		std::shuffle(ids.Begin(), ids.End(), std::mt19937(42));
+		const size_t passCount = GetPassCount(state.GetEntityCount());
+
+		int sum = 0;
+		state.Start();
+		for (size_t pass = 0; pass < passCount; ++pass)
+		{
+			for (const EntityID& id : ids)
+				sum += world->GetComponent<BenchComponentC>(id)->Value;
+		}
+		state.Stop();
+		Sink = sum;
+		state.SetOpCount(passCount * state.GetEntityCount());
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	void DeferredTaskFlush(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		const Dynarray<EntityID> ids = DeferredTaskSystem::SpawnEntitiesImmediate<BenchComponentA>(world.get(), state.GetEntityCount(), std::make_tuple(1));
+		for (const EntityID& id : ids)
+			DeferredTaskSystem::AddComponent<BenchComponentB>(world.get(), id, 2);
+		state.Start();
+		DeferredTaskSystem::DeferredTaskPhase(world.get());
+		state.Stop();
+		state.SetMemoryUsage(world->GetMemoryUsage());
+	}
+
+	//------------------------------------------------------------------------------
+	void DestroyWorld(BenchmarkState& state)
+	{
+		std::unique_ptr<World> world = gEngine->CreateWorld();
+		SpawnEntities(world.get(), state.GetEntityCount());
+		state.SetMemoryUsage(world->GetMemoryUsage());
+		state.Start();
+		world.reset();
+		state.Stop();
+	}
+}
+
+//------------------------------------------------------------------------------
+void Poly::RegisterEcsBenchmarks(Engine* engine, BenchmarkRunner& runner)
+{
+	engine->RegisterComponent<BenchComponentA>((size_t)eBenchComponents::A);
+	engine->RegisterComponent<BenchComponentB>((size_t)eBenchComponents::B);
+	engine->RegisterComponent<BenchComponentC>((size_t)eBenchComponents::C);
+	engine->RegisterComponent<BenchComponentD>((size_t)eBenchComponents::D);
+
+	runner.Add("spawn_entity", SpawnEntity);
+	runner.Add("spawn_entities_batch", SpawnEntityBatch);
+	runner.Add("destroy_entity", DestroyEntity);
+	runner.Add("destroy_entities_batch", DestroyEntityBatch);
+	runner.Add("add_component", AddComponent);
+	runner.Add("remove_component", RemoveComponent);
+	runner.Add("iterate_1", IterateComponents<BenchComponentA>);
+	runner.Add("iterate_2", IterateComponents<BenchComponentA, BenchComponentB>);
+	runner.Add("iterate_3", IterateComponents<BenchComponentA, BenchComponentB, BenchComponentC>);
+	runner.Add("iterate_4", IterateComponents<BenchComponentA, BenchComponentB, BenchComponentC, BenchComponentD>);
+	runner.Add("get_component", GetComponent);
+	runner.Add("deferred_task_flush", DeferredTaskFlush);
+	runner.Add("destroy_world", DestroyWorld);
+}
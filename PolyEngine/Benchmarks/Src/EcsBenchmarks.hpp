@@ -0,0 +1,11 @@
+#pragma once
+
+namespace Poly
+{
+	class Engine;
+	class BenchmarkRunner;
+
+	/// <summary>Registers benchmark components in the engine and adds ECS benchmark cases to the runner.
+	/// Every case works on a fresh world created with current <see cref="CoreConfig.ComponentStorage"/>.</summary>
+	void RegisterEcsBenchmarks(Engine* engine, BenchmarkRunner& runner);
+}
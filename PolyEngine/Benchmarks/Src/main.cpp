@@ -0,0 +1,116 @@
+#include <cstring>
+
+#include <Engine.hpp>
+#include <CoreConfig.hpp>
+#include <FileIO.hpp>
+
+#include "Benchmark.hpp"
+#include "EcsBenchmarks.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	class DummyGame : public IGame
+	{
+	public:
+		void RegisterEngine(Engine* /*engine*/) override {}
+		void Init() override {}
+		void Deinit() override {}
+	};
+
+	class DummyRenderingDevice : public IRenderingDevice
+	{
+	public:
+		void Resize(const ScreenSize& size) override { Size = size; }
+		const ScreenSize& GetScreenSize() const override { return Size; }
+		void RenderWorld(World* /*world*/) override {}
+		std::unique_ptr<ITextureDeviceProxy> CreateTexture(size_t /*width*/, size_t /*height*/, eTextureUsageType /*usage*/) override { return nullptr; }
+		std::unique_ptr<ITextFieldBufferDeviceProxy> CreateTextFieldBuffer() override { return nullptr; }
+		std::unique_ptr<IMeshDeviceProxy> CreateMesh() override { return nullptr; }
+
+		ScreenSize Size;
+	};
+
+	void PrintUsage(const char* program)
+	{
+		fprintf(stderr, "Usage: %s [--out file.json] [--sizes 1000,10000,65000] [--repetitions count] [--storage pool|archetype] [--filter name]\n", program);
+	}
+}
+
+// Writes JSON results to the output file or to the standard output, progress is printed to the standard error.
+int main(int argc, char* argv[])
+{
+	const char* outPath = nullptr;
+	const char* filter = nullptr;
+	const char* storageName = nullptr;
+	size_t repetitions = 0;
+	Dynarray<size_t> entityCounts;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (i + 1 == argc)
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+
+		const char* value = argv[++i];
+		if (strcmp(argv[i - 1], "--out") == 0)
+			outPath = value;
+		else if (strcmp(argv[i - 1], "--filter") == 0)
+			filter = value;
+		else if (strcmp(argv[i - 1], "--storage") == 0)
+			storageName = value;
+		else if (strcmp(argv[i - 1], "--repetitions") == 0)
+			repetitions = strtoul(value, nullptr, 10);
+		else if (strcmp(argv[i - 1], "--sizes") == 0)
+		{
+			char* end = nullptr;
+			do
+			{
+				const size_t count = strtoul(value, &end, 10);
+				if (count == 0 || count > gCoreConfig.MaxEntityCount || (*end != ',' && *end != '\0'))
+				{
+					PrintUsage(argv[0]);
+					return 1;
+				}
+				entityCounts.PushBack(count);
+				value = end + 1;
+			} while (*end == ',');
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (entityCounts.IsEmpty())
+		entityCounts = { 1000, 10000, 65000 };
+
+	Engine engine(std::make_unique<DummyGame>(), std::make_unique<DummyRenderingDevice>());
+	BenchmarkRunner runner;
+	RegisterEcsBenchmarks(&engine, runner);
+
+	const std::pair<const char*, eComponentStorage> storages[] = { { "pool", eComponentStorage::POOL }, { "archetype", eComponentStorage::ARCHETYPE } };
+	for (const auto& storage : storages)
+	{
+		if (storageName && strcmp(storageName, storage.first) != 0)
+			continue;
+		gCoreConfig.ComponentStorage = storage.second;
+		runner.Run(storage.first, entityCounts, repetitions, filter);
+	}
+	gCoreConfig.ComponentStorage = eComponentStorage::POOL;
+
+	FILE* file = stdout;
+	if (outPath && fopen_s(&file, outPath, "w") != 0)
+	{
+		fprintf(stderr, "Could not open %s\n", outPath);
+		return 1;
+	}
+	runner.WriteJson(file);
+	if (file != stdout)
+		fclose(file);
+	return 0;
+}
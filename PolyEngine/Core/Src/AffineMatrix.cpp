@@ -0,0 +1,283 @@
+#include "CorePCH.hpp"
+
+#include "AffineMatrix.hpp"
+
+using namespace Poly;
+
+namespace
+{
+#if !DISABLE_SIMD
+  SILENCE_GCC_WARNING(-Wignored-attributes)
+  // Row of lhs * rhs, where rhs is affine, so its implicit last row [0, 0, 0, 1] only passes the W coefficient through.
+  inline __m128 MulAffineRow(__m128 lhsRow, const std::array<__m128, 3>& rhs) {
+    const __m128 wMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    __m128 ret = _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(0, 0, 0, 0)), rhs[0]);
+    ret = _mm_add_ps(ret, _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(1, 1, 1, 1)), rhs[1]));
+    ret = _mm_add_ps(ret, _mm_mul_ps(_mm_shuffle_ps(lhsRow, lhsRow, _MM_SHUFFLE(2, 2, 2, 2)), rhs[2]));
+    return _mm_add_ps(ret, _mm_and_ps(lhsRow, wMask));
+  }
+
+  inline __m128 Cross(__m128 a, __m128 b) {
+    __m128 ret = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2)));
+    return _mm_sub_ps(ret, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))));
+  }
+
+  // Sets rows of the inversed transformation from columns of the inversed 3x3 part (W has to be 0) and the original translation.
+  inline void SetInversedRows(std::array<__m128, 3>& rows, __m128 c0, __m128 c1, __m128 c2, float tx, float ty, float tz) {
+    __m128 t = _mm_mul_ps(c0, _mm_set1_ps(tx));
+    t = _mm_add_ps(t, _mm_mul_ps(c1, _mm_set1_ps(ty)));
+    t = _mm_add_ps(t, _mm_mul_ps(c2, _mm_set1_ps(tz)));
+    t = _mm_sub_ps(_mm_setzero_ps(), t);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, t);
+    rows[0] = c0;
+    rows[1] = c1;
+    rows[2] = c2;
+  }
+  UNSILENCE_GCC_WARNING()
+#else
+  inline void SetInversedRows(std::array<float, 12>& data, const float c[3][3], float tx, float ty, float tz) {
+    for (int row = 0; row < 3; ++row) {
+      data[4*row] = c[0][row];
+      data[4*row + 1] = c[1][row];
+      data[4*row + 2] = c[2][row];
+      data[4*row + 3] = -(c[0][row]*tx + c[1][row]*ty + c[2][row]*tz);
+    }
+  }
+#endif
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix::AffineMatrix() { SetIdentity(); }
+
+//------------------------------------------------------------------------------
+AffineMatrix::AffineMatrix(const float data[12]) {
+  memmove(Data.data(), data, sizeof(float)*12);
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix::AffineMatrix(const Matrix& rhs) {
+  HEAVY_ASSERTE(Cmpf(rhs.m30, 0) && Cmpf(rhs.m31, 0) && Cmpf(rhs.m32, 0) && Cmpf(rhs.m33, 1), "Matrix is not affine!");
+#if DISABLE_SIMD
+  for(int i=0; i<12; ++i)
+    Data[i] = rhs.Data[i];
+#else
+  for(int i=0; i<3; ++i)
+    SimdRow[i] = rhs.SimdRow[i];
+#endif
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix::AffineMatrix(const Vector& translation, const Quaternion& rotation, const Vector& scale) {
+  const float X = rotation.X, Y = rotation.Y, Z = rotation.Z, W = rotation.W;
+
+  // rotation matrix (see Quaternion::operator Matrix()) with columns scaled
+  m00 = (1 - 2 * Y * Y - 2 * Z * Z) * scale.X;
+  m01 = (2 * X * Y - 2 * W * Z) * scale.Y;
+  m02 = (2 * X * Z + 2 * W * Y) * scale.Z;
+  m03 = translation.X;
+
+  m10 = (2 * X * Y + 2 * W * Z) * scale.X;
+  m11 = (1 - 2 * X * X - 2 * Z * Z) * scale.Y;
+  m12 = (2 * Y * Z - 2 * W * X) * scale.Z;
+  m13 = translation.Y;
+
+  m20 = (2 * X * Z - 2 * W * Y) * scale.X;
+  m21 = (2 * Y * Z + 2 * W * X) * scale.Y;
+  m22 = (1 - 2 * Y * Y - 2 * X * X) * scale.Z;
+  m23 = translation.Z;
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix::AffineMatrix(const AffineMatrix& rhs) { *this = rhs; }
+
+//------------------------------------------------------------------------------
+AffineMatrix& AffineMatrix::operator=(const AffineMatrix& rhs) {
+  if (&rhs == this) return *this;
+#if DISABLE_SIMD
+  for(int i=0; i<12; ++i)
+    Data[i] = rhs.Data[i];
+#else
+  for(int i=0; i<3; ++i)
+    SimdRow[i] = rhs.SimdRow[i];
+#endif
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+bool AffineMatrix::operator==(const AffineMatrix& rhs) const {
+#if DISABLE_SIMD
+  bool result = true;
+  for(int i=0; i<12 && result; ++i)
+    result = result && Cmpf(Data[i], rhs.Data[i]);
+  return result;
+#else
+  __m128 result0 = _mm_cmpf_ps(SimdRow[0], rhs.SimdRow[0]);
+  __m128 result1 = _mm_cmpf_ps(SimdRow[1], rhs.SimdRow[1]);
+  __m128 result2 = _mm_cmpf_ps(SimdRow[2], rhs.SimdRow[2]);
+  return _mm_movemask_ps(_mm_and_ps(_mm_and_ps(result0, result1), result2)) == 0xf;
+#endif
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix AffineMatrix::operator*(const AffineMatrix& rhs) const {
+  AffineMatrix ret;
+#if DISABLE_SIMD
+  for(int row=0; row<3; ++row) {
+    for(int col=0; col<4; ++col) {
+      ret.Data[4*row + col] = Data[4*row]*rhs.Data[col] + Data[4*row + 1]*rhs.Data[4 + col] + Data[4*row + 2]*rhs.Data[8 + col] + (col == 3 ? Data[4*row + 3] : 0.f);
+    }
+  }
+#else
+  for (int i = 0; i < 3; ++i)
+    ret.SimdRow[i] = MulAffineRow(SimdRow[i], rhs.SimdRow);
+#endif
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix& AffineMatrix::operator*=(const AffineMatrix& rhs) { return *this = *this * rhs; }
+
+//------------------------------------------------------------------------------
+Vector AffineMatrix::TransformPoint(const Vector& point) const {
+  Vector ret;
+#if DISABLE_SIMD
+  for(int row=0; row<3; ++row)
+    ret.Data[row] = Data[4*row]*point.X + Data[4*row + 1]*point.Y + Data[4*row + 2]*point.Z + Data[4*row + 3];
+  ret.W = 1.f;
+#else
+  __m128 p = _mm_setr_ps(point.X, point.Y, point.Z, 1.f);
+  __m128 xy = _mm_hadd_ps(_mm_mul_ps(SimdRow[0], p), _mm_mul_ps(SimdRow[1], p));
+  __m128 zw = _mm_hadd_ps(_mm_mul_ps(SimdRow[2], p), _mm_setr_ps(0.f, 0.f, 0.f, 1.f));
+  ret.SimdData = _mm_hadd_ps(xy, zw);
+#endif
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+Vector AffineMatrix::TransformVector(const Vector& direction) const {
+  Vector ret;
+#if DISABLE_SIMD
+  for(int row=0; row<3; ++row)
+    ret.Data[row] = Data[4*row]*direction.X + Data[4*row + 1]*direction.Y + Data[4*row + 2]*direction.Z;
+  ret.W = 0.f;
+#else
+  __m128 d = _mm_setr_ps(direction.X, direction.Y, direction.Z, 0.f);
+  __m128 xy = _mm_hadd_ps(_mm_mul_ps(SimdRow[0], d), _mm_mul_ps(SimdRow[1], d));
+  __m128 zw = _mm_hadd_ps(_mm_mul_ps(SimdRow[2], d), _mm_setzero_ps());
+  ret.SimdData = _mm_hadd_ps(xy, zw);
+#endif
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix& AffineMatrix::SetIdentity() {
+  Data.fill(0);
+  Data[0] = 1.0f;
+  Data[5] = 1.0f;
+  Data[10] = 1.0f;
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix& AffineMatrix::Inverse() {
+  // columns of the inversed 3x3 part are cross products of its rows divided by the determinant
+#if DISABLE_SIMD
+  float c[3][3] = {
+    { m11*m22 - m12*m21, m12*m20 - m10*m22, m10*m21 - m11*m20 },
+    { m21*m02 - m22*m01, m22*m00 - m20*m02, m20*m01 - m21*m00 },
+    { m01*m12 - m02*m11, m02*m10 - m00*m12, m00*m11 - m01*m10 }
+  };
+  float det = m00*c[0][0] + m01*c[0][1] + m02*c[0][2];
+
+  HEAVY_ASSERTE(det != 0, "Determinant is equal to 0!");
+
+  float idet = 1.0f/det;
+  for(int i=0; i<3; ++i)
+    for(int j=0; j<3; ++j)
+      c[i][j] *= idet;
+  SetInversedRows(Data, c, m03, m13, m23);
+#else
+  const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  __m128 r0 = _mm_and_ps(SimdRow[0], xyzMask);
+  __m128 r1 = _mm_and_ps(SimdRow[1], xyzMask);
+  __m128 r2 = _mm_and_ps(SimdRow[2], xyzMask);
+  __m128 c0 = Cross(r1, r2);
+  __m128 det = _mm_dot_ps(r0, c0);
+
+  HEAVY_ASSERTE(_mm_cvtss_f32(det) != 0, "Determinant is equal to 0!");
+
+  __m128 idet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+  c0 = _mm_mul_ps(c0, idet);
+  __m128 c1 = _mm_mul_ps(Cross(r2, r0), idet);
+  __m128 c2 = _mm_mul_ps(Cross(r0, r1), idet);
+  SetInversedRows(SimdRow, c0, c1, c2, m03, m13, m23);
+#endif
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix AffineMatrix::GetInversed() const {
+  AffineMatrix ret = *this;
+  return ret.Inverse();
+}
+
+//------------------------------------------------------------------------------
+AffineMatrix AffineMatrix::GetRigidInversed() const {
+  // inverse of rotation is its transposition, so columns of the inversed 3x3 part are its rows
+  AffineMatrix ret;
+#if DISABLE_SIMD
+  const float c[3][3] = { { m00, m01, m02 }, { m10, m11, m12 }, { m20, m21, m22 } };
+  SetInversedRows(ret.Data, c, m03, m13, m23);
+#else
+  const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  SetInversedRows(ret.SimdRow, _mm_and_ps(SimdRow[0], xyzMask), _mm_and_ps(SimdRow[1], xyzMask), _mm_and_ps(SimdRow[2], xyzMask), m03, m13, m23);
+#endif
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+Matrix AffineMatrix::ToMatrix() const {
+  Matrix ret;
+#if DISABLE_SIMD
+  for(int i=0; i<12; ++i)
+    ret.Data[i] = Data[i];
+#else
+  for(int i=0; i<3; ++i)
+    ret.SimdRow[i] = SimdRow[i];
+#endif
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+const float* AffineMatrix::GetDataPtr() const { return Data.data(); }
+
+//------------------------------------------------------------------------------
+bool AffineMatrix::Decompose(Vector& translation, Quaternion& rotation, Vector& scale) const {
+  return ToMatrix().Decompose(translation, rotation, scale);
+}
+
+namespace Poly {
+  //------------------------------------------------------------------------------
+  Matrix operator*(const Matrix& lhs, const AffineMatrix& rhs) {
+    Matrix ret;
+#if DISABLE_SIMD
+    for(int row=0; row<4; ++row) {
+      for(int col=0; col<4; ++col) {
+        ret.Data[4*row + col] = lhs.Data[4*row]*rhs.Data[col] + lhs.Data[4*row + 1]*rhs.Data[4 + col] + lhs.Data[4*row + 2]*rhs.Data[8 + col] + (col == 3 ? lhs.Data[4*row + 3] : 0.f);
+      }
+    }
+#else
+    for (int i = 0; i < 4; ++i)
+      ret.SimdRow[i] = MulAffineRow(lhs.SimdRow[i], rhs.SimdRow);
+#endif
+    return ret;
+  }
+
+  //------------------------------------------------------------------------------
+  std::ostream& operator<< (std::ostream& stream, const AffineMatrix& mat) {
+    stream << "AffMat[ ";
+    for (int i = 0; i < 12; ++i)
+      stream << mat.Data[i] << " ";
+    return stream << "]";
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <pmmintrin.h>
+
+#include "Defines.hpp"
+#include "Vector.hpp"
+#include "Matrix.hpp"
+
+namespace Poly
+{
+	class Quaternion;
+
+	/// <summary>Class representing affine transformation as 3x4 matrix in row-major order. It takes advantage of SIMD (if possible).</summary>
+	/// <remarks>The last row of the equivalent 4x4 matrix is always [0, 0, 0, 1], so it is not stored. It takes 48 bytes instead of 64
+	/// and composition needs 9 multiplications and additions per row instead of 16, which makes it the preferred type for model transformations.
+	/// Use ToMatrix() to combine it with projection.</remarks>
+	class ALIGN_16 CORE_DLLEXPORT AffineMatrix : public BaseObject<>{
+	public:
+		AffineMatrix();
+		AffineMatrix(const float data[12]);
+		/// <summary>Creates affine matrix from the first three rows of the matrix. The last row has to be [0, 0, 0, 1].</summary>
+		explicit AffineMatrix(const Matrix& rhs);
+		/// <summary>Creates matrix equal to translation * rotation * scale.</summary>
+		AffineMatrix(const Vector& translation, const Quaternion& rotation, const Vector& scale);
+		AffineMatrix(const AffineMatrix& rhs);
+		AffineMatrix& operator=(const AffineMatrix& rhs);
+
+		bool operator==(const AffineMatrix& rhs) const;
+		inline bool operator!=(const AffineMatrix& rhs) const { return !(*this == rhs); }
+
+		/// <summary>Composition of affine transformations, rhs is applied first.</summary>
+		AffineMatrix operator*(const AffineMatrix& rhs) const;
+
+		/// <summary>Composition (with store) of affine transformations, rhs is applied first.</summary>
+		AffineMatrix& operator*=(const AffineMatrix& rhs);
+
+		/// <summary>Transforms point, W of the argument is ignored and W of the result is 1.</summary>
+		Vector TransformPoint(const Vector& point) const;
+
+		/// <summary>Transforms direction, translation is not applied and W of the result is 0.</summary>
+		Vector TransformVector(const Vector& direction) const;
+
+		/// <summary>Initializes matrix as identity matrix.</summary>
+		/// <returns>Reference to itself.</returns>
+		AffineMatrix& SetIdentity();
+
+		/// <summary>Returns translation part of the transformation.</summary>
+		Vector GetTranslation() const { return Vector(m03, m13, m23); }
+
+		/// <summary>Inverses the matrix. Only the 3x3 part is inversed, translation is found with one matrix-vector multiplication.</summary>
+		/// <returns>Reference to itself after the inversion.</returns>
+		AffineMatrix& Inverse();
+
+		/// <summary>Creates inversed matrix from this one.</summary>
+		/// <returns>New, inversed matrix object.</returns>
+		AffineMatrix GetInversed() const;
+
+		/// <summary>Creates inversed matrix from this one, assuming it contains only rotation and translation.
+		/// The 3x3 part is transposed instead of inversed.</summary>
+		/// <returns>New, inversed matrix object.</returns>
+		AffineMatrix GetRigidInversed() const;
+
+		/// <summary>Creates 4x4 matrix representing the same transformation.</summary>
+		Matrix ToMatrix() const;
+
+		/// <summary>Returns internal data pointer which is organized in row-major order.</summary>
+		/// <returns>Internal data pointer to float array of 12 values.</returns>
+		const float* GetDataPtr() const;
+
+		/// <summary>Performs decomposition of the matrix to separate translation, rotation and scale.</summary>
+		/// <remarks>This method will assert if the decomposed matrix contains skew.</remarks>
+		/// <returns>True if decomposition was sucesfull, false otherwise.</returns>
+		bool Decompose(Vector& translation, Quaternion& rotation, Vector& scale) const;
+
+		CORE_DLLEXPORT friend std::ostream& operator<< (std::ostream& stream, const AffineMatrix& mat);
+
+		// This structure allows to access matrix elements by index or name.
+		union {
+		#if !DISABLE_SIMD
+			SILENCE_GCC_WARNING(-Wignored-attributes)
+			alignas(16) std::array<__m128, 3> SimdRow;
+			UNSILENCE_GCC_WARNING()
+		#endif //!DISABLE_SIMD
+			alignas(16) std::array<float, 12> Data;
+			struct alignas(16) {
+				float m00, m01, m02, m03;
+				float m10, m11, m12, m13;
+				float m20, m21, m22, m23;
+			};
+		};
+	};
+
+	/// <summary>Matrix-AffineMatrix multiplication operator, used to apply projection or view to affine transformation.</summary>
+	CORE_DLLEXPORT Matrix operator*(const Matrix& lhs, const AffineMatrix& rhs);
+}
@@ -2,6 +2,10 @@
 
 #include "Defines.hpp"
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 namespace Poly {
 
 	//cmath std::abs is not constexpr
@@ -93,4 +97,38 @@ namespace Poly {
 		return val1 * (1.0f - t) + val2 * t;
 	}
 
+	// Bit manipulation functions
+	/// <summary>Returns index of the least significant set bit. Value cannot be zero.</summary>
+	inline size_t FindFirstSetBit(uint64_t value) {
+		HEAVY_ASSERTE(value != 0, "Cannot find set bit in zero!");
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward64(&idx, value);
+		return idx;
+#else
+		return static_cast<size_t>(__builtin_ctzll(value));
+#endif
+	}
+
+	/// <summary>Returns index of the most significant set bit. Value cannot be zero.</summary>
+	inline size_t FindLastSetBit(uint64_t value) {
+		HEAVY_ASSERTE(value != 0, "Cannot find set bit in zero!");
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanReverse64(&idx, value);
+		return idx;
+#else
+		return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+	}
+
+	/// <summary>Returns count of set bits.</summary>
+	inline size_t PopCount(uint64_t value) {
+#if defined(_MSC_VER)
+		return static_cast<size_t>(__popcnt64(value));
+#else
+		return static_cast<size_t>(__builtin_popcountll(value));
+#endif
+	}
+
 }
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Defines.hpp"
+#include "Dynarray.hpp"
+#include "String.hpp"
+#include "FileIO.hpp"
+
+namespace Poly {
+
+	/// <summary>Appends raw binary data to a growing in-memory buffer.
+	/// Values are written in native byte order and layout, so data can be read back with <see cref="BinaryReader"/> only on the same platform.</summary>
+	class BinaryWriter : public BaseObject<>
+	{
+	public:
+		/// <summary>Appends size bytes starting at data.</summary>
+		void WriteBytes(const void* data, size_t size)
+		{
+			if (size == 0)
+				return;
+			uint8_t* dst = Grow(size);
+			memcpy(dst, data, size);
+		}
+
+		/// <summary>Appends bitwise copy of a value. Only for trivially copyable types.</summary>
+		template<typename T>
+		void Write(const T& value)
+		{
+			STATIC_ASSERTE(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written directly.");
+			WriteBytes(&value, sizeof(T));
+		}
+
+		/// <summary>Appends length of the string followed by its characters.</summary>
+		void WriteString(const String& str)
+		{
+			Write<uint32_t>(static_cast<uint32_t>(str.GetLength()));
+			WriteBytes(str.GetCStr(), str.GetLength());
+		}
+
+		/// <summary>Appends size bytes without initializing them.</summary>
+		/// <returns>Pointer to the appended bytes, valid until the next write.</returns>
+		uint8_t* Grow(size_t size)
+		{
+			const size_t offset = Buffer.GetSize();
+			// Dynarray reserves exactly the requested capacity, so grow geometrically to keep appends amortized O(1)
+			if (offset + size > Buffer.GetCapacity())
+				Buffer.Reserve(std::max(offset + size, Buffer.GetCapacity() * 2));
+			Buffer.Resize(offset + size);
+			return Buffer.GetData() + offset;
+		}
+
+		/// <summary>Overwrites already written value at given offset, e.g. a size known only after writing the data that follows it.</summary>
+		template<typename T>
+		void Patch(size_t offset, const T& value)
+		{
+			STATIC_ASSERTE(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written directly.");
+			ASSERTE(offset + sizeof(T) <= Buffer.GetSize(), "Patching data that was not written yet!");
+			memcpy(Buffer.GetData() + offset, &value, sizeof(T));
+		}
+
+		/// <summary>Returns count of written bytes, which is also the offset of the next write.</summary>
+		size_t GetSize() const { return Buffer.GetSize(); }
+
+		const Dynarray<uint8_t>& GetBuffer() const { return Buffer; }
+
+	private:
+		Dynarray<uint8_t> Buffer;
+	};
+
+	/// <summary>Reads data written by <see cref="BinaryWriter"/> from a memory block it does not own.
+	/// Reading past the end of the block throws FileIOException, so truncated or corrupted files are not read out of bounds.</summary>
+	class BinaryReader : public BaseObject<>
+	{
+	public:
+		BinaryReader(const uint8_t* data, size_t size) : Data(data), Size(size) {}
+		explicit BinaryReader(const Dynarray<uint8_t>& data) : Data(data.GetData()), Size(data.GetSize()) {}
+
+		/// <summary>Returns pointer to next size bytes and moves past them. Returned data is not aligned in any way.</summary>
+		const uint8_t* ReadBytes(size_t size)
+		{
+			if (size > Size - Offset)
+				throw FileIOException("Unexpected end of binary data!");
+			const uint8_t* ret = Data + Offset;
+			Offset += size;
+			return ret;
+		}
+
+		/// <summary>Reads value written by BinaryWriter::Write().</summary>
+		template<typename T>
+		T Read()
+		{
+			STATIC_ASSERTE(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read directly.");
+			T value;
+			memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		/// <summary>Reads string written by BinaryWriter::WriteString().</summary>
+		String ReadString()
+		{
+			const uint32_t length = Read<uint32_t>();
+			const uint8_t* chars = ReadBytes(length);
+			Dynarray<char> str;
+			str.Resize(length + 1);
+			memcpy(str.GetData(), chars, length);
+			str[length] = 0;
+			return String(str.GetData());
+		}
+
+		/// <summary>Moves past size bytes.</summary>
+		void Skip(size_t size) { ReadBytes(size); }
+
+		size_t GetOffset() const { return Offset; }
+		bool IsAtEnd() const { return Offset == Size; }
+
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+		size_t Offset = 0;
+	};
+
+	//------------------------------------------------------------------------------
+	inline Dynarray<uint8_t> LoadBinaryFile(const String& path)
+	{
+		FILE *f;
+		fopen_s(&f, path.GetCStr(), "rb");
+		if (!f)
+			throw FileIOException("File open failed!");
+
+		fseek(f, 0, SEEK_END);
+		long fsize = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		Dynarray<uint8_t> data;
+		data.Resize(fsize);
+		const size_t read = fsize > 0 ? fread(data.GetData(), fsize, 1, f) : 1;
+		fclose(f);
+		if (read != 1)
+			throw FileIOException("File read failed!");
+		return data;
+	}
+
+	//------------------------------------------------------------------------------
+	inline void SaveBinaryFile(const String& path, const Dynarray<uint8_t>& data)
+	{
+		FILE *f;
+		fopen_s(&f, path.GetCStr(), "wb");
+		if (!f)
+			throw FileIOException("File save failed");
+
+		const size_t written = data.GetSize() > 0 ? fwrite(data.GetData(), data.GetSize(), 1, f) : 1;
+		fclose(f);
+		if (written != 1)
+			throw FileIOException("File save failed");
+	}
+}
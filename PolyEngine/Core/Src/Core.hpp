@@ -7,13 +7,16 @@
 #include "Angle.hpp"
 #include "Vector.hpp"
 #include "Matrix.hpp"
+#include "AffineMatrix.hpp"
 #include "Quaternion.hpp"
 
 // Memory
 #include "BaseObject.hpp"
 #include "Allocator.hpp"
+#include "VirtualMemory.hpp"
 #include "PoolAllocator.hpp"
 #include "IterablePoolAllocator.hpp"
+#include "LinearAllocator.hpp"
 
 // Containers
 #include "String.hpp"
@@ -21,5 +24,6 @@
 // Other
 #include "Color.hpp"
 #include "FileIO.hpp"
+#include "BinaryStream.hpp"
 #include "Logger.hpp"
 #include "UniqueID.hpp"
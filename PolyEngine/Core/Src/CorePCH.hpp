@@ -7,6 +7,7 @@
 #include "Angle.hpp"
 #include "Vector.hpp"
 #include "Matrix.hpp"
+#include "AffineMatrix.hpp"
 #include "Quaternion.hpp"
 #include "SimdMath.hpp"
 
@@ -16,8 +17,10 @@
 // Memory
 #include "BaseObject.hpp"
 #include "Allocator.hpp"
+#include "VirtualMemory.hpp"
 #include "PoolAllocator.hpp"
 #include "IterablePoolAllocator.hpp"
+#include "LinearAllocator.hpp"
 #include "RefCountedBase.hpp"
 
 // Containers
@@ -28,6 +31,8 @@
 // Other
 #include "Color.hpp"
 #include "FileIO.hpp"
+#include "BinaryStream.hpp"
 #include "Logger.hpp"
 #include "UniqueID.hpp"
-#include "EnumUtils.hpp"
\ No newline at end of file
+#include "EnumUtils.hpp"
+#include "ThreadPool.hpp"
\ No newline at end of file
@@ -2,48 +2,150 @@
 
 #include "Defines.hpp"
 #include "Allocator.hpp"
+#include "BasicMath.hpp"
+#include "VirtualMemory.hpp"
 
 namespace Poly {
 
+	/// <summary>Type independent part of <see cref="IterablePoolAllocator"/>.
+	/// Occupied cells are tracked in a bitmap, iteration visits them in address order and skips 64 free cells at once.
+	/// Allows iterating over allocated cells without knowing their type.</summary>
 	class IterablePoolAllocatorBase : public BaseObject<>
 	{
 	public:
+		virtual ~IterablePoolAllocatorBase()
+		{
+			ASSERTE(RawData, "Allocator is invalid");
+			DefaultFree(Occupancy);
+			Occupancy = nullptr;
+			RawData = nullptr;
+		}
+
+		/// <summary>Type independent version of IterablePoolAllocator::Alloc().</summary>
+		/// <returns>Pointer to uninitialized cell or nullptr when the allocator is full.</returns>
+		virtual void* AllocCell() = 0;
 		virtual void Free(void* ptr) = 0;
+
+		/// <summary>Gets current size of the allocator.</summary>
+		/// <returns>Count of allocated objects.</returns>
+		size_t GetSize() const { return Capacity - FreeBlockCount; }
+
+		/// <summary>Gets max count of objects that can be allocated. It is also index returned by NextOccupied() when there are no more cells.</summary>
+		size_t GetCapacity() const { return Capacity; }
+
+		/// <summary>Returns count of cells that were ever allocated. Cells with greater indices are free.</summary>
+		size_t GetInitializedCount() const { return InitializedBlockCount; }
+
+		/// <summary>Returns count of bytes committed for cells plus size of the occupancy bitmap.</summary>
+		size_t GetMemoryUsage() const { return Memory.GetCommittedSize() + sizeof(BitmapWord) * ((Capacity + BITS_PER_WORD - 1) / BITS_PER_WORD); }
+
+		/// <summary>Returns address of a cell with given index.</summary>
+		void* GetCell(size_t i) const { return RawData + i * CellSize; }
+
+		/// <summary>Returns index of the first occupied cell that is not before given index, or Capacity if there is none.</summary>
+		size_t NextOccupied(size_t from) const
+		{
+			// cells past InitializedBlockCount were never allocated
+			const size_t wordCount = (InitializedBlockCount + BITS_PER_WORD - 1) / BITS_PER_WORD;
+			size_t word = from / BITS_PER_WORD;
+			if (word >= wordCount)
+				return Capacity;
+
+			BitmapWord bits = Occupancy[word] & (~BitmapWord(0) << (from % BITS_PER_WORD));
+			while (bits == 0)
+			{
+				if (++word == wordCount)
+					return Capacity;
+				bits = Occupancy[word];
+			}
+			return word * BITS_PER_WORD + FindFirstSetBit(bits);
+		}
+
+		/// <summary>Returns index of the last occupied cell before given index.</summary>
+		size_t PrevOccupied(size_t before) const
+		{
+			HEAVY_ASSERTE(before > 0 && InitializedBlockCount > 0, "Decrementing begin iterator!");
+			const size_t last = (std::min)(before, InitializedBlockCount) - 1;
+			size_t word = last / BITS_PER_WORD;
+			BitmapWord bits = Occupancy[word] & (~BitmapWord(0) >> (BITS_PER_WORD - 1 - last % BITS_PER_WORD));
+			while (bits == 0)
+			{
+				HEAVY_ASSERTE(word > 0, "Decrementing begin iterator!");
+				bits = Occupancy[--word];
+			}
+			return word * BITS_PER_WORD + FindLastSetBit(bits);
+		}
+
+	protected:
+		typedef uint64_t BitmapWord;
+		static constexpr size_t BITS_PER_WORD = 64;
+
+		IterablePoolAllocatorBase(size_t count, size_t cellSize, bool useHugePages)
+			: Capacity(count), CellSize(cellSize), FreeBlockCount(count), Memory(cellSize * count, useHugePages)
+		{
+			ASSERTE(count > 0, "Cell count cannot be lower than 1.");
+			RawData = Memory.GetData();
+			const size_t wordCount = (Capacity + BITS_PER_WORD - 1) / BITS_PER_WORD;
+			Occupancy = reinterpret_cast<BitmapWord*>(DefaultAlloc(sizeof(BitmapWord) * wordCount));
+			memset(Occupancy, 0, sizeof(BitmapWord) * wordCount);
+		}
+
+		// Returns index of the first free cell, used for types too small to hold free list links. Cells before FreeHint are all occupied
+		// and cells past InitializedBlockCount are never occupied, so the scan stops at InitializedBlockCount at the latest.
+		size_t FindFreeCell() const
+		{
+			HEAVY_ASSERTE(FreeBlockCount > 0, "Allocator is full!");
+			size_t word = FreeHint / BITS_PER_WORD;
+			while (Occupancy[word] == ~BitmapWord(0))
+				++word;
+			return word * BITS_PER_WORD + FindFirstSetBit(~Occupancy[word]);
+		}
+
+		bool IsOccupied(size_t i) const { return (Occupancy[i / BITS_PER_WORD] >> (i % BITS_PER_WORD)) & 1; }
+		void SetOccupied(size_t i) { Occupancy[i / BITS_PER_WORD] |= BitmapWord(1) << (i % BITS_PER_WORD); }
+		void ResetOccupied(size_t i) { Occupancy[i / BITS_PER_WORD] &= ~(BitmapWord(1) << (i % BITS_PER_WORD)); }
+
+		const size_t Capacity = 0;
+		const size_t CellSize = 0;
+		size_t FreeBlockCount = 0;
+		size_t InitializedBlockCount = 0;
+		size_t FreeHint = 0;
+		// cells are committed when they are initialized
+		VirtualMemoryRange Memory;
+		uint8_t* RawData = nullptr;
+		BitmapWord* Occupancy = nullptr;
 	};
 
-	/// <summary>Fast pool allocator, that enables iteration.</summary>
+	/// <summary>Fast pool allocator, that enables iteration.
+	/// Free cells form an intrusive free list, so allocation and freeing are O(1). Cells of types smaller than size_t cannot hold
+	/// the list, they are packed without padding and allocation takes the first free cell found in the occupancy bitmap instead.
+	/// Address space for all objects is reserved up front and committed on first use, so addresses of allocated objects never change.</summary>
 	template<typename T>
 	class IterablePoolAllocator : public IterablePoolAllocatorBase
 	{
-		struct Cell
-		{
-			char Data[sizeof(T)];
-			Cell* Prev = nullptr;
-			Cell* Next = nullptr;
-		};
-
-		STATIC_ASSERTE(sizeof(T) >= sizeof(size_t), "Type size is too small for allocator");
-		STATIC_ASSERTE(offsetof(Cell, Data) == 0, "Data has to be the first member of Cell struct. It must have no offset.");
 	public:
 		//------------------------------------------------------------------------------
 		class Iterator : public BaseObject<>, public std::iterator<std::bidirectional_iterator_tag, T>
 		{
 		public:
-			bool operator==(const Iterator& rhs) const { return CurrentCell == rhs.CurrentCell; }
+			Iterator() = default;
+
+			bool operator==(const Iterator& rhs) const { return Index == rhs.Index && Allocator == rhs.Allocator; }
 			bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
 
-			T& operator*() const { return *reinterpret_cast<T*>(CurrentCell->Data); }
-			T* operator->() const { return reinterpret_cast<T*>(CurrentCell->Data); }
+			T& operator*() const { return *Allocator->AddrFromIndex(Index); }
+			T* operator->() const { return Allocator->AddrFromIndex(Index); }
 
-			Iterator& operator++() { CurrentCell = CurrentCell->Next; return *this; }
-			Iterator operator++(int) { Iterator ret(CurrentCell); CurrentCell = CurrentCell->Next; return ret; }
-			Iterator& operator--() { CurrentCell = CurrentCell->Prev; return *this; }
-			Iterator operator--(int) { Iterator ret(CurrentCell); CurrentCell = CurrentCell->Prev; return ret; }
+			Iterator& operator++() { Index = Allocator->NextOccupied(Index + 1); return *this; }
+			Iterator operator++(int) { Iterator ret(Allocator, Index); ++(*this); return ret; }
+			Iterator& operator--() { Index = Allocator->PrevOccupied(Index); return *this; }
+			Iterator operator--(int) { Iterator ret(Allocator, Index); --(*this); return ret; }
 
 		private:
-			explicit Iterator(Cell* cell) : CurrentCell(cell) {}
+			Iterator(IterablePoolAllocator* allocator, size_t index) : Allocator(allocator), Index(index) {}
 
-			Cell* CurrentCell = nullptr;
+			IterablePoolAllocator* Allocator = nullptr;
+			size_t Index = 0;
 			friend class IterablePoolAllocator;
 		};
 
@@ -51,178 +153,113 @@ namespace Poly {
 		class ConstIterator : public BaseObject<>, public std::iterator<std::bidirectional_iterator_tag, T>
 		{
 		public:
-			bool operator==(const ConstIterator& rhs) const { return CurrentCell == rhs.CurrentCell; }
+			bool operator==(const ConstIterator& rhs) const { return Index == rhs.Index && Allocator == rhs.Allocator; }
 			bool operator!=(const ConstIterator& rhs) const { return !(*this == rhs); }
 
-			const T& operator*() const { return *reinterpret_cast<T*>(CurrentCell->Data); }
-			const T* operator->() const { return reinterpret_cast<T*>(CurrentCell->Data); }
+			const T& operator*() const { return *Allocator->AddrFromIndex(Index); }
+			const T* operator->() const { return Allocator->AddrFromIndex(Index); }
 
-			ConstIterator& operator++() { CurrentCell = CurrentCell->Next; return *this; }
-			ConstIterator operator++(int) { ConstIterator ret(CurrentCell); CurrentCell = CurrentCell->Next; return ret; }
-			ConstIterator& operator--() { CurrentCell = CurrentCell->Prev; return *this; }
-			ConstIterator operator--(int) { ConstIterator ret(CurrentCell); CurrentCell = CurrentCell->Prev; return ret; }
+			ConstIterator& operator++() { Index = Allocator->NextOccupied(Index + 1); return *this; }
+			ConstIterator operator++(int) { ConstIterator ret(Allocator, Index); ++(*this); return ret; }
+			ConstIterator& operator--() { Index = Allocator->PrevOccupied(Index); return *this; }
+			ConstIterator operator--(int) { ConstIterator ret(Allocator, Index); --(*this); return ret; }
 
 		private:
-			explicit ConstIterator(Cell* cell) : CurrentCell(cell) {}
+			ConstIterator(const IterablePoolAllocator* allocator, size_t index) : Allocator(allocator), Index(index) {}
 
-			Cell* CurrentCell = nullptr;
+			const IterablePoolAllocator* Allocator = nullptr;
+			size_t Index = 0;
 			friend class IterablePoolAllocator;
 		};
 
 		//------------------------------------------------------------------------------
-		Iterator Begin() { return Iterator(Head); }
-		Iterator End() { return Iterator(Tail); }
-		ConstIterator Begin() const { return ConstIterator(Head); }
-		ConstIterator End() const { return ConstIterator(Tail); }
+		Iterator Begin() { return Iterator(this, NextOccupied(0)); }
+		Iterator End() { return Iterator(this, Capacity); }
+		ConstIterator Begin() const { return ConstIterator(this, NextOccupied(0)); }
+		ConstIterator End() const { return ConstIterator(this, Capacity); }
 
-		/// <summary>Constuctor that allocates memory for provided amount of objects. </summary>
+		/// <summary>Constuctor that reserves memory for provided amount of objects. </summary>
 		/// <param name="count"></param>
-		explicit IterablePoolAllocator(size_t count)
-			: Capacity(count), FreeBlockCount(count)
-		{
-			ASSERTE(count > 0, "Cell count cannot be lower than 1.");
-			Data = reinterpret_cast<Cell*>(DefaultAlloc(sizeof(Cell) * (Capacity + 1)));
-			NextFree = Data;
-			Head = Tail = Data + Capacity; // Head and tail point to the last element from pool which is reserved for linked list.
-			Head->Next = nullptr; // Reset next and prev pointers
-			Tail->Prev = nullptr;
-			NextFree->Next = nullptr;
-			NextFree->Prev = nullptr;
-		}
-
-		//------------------------------------------------------------------------------
-		virtual ~IterablePoolAllocator()
+		/// <param name="useHugePages">Whether committed memory should be backed by huge pages when possible.</param>
+		explicit IterablePoolAllocator(size_t count, bool useHugePages = false)
+			: IterablePoolAllocatorBase(count, sizeof(T), useHugePages)
 		{
-			ASSERTE(Data, "Allocator is invalid");
-			DefaultFree(Data);
-			Data = nullptr;
+			NextFree = AddrFromIndex(0);
 		}
 
 		/// <summary>Allocation method</summary>
 		/// <returns>Pointer to uninitialized memory for object of type T.</returns>
 		T* Alloc()
 		{
-			// initialize new block
-			if (InitializedBlockCount < Capacity)
-			{
-				size_t* p = reinterpret_cast<size_t*>(AddrFromIndex(InitializedBlockCount));
-				*p = ++InitializedBlockCount;
-			}
-
-			// find first suitable place for data
-			if (FreeBlockCount > 0)
-			{
-				Cell* ret = NextFree;
-
-				// setup linked list
-				if (Tail->Prev != nullptr) { // list is not empty
-					if (ret > Head) {
-
-						Cell* prev = Head;
-						while (prev->Next && prev->Next < ret)
-							prev = prev->Next;
-
-						//Cell* prev = ret - 1;
-						HEAVY_ASSERTE(prev->Next != nullptr, "prev is null");
-						
-						ret->Prev = prev;
-						ret->Next = prev->Next;
-						prev->Next->Prev = ret;
-						prev->Next = ret;
-					}
-					else // Corner case when we're placing new element at first position
-					{
-						ret->Prev = nullptr;
-						ret->Next = Head;
-						Head->Prev = ret;
-						Head = ret;
-					}
-				}
-				else // list is empty
-				{
-					ret->Prev = nullptr;
-					ret->Next = Tail;
-					Tail->Prev = ret;
-					Head = ret;
-				}
-
-				// Update the Next node value.
-				--FreeBlockCount;
-				if (FreeBlockCount != 0)
-				{
-					NextFree = AddrFromIndex(*reinterpret_cast<size_t*>(NextFree));
-					NextFree->Next = nullptr;
-					NextFree->Prev = nullptr;
-				}
-				else
-				{
-					NextFree = nullptr;
-				}
-
-				return reinterpret_cast<T*>(ret->Data);
-			}
-			return nullptr;
+			if (FreeBlockCount == 0)
+				return nullptr;
+			return Alloc(std::integral_constant<bool, USE_FREE_LIST>());
 		}
 
 		//------------------------------------------------------------------------------
+		void* AllocCell() override { return Alloc(); }
 		void Free(void* p) override { Free(reinterpret_cast<T*>(p)); }
 
 		/// <summary>Method for freeing allocated memory. Allocator does not call any object destructors!</summary>
 		/// <param name="p">Pointer to memory to free.</param>
 		void Free(T* p)
 		{
-			// get cell addr
-			Cell* cell = reinterpret_cast<Cell*>(p);
+			const size_t idx = IndexFromAddr(p);
+			HEAVY_ASSERTE(idx < Capacity && IsOccupied(idx), "Freeing cell that was not allocated by this allocator!");
+			ResetOccupied(idx);
+			Free(p, idx, std::integral_constant<bool, USE_FREE_LIST>());
+			++FreeBlockCount;
+		}
 
-			// keep the linked list valid
-			if (Head == cell)
+	private:
+		static constexpr bool USE_FREE_LIST = sizeof(T) >= sizeof(size_t);
+
+		T* Alloc(std::true_type)
+		{
+			// initialize new block
+			if (InitializedBlockCount < Capacity)
 			{
-				Head = cell->Next;
-				Head->Prev = nullptr;
+				Memory.Commit((InitializedBlockCount + 1) * sizeof(T));
+				size_t* p = reinterpret_cast<size_t*>(AddrFromIndex(InitializedBlockCount));
+				*p = ++InitializedBlockCount;
 			}
+
+			T* ret = NextFree;
+			--FreeBlockCount;
+			if (FreeBlockCount != 0)
+				NextFree = AddrFromIndex(*reinterpret_cast<size_t*>(NextFree));
 			else
-			{
-				Cell* prev = cell->Prev;
-				prev->Next = cell->Next;
-				cell->Next->Prev = prev;
-			}
+				NextFree = nullptr;
 
-			cell->Next = nullptr;
-			cell->Prev = nullptr;
+			const size_t idx = IndexFromAddr(ret);
+			HEAVY_ASSERTE(!IsOccupied(idx), "Allocating already occupied cell!");
+			SetOccupied(idx);
+			return ret;
+		}
 
-			// Calculate the value of Next
-			if (NextFree != nullptr)
-			{
-				*reinterpret_cast<size_t*>(p) = IndexFromAddr(NextFree);
-				NextFree = cell;
-				NextFree->Next = nullptr;
-				NextFree->Prev = nullptr;
-			}
-			else
-			{
-				*reinterpret_cast<size_t*>(p) = Capacity;
-				NextFree = cell;
-				NextFree->Next = nullptr;
-				NextFree->Prev = nullptr;
-			}
-			++FreeBlockCount;
+		T* Alloc(std::false_type)
+		{
+			const size_t idx = FindFreeCell();
+			if (idx == InitializedBlockCount)
+				Memory.Commit(++InitializedBlockCount * sizeof(T));
+			--FreeBlockCount;
+			FreeHint = idx + 1;
+			SetOccupied(idx);
+			return AddrFromIndex(idx);
 		}
 
-		/// <summary>Gets current size of the allocator.</summary>
-		/// <returns>Count of allocated objects.</returns>
-		size_t GetSize() const { return Capacity - FreeBlockCount; }
+		void Free(T* p, size_t, std::true_type)
+		{
+			*reinterpret_cast<size_t*>(p) = NextFree != nullptr ? IndexFromAddr(NextFree) : Capacity;
+			NextFree = p;
+		}
 
-	private:
-		Cell* AddrFromIndex(size_t i) const { return Data + i; }
-		size_t IndexFromAddr(const Cell* p) const { return p - Data; }
+		void Free(T*, size_t idx, std::false_type) { FreeHint = (std::min)(FreeHint, idx); }
 
-		const size_t Capacity = 0;
-		size_t FreeBlockCount = 0;
-		size_t InitializedBlockCount = 0;
-		Cell* Data = nullptr;
-		Cell* NextFree = nullptr;
-		Cell* Head = nullptr;
-		Cell* Tail = nullptr;
+		T* AddrFromIndex(size_t i) const { return reinterpret_cast<T*>(RawData) + i; }
+		size_t IndexFromAddr(const T* p) const { return p - reinterpret_cast<const T*>(RawData); }
+
+		T* NextFree = nullptr;
 	};
 
 	// std library for each enablers
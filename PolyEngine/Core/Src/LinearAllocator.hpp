@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Defines.hpp"
+#include "Allocator.hpp"
+#include "Dynarray.hpp"
+
+namespace Poly {
+
+	/// <summary>Arena allocator that hands out memory by bumping a pointer inside fixed size blocks.
+	/// Single allocations can not be freed, Reset() releases everything at once and keeps the blocks for reuse,
+	/// so after warm up allocations never reach the system allocator.</summary>
+	class LinearAllocator : public BaseObject<>
+	{
+	public:
+		/// <param name="blockSize">Size of a single memory block in bytes. Bigger allocations get dedicated blocks.</param>
+		explicit LinearAllocator(size_t blockSize = 64 * 1024)
+			: BlockSize(blockSize)
+		{
+			ASSERTE(blockSize > 0, "Block size cannot be 0.");
+		}
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+		~LinearAllocator()
+		{
+			for (Block& block : Blocks)
+				DefaultFree(block.Data);
+		}
+
+		/// <summary>Allocates uninitialized memory. Returned address stays valid until Reset().</summary>
+		/// <param name="size">Size of memory in bytes.</param>
+		/// <param name="alignment">Required alignment, power of two not bigger than 16.</param>
+		void* Alloc(size_t size, size_t alignment)
+		{
+			HEAVY_ASSERTE(alignment > 0 && alignment <= 16 && (alignment & (alignment - 1)) == 0, "Unsupported alignment!");
+			while (CurrentBlock < Blocks.GetSize())
+			{
+				Block& block = Blocks[CurrentBlock];
+				const size_t offset = (block.Used + alignment - 1) & ~(alignment - 1);
+				if (offset + size <= block.Size)
+				{
+					block.Used = offset + size;
+					return block.Data + offset;
+				}
+				++CurrentBlock;
+			}
+
+			// blocks are allocated with default alignment, which is at least 16
+			Block block;
+			block.Size = std::max(size, BlockSize);
+			block.Data = static_cast<uint8_t*>(DefaultAlloc(block.Size));
+			block.Used = size;
+			Blocks.PushBack(block);
+			CurrentBlock = Blocks.GetSize() - 1;
+			return block.Data;
+		}
+
+		/// <summary>Releases all allocations. Allocator does not call any object destructors!</summary>
+		void Reset()
+		{
+			for (Block& block : Blocks)
+				block.Used = 0;
+			CurrentBlock = 0;
+		}
+
+		/// <summary>Returns count of bytes owned by the allocator, used or not.</summary>
+		size_t GetReservedSize() const
+		{
+			size_t size = 0;
+			for (const Block& block : Blocks)
+				size += block.Size;
+			return size;
+		}
+
+	private:
+		struct Block
+		{
+			uint8_t* Data = nullptr;
+			size_t Size = 0;
+			size_t Used = 0;
+		};
+
+		const size_t BlockSize;
+		Dynarray<Block> Blocks;
+		size_t CurrentBlock = 0;
+	};
+}
@@ -2,32 +2,30 @@
 
 #include "Defines.hpp"
 #include "Allocator.hpp"
+#include "VirtualMemory.hpp"
 
 
 namespace Poly {
-	/// <summary>Fast pool allocator, based on: https://www.thinkmind.org/download.php?articleid=computation_tools_2012_1_10_80006 </summary>
+	/// <summary>Fast pool allocator, based on: https://www.thinkmind.org/download.php?articleid=computation_tools_2012_1_10_80006
+	/// Address space for all objects is reserved up front, memory is committed when cells are used for the first time.
+	/// Free cells hold index of the next free cell, so cells of types smaller than size_t are padded to its size.</summary>
 	template<typename T>
 	class PoolAllocator : public BaseObject<>
 	{
-		STATIC_ASSERTE(sizeof(T) >= sizeof(size_t), "Pool allocator is invalid for types that are smaller than size_t");
 	public:
-		/// <summary>Constuctor that allocates memory for provided amount of objects. </summary>
+		/// <summary>Constuctor that reserves memory for provided amount of objects. </summary>
 		/// <param name="count"></param>
-		explicit PoolAllocator(size_t count)
-			: Capacity(count), FreeBlockCount(count)
+		/// <param name="useHugePages">Whether committed memory should be backed by huge pages when possible.</param>
+		explicit PoolAllocator(size_t count, bool useHugePages = false)
+			: Capacity(count), FreeBlockCount(count), Memory(CELL_SIZE * count, useHugePages)
 		{
 			ASSERTE(count > 0, "Cell count cannot be lower than 1.");
-			Data = reinterpret_cast<T*>(DefaultAlloc(sizeof(T) * Capacity));
-			Next = Data;
+			Data = Memory.GetData();
+			Next = AddrFromIndex(0);
 		}
 
 		//------------------------------------------------------------------------------
-		virtual ~PoolAllocator()
-		{
-			ASSERTE(Data, "Allocator is invalid");
-			DefaultFree(Data);
-			Data = nullptr;
-		}
+		virtual ~PoolAllocator() = default;
 
 		/// <summary>Allocation method</summary>
 		/// <returns>Pointer to uninitialized memory for object of type T.</returns>
@@ -35,6 +33,7 @@ namespace Poly {
 		{
 			if (InitializedBlockCount < Capacity)
 			{
+				Memory.Commit((InitializedBlockCount + 1) * CELL_SIZE);
 				size_t* p = reinterpret_cast<size_t*>(AddrFromIndex(InitializedBlockCount));
 				*p = ++InitializedBlockCount;
 			}
@@ -76,14 +75,20 @@ namespace Poly {
 		/// <summary>Gets current size of the allocator.</summary>
 		/// <returns>Count of allocated objects.</returns>
 		size_t GetSize() const { return Capacity - FreeBlockCount; }
+
+		/// <summary>Returns count of bytes committed for cells.</summary>
+		size_t GetMemoryUsage() const { return Memory.GetCommittedSize(); }
 	private:
-		T* AddrFromIndex(size_t i) const { return Data + i; }
-		size_t IndexFromAddr(const T* p) const { return p - Data; }
+		static constexpr size_t CELL_SIZE = sizeof(T) >= sizeof(size_t) ? sizeof(T) : sizeof(size_t);
+
+		T* AddrFromIndex(size_t i) const { return reinterpret_cast<T*>(Data + i * CELL_SIZE); }
+		size_t IndexFromAddr(const T* p) const { return (reinterpret_cast<const uint8_t*>(p) - Data) / CELL_SIZE; }
 
 		const size_t Capacity = 0;
 		size_t FreeBlockCount = 0;
 		size_t InitializedBlockCount = 0;
-		T* Data = nullptr;
+		VirtualMemoryRange Memory;
+		uint8_t* Data = nullptr;
 		T* Next = nullptr;
 	};
 }
\ No newline at end of file
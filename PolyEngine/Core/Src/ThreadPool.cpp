@@ -0,0 +1,115 @@
+#include "CorePCH.hpp"
+
+#include "ThreadPool.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	// Set for threads that currently execute tasks of any pool, nested batches run serially on them.
+	thread_local bool gInsideTask = false;
+	// One-based index of the worker in its pool, 0 for threads that are not workers.
+	thread_local size_t gWorkerIndex = 0;
+}
+
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool(size_t workerCount)
+	: NextTask(0)
+{
+	Workers.Resize(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+		Workers[i] = std::thread(&ThreadPool::WorkerLoop, this, i + 1);
+}
+
+//------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Stopping = true;
+	}
+	BatchStarted.notify_all();
+	for (std::thread& worker : Workers)
+		worker.join();
+}
+
+//------------------------------------------------------------------------------
+size_t ThreadPool::GetDefaultWorkerCount()
+{
+	const size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::Run(size_t taskCount, const TaskFunction& task)
+{
+	if (taskCount == 0)
+		return;
+
+	if (gInsideTask || Workers.GetSize() == 0 || taskCount == 1)
+	{
+		for (size_t i = 0; i < taskCount; ++i)
+			task(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runLock(RunMutex);
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Task = &task;
+		TaskCount = taskCount;
+		NextTask.store(0, std::memory_order_relaxed);
+		ActiveWorkers = Workers.GetSize();
+		++BatchGeneration;
+	}
+	BatchStarted.notify_all();
+
+	ExecuteTasks();
+
+	// task reference has to stay valid until every worker left the batch
+	std::unique_lock<std::mutex> lock(Mutex);
+	BatchFinished.wait(lock, [this] { return ActiveWorkers == 0; });
+	Task = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::WorkerLoop(size_t workerIndex)
+{
+	gWorkerIndex = workerIndex;
+	size_t seenGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			BatchStarted.wait(lock, [this, seenGeneration] { return Stopping || BatchGeneration != seenGeneration; });
+			if (Stopping)
+				return;
+			seenGeneration = BatchGeneration;
+		}
+
+		ExecuteTasks();
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			last = --ActiveWorkers == 0;
+		}
+		if (last)
+			BatchFinished.notify_one();
+	}
+}
+
+//------------------------------------------------------------------------------
+size_t ThreadPool::GetCurrentThreadIndex()
+{
+	return gWorkerIndex;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::ExecuteTasks()
+{
+	gInsideTask = true;
+	for (size_t i = NextTask.fetch_add(1, std::memory_order_relaxed); i < TaskCount; i = NextTask.fetch_add(1, std::memory_order_relaxed))
+		(*Task)(i);
+	gInsideTask = false;
+}
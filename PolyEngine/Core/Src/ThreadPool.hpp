@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "Defines.hpp"
+#include "Dynarray.hpp"
+
+namespace Poly
+{
+	/// <summary>Fixed set of worker threads that execute batches of tasks.
+	/// Calling thread takes part in the execution of every batch, so pool with no workers runs everything serially.</summary>
+	class CORE_DLLEXPORT ThreadPool : public BaseObject<>
+	{
+	public:
+		/// <summary>Task of a batch. Receives index of the task in the batch.</summary>
+		typedef std::function<void(size_t)> TaskFunction;
+
+		/// <summary>Starts worker threads.</summary>
+		/// <param name="workerCount">Number of threads started in addition to the calling one.</param>
+		explicit ThreadPool(size_t workerCount);
+
+		/// <summary>Stops and joins worker threads.</summary>
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// <summary>Executes task for every index in [0, taskCount) and returns when all of them finished.
+		/// Calls made from inside of a task are executed serially on the calling thread.</summary>
+		/// <param name="taskCount">Number of task invocations.</param>
+		/// <param name="task">Function invoked with index of the task. It can be invoked concurrently.</param>
+		void Run(size_t taskCount, const TaskFunction& task);
+
+		/// <summary>Returns number of worker threads, not counting the calling one.</summary>
+		size_t GetWorkerCount() const { return Workers.GetSize(); }
+
+		/// <summary>Returns number of threads available for the hardware minus one for the calling thread.</summary>
+		static size_t GetDefaultWorkerCount();
+
+		/// <summary>Returns index of the calling thread: 0 for threads that are not pool workers (including the ones that call Run()),
+		/// otherwise index of the worker in its pool plus one. Useful for selecting per-thread data of size GetWorkerCount() + 1.</summary>
+		static size_t GetCurrentThreadIndex();
+
+	private:
+		void WorkerLoop(size_t workerIndex);
+		void ExecuteTasks();
+
+		Dynarray<std::thread> Workers;
+
+		// Serializes Run() calls made from different threads
+		std::mutex RunMutex;
+
+		// State of the current batch, guarded by Mutex unless atomic
+		std::mutex Mutex;
+		std::condition_variable BatchStarted;
+		std::condition_variable BatchFinished;
+		const TaskFunction* Task = nullptr;
+		size_t TaskCount = 0;
+		size_t BatchGeneration = 0;
+		size_t ActiveWorkers = 0;
+		std::atomic<size_t> NextTask;
+		bool Stopping = false;
+	};
+}
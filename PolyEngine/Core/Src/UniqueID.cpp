@@ -2,10 +2,12 @@
 
 #include "UniqueID.hpp"
 
+#include <atomic>
+
 using namespace Poly;
 
 UniqueID::UniqueID() {}
-UniqueID UniqueID::Generate() { static size_t val = 0; return UniqueID(++val); }
+UniqueID UniqueID::Generate() { static std::atomic<size_t> val(0); return UniqueID(++val); }
 
 bool UniqueID::operator==(const UniqueID& rhs) const { return ID == rhs.ID; }
 bool UniqueID::operator!=(const UniqueID& rhs) const { return !(*this == rhs); }
@@ -0,0 +1,99 @@
+#include "CorePCH.hpp"
+
+#include "VirtualMemory.hpp"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+using namespace Poly;
+
+namespace
+{
+	// Committing tiny pieces would need a system call for every page
+	constexpr size_t MIN_COMMIT_GRANULARITY = 64 * 1024;
+	constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	size_t GetPageSize()
+	{
+#if defined(_WIN32)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	size_t AlignUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+}
+
+//------------------------------------------------------------------------------
+VirtualMemoryRange::VirtualMemoryRange(size_t size, bool useHugePages)
+	: CommittedSize(0)
+{
+	ASSERTE(size > 0, "Reserved size cannot be 0.");
+#if defined(_WIN32)
+	UNUSED(useHugePages);
+	CommitGranularity = AlignUp(MIN_COMMIT_GRANULARITY, GetPageSize());
+	ReservedSize = AlignUp(size, CommitGranularity);
+	MappingSize = ReservedSize;
+	Mapping = VirtualAlloc(nullptr, MappingSize, MEM_RESERVE, PAGE_NOACCESS);
+	ASSERTE(Mapping, "Reserving address space failed!");
+	Data = static_cast<uint8_t*>(Mapping);
+#else
+	CommitGranularity = AlignUp(useHugePages ? HUGE_PAGE_SIZE : MIN_COMMIT_GRANULARITY, GetPageSize());
+	ReservedSize = AlignUp(size, CommitGranularity);
+	// huge pages need aligned address, so reserve more and skip the unaligned beginning
+	MappingSize = useHugePages ? ReservedSize + HUGE_PAGE_SIZE : ReservedSize;
+	Mapping = mmap(nullptr, MappingSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	ASSERTE(Mapping != MAP_FAILED, "Reserving address space failed!");
+	Data = static_cast<uint8_t*>(Mapping);
+	if (useHugePages)
+	{
+		Data = reinterpret_cast<uint8_t*>(AlignUp(reinterpret_cast<size_t>(Mapping), HUGE_PAGE_SIZE));
+	#if defined(MADV_HUGEPAGE)
+		madvise(Data, ReservedSize, MADV_HUGEPAGE);
+	#endif
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+VirtualMemoryRange::~VirtualMemoryRange()
+{
+	ASSERTE(Mapping, "Memory range is invalid");
+#if defined(_WIN32)
+	VirtualFree(Mapping, 0, MEM_RELEASE);
+#else
+	munmap(Mapping, MappingSize);
+#endif
+	Mapping = nullptr;
+	Data = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void VirtualMemoryRange::CommitSlow(size_t size)
+{
+	ASSERTE(size <= ReservedSize, "Committing more memory than was reserved!");
+	std::lock_guard<std::mutex> lock(CommitMutex);
+	const size_t committed = CommittedSize.load(std::memory_order_relaxed);
+	if (size <= committed)
+		return;
+
+	// grow geometrically, so the count of commits is logarithmic in the used size
+	const size_t newSize = std::min(ReservedSize, AlignUp(std::max(size, committed * 2), CommitGranularity));
+#if defined(_WIN32)
+	const bool success = VirtualAlloc(Data + committed, newSize - committed, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	const bool success = mprotect(Data + committed, newSize - committed, PROT_READ | PROT_WRITE) == 0;
+#endif
+	ASSERTE(success, "Committing memory failed!");
+	UNUSED(success);
+	CommittedSize.store(newSize, std::memory_order_release);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "Defines.hpp"
+
+namespace Poly
+{
+	/// <summary>Contiguous range of reserved address space. Physical memory is committed on demand from the beginning of the range,
+	/// so big ranges cost nothing until they are used. Addresses never change, committed memory is zero initialized.</summary>
+	/// <para>Huge pages are a hint: on Linux the range is aligned to 2MB and advised for transparent huge pages,
+	/// on other platforms it is ignored as large pages can not be committed incrementally there.</para>
+	class CORE_DLLEXPORT VirtualMemoryRange : public BaseObject<>
+	{
+	public:
+		/// <param name="size">Size of reserved address space in bytes.</param>
+		/// <param name="useHugePages">Whether committed memory should be backed by huge pages when possible.</param>
+		explicit VirtualMemoryRange(size_t size, bool useHugePages = false);
+		~VirtualMemoryRange();
+
+		VirtualMemoryRange(const VirtualMemoryRange&) = delete;
+		VirtualMemoryRange& operator=(const VirtualMemoryRange&) = delete;
+
+		uint8_t* GetData() const { return Data; }
+		size_t GetReservedSize() const { return ReservedSize; }
+		size_t GetCommittedSize() const { return CommittedSize.load(std::memory_order_acquire); }
+
+		/// <summary>Makes sure that at least first size bytes are committed. Can be called from many threads at once.</summary>
+		void Commit(size_t size)
+		{
+			if (size > CommittedSize.load(std::memory_order_acquire))
+				CommitSlow(size);
+		}
+
+		/// <summary>Returns granularity of commits, memory is always committed in multiples of it.</summary>
+		size_t GetCommitGranularity() const { return CommitGranularity; }
+
+	private:
+		void CommitSlow(size_t size);
+
+		uint8_t* Data = nullptr;
+		void* Mapping = nullptr;
+		size_t MappingSize = 0;
+		size_t ReservedSize = 0;
+		size_t CommitGranularity = 0;
+		std::atomic<size_t> CommittedSize;
+		std::mutex CommitMutex;
+	};
+}
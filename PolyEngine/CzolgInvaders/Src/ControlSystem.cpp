@@ -63,7 +63,7 @@ void ControlSystem::ControlSystemPhase(World* world)
 		
 	}
 	
-	for (auto componentTuple : world->IterateComponents<Invaders::TankComponent, TransformComponent>())
+	for (auto componentTuple : world->Query<With<Invaders::TankComponent, TransformComponent>>())
 	{
 		TransformComponent* transform = std::get<TransformComponent*>(componentTuple);
 		Invaders::TankComponent* tank = std::get<Invaders::TankComponent*>(componentTuple);
@@ -80,7 +80,7 @@ void ControlSystem::ControlSystemPhase(World* world)
 
 	}
 
-	for (auto componentTuple : world->IterateComponents<BulletComponent, TransformComponent>())
+	for (auto componentTuple : world->Query<With<BulletComponent, TransformComponent>>())
 	{
 		BulletComponent* bullet = std::get<BulletComponent*>(componentTuple);
 		TransformComponent* transform = std::get<TransformComponent*>(componentTuple);
@@ -94,8 +94,8 @@ void ControlSystem::ControlSystemPhase(World* world)
 		}
 		else
 		{
-			if (!gameManager->GetDeadGameEntities()->Contains(bullet->GetOwnerID()))
-				gameManager->GetDeadGameEntities()->PushBack(bullet->GetOwnerID());
+			if (!bullet->GetSibling<DeadEntityTag>())
+				DeferredTaskSystem::AddComponent<DeadEntityTag>(world, bullet->GetOwnerID());
 		}
 	}
 
@@ -138,11 +138,9 @@ void ControlSystem::SpawnBullet(GameManagerComponent* gameManager, World* world,
 	transform->SetLocalTranslation(pos);
 	gConsole.LogInfo("Spawning Bullet!");
 }
-void ControlSystem::CleanUpEnitites(GameManagerComponent* gameManager, World* world)
+void ControlSystem::CleanUpEnitites(GameManagerComponent* /*gameManager*/, World* world)
 {
-	for (Poly::UniqueID ent : *(gameManager->GetDeadGameEntities()))
-	{
-		DeferredTaskSystem::DestroyEntity(world, ent);
-	}
-	gameManager->GetDeadGameEntities()->Clear();	
+	auto dead = world->Query<With<DeadEntityTag>>();
+	for (auto it = dead.Begin(); it != dead.End(); ++it)
+		DeferredTaskSystem::DestroyEntity(world, it.GetEntityID());
 }
\ No newline at end of file
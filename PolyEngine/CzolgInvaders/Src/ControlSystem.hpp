@@ -24,7 +24,7 @@ namespace Poly
 		void SpawnBullet(GameManagerComponent* gameManager, World* world, Vector pos, Vector direction, float speed);
 		void CleanUpEnitites(GameManagerComponent* gameManager, World* world);
 		bool CheckCollision(const AABox& rect1, const AABox& rect2);
-		void CheckBulletCollisions(World* world, GameManagerComponent* gameManager, const UniqueID other);
+		void CheckBulletCollisions(World* world, GameManagerComponent* gameManager, const EntityID other);
 	}
 }
 	
@@ -9,15 +9,15 @@ namespace Poly {
 	{
 
 	public:
-		EnemyMovementComponent(AABox collision, UniqueID& turret, float movementSpeed = 2.0f);
+		EnemyMovementComponent(AABox collision, EntityID& turret, float movementSpeed = 2.0f);
 
 		float GetMovementSpeed() const { return MovementSpeed; }
 		AABox& GetCollisionBox() { return CollisionBox; }
-		UniqueID GetTurret() { return Turret; }
+		EntityID GetTurret() { return Turret; }
 
 	private:
 		float MovementSpeed = 2.0f;
 		AABox CollisionBox;
-		UniqueID Turret;
+		EntityID Turret;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "GameManagerComponent.hpp"
 
-Poly::GameManagerComponent::GameManagerComponent(const Poly::UniqueID& counter) :
+Poly::GameManagerComponent::GameManagerComponent(const Poly::EntityID& counter) :
 	KillCounter(counter)
 {
 
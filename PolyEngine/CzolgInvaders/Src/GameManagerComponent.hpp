@@ -1,28 +1,27 @@
 #pragma once
 
 #include "ComponentBase.hpp"
-#include <Dynarray.hpp>
-#include <vector>
 
 namespace Poly {
 
+	/// <summary>Tag of game entities that are destroyed at the end of the control phase.</summary>
+	struct DeadEntityTag {};
+
 	class GAME_DLLEXPORT GameManagerComponent : public ComponentBase
 	{
 		
 	public:
 
-		GameManagerComponent(const Poly::UniqueID& counter);
-		Poly::Dynarray<Poly::UniqueID>* GetDeadGameEntities() { return &DeadGameEntities; }
+		GameManagerComponent(const Poly::EntityID& counter);
 		Poly::eKey const GetQuitKey() { return QuitKey; }
 		size_t GetKillCount() { return KillCount; }
-		Poly::UniqueID& GetKillCounter() { return KillCounter; }
+		Poly::EntityID& GetKillCounter() { return KillCounter; }
 
 		void SetKillCount(size_t count) { KillCount = count; }
 
 	private:
-		Poly::Dynarray<Poly::UniqueID> DeadGameEntities;
 		Poly::eKey QuitKey = Poly::eKey::ESCAPE;
 		size_t KillCount = 0;
-		Poly::UniqueID KillCounter;
+		Poly::EntityID KillCounter;
 	};
 }
@@ -10,6 +10,8 @@
 #include <DeferredTaskSystem.hpp>
 #include <ViewportWorldComponent.hpp>
 #include <ResourceManager.hpp>
+#include <SystemScheduler.hpp>
+#include <TimeWorldComponent.hpp>
 
 #include "GameManagerSystem.hpp"
 #include "MovementComponent.hpp"
@@ -31,6 +33,7 @@ void InvadersGame::Init()
 	Engine->RegisterComponent<Invaders::MovementSystem::MovementComponent>((int)eGameComponents::MOVEMENT);
 	Engine->RegisterComponent<Invaders::CollisionSystem::CollisionComponent>((int)eGameComponents::COLLISION);
 	Engine->RegisterComponent<Invaders::TankComponent>((int)eGameComponents::TANK);
+	Engine->RegisterComponent<DeadEntityTag>((int)eGameComponents::DEAD);
 	
 	Camera = DeferredTaskSystem::SpawnEntityImmediate(Engine->GetWorld());
 	DeferredTaskSystem::AddComponentImmediate<Poly::TransformComponent>(Engine->GetWorld(), Camera);
@@ -84,8 +87,10 @@ void InvadersGame::Init()
 	entTransform->SetLocalRotation(Quaternion(Vector::UNIT_Y, -90_deg) * Quaternion(Vector::UNIT_X, -90_deg));
 	
 	Engine->GetWorld()->GetWorldComponent<ViewportWorldComponent>()->SetCamera(0, Engine->GetWorld()->GetComponent<Poly::CameraComponent>(Camera));
-	Engine->RegisterGameUpdatePhase(Invaders::MovementSystem::MovementUpdatePhase);
-	Engine->RegisterGameUpdatePhase(Invaders::CollisionSystem::CollisionUpdatePhase);
+	Engine->RegisterGameUpdatePhase(Invaders::MovementSystem::MovementUpdatePhase,
+		SystemAccess().ReadWorld<TimeWorldComponent>().Write<Invaders::MovementSystem::MovementComponent, TransformComponent>());
+	Engine->RegisterGameUpdatePhase(Invaders::CollisionSystem::CollisionUpdatePhase,
+		SystemAccess().Write<Invaders::CollisionSystem::CollisionComponent, TransformComponent>());
 	Engine->RegisterGameUpdatePhase(GameMainSystem::GameUpdate);
 	Engine->RegisterGameUpdatePhase(ControlSystem::ControlSystemPhase);
 	Engine->RegisterGameUpdatePhase(GameManagerSystem::GameManagerSystemPhase);
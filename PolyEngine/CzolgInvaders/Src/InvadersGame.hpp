@@ -28,7 +28,8 @@ enum class eGameComponents
 	ENEMYMOVEMENT,
 	MOVEMENT,
 	COLLISION,
-	TANK
+	TANK,
+	DEAD
 };
 
 DECLARE_GAME()
@@ -40,10 +41,10 @@ class GAME_DLLEXPORT InvadersGame : public Poly::IGame {
 	void Deinit() override;
 
 private:
-	Poly::UniqueID Camera;
-	Poly::UniqueID GameManager;
+	Poly::EntityID Camera;
+	Poly::EntityID GameManager;
 
-	Poly::Dynarray<Poly::UniqueID> GameEntities;
+	Poly::Dynarray<Poly::EntityID> GameEntities;
 	Poly::Engine* Engine;
 	Poly::MeshResource* BulletMesh;
 };
\ No newline at end of file
@@ -13,14 +13,14 @@ namespace Invaders
 		class MovementComponent : public Poly::ComponentBase
 		{
 		friend void MovementUpdatePhase(Poly::World*);
-		friend void SetLinearVelocity(Poly::World*, const Poly::UniqueID&, const Poly::Vector&);
-		friend const Poly::Vector& GetLinearVelocity(Poly::World*, Poly::UniqueID);
-		friend void SetLinearAcceleration(Poly::World*, const Poly::UniqueID&, const Poly::Vector&);
-		friend const Poly::Vector& GetLinearAcceleration(Poly::World*, Poly::UniqueID);
-		friend void SetAngularVelocity(Poly::World*, const Poly::UniqueID&, const Poly::Quaternion&);
-		friend const Poly::Quaternion& GetAngularVelocity(Poly::World*, Poly::UniqueID);
-		friend void SetAngularAcceleration(Poly::World*, const Poly::UniqueID&, const Poly::Quaternion&);
-		friend const Poly::Quaternion& GetAngularAcceleration(Poly::World*, Poly::UniqueID);
+		friend void SetLinearVelocity(Poly::World*, const Poly::EntityID&, const Poly::Vector&);
+		friend const Poly::Vector& GetLinearVelocity(Poly::World*, Poly::EntityID);
+		friend void SetLinearAcceleration(Poly::World*, const Poly::EntityID&, const Poly::Vector&);
+		friend const Poly::Vector& GetLinearAcceleration(Poly::World*, Poly::EntityID);
+		friend void SetAngularVelocity(Poly::World*, const Poly::EntityID&, const Poly::Quaternion&);
+		friend const Poly::Quaternion& GetAngularVelocity(Poly::World*, Poly::EntityID);
+		friend void SetAngularAcceleration(Poly::World*, const Poly::EntityID&, const Poly::Quaternion&);
+		friend const Poly::Quaternion& GetAngularAcceleration(Poly::World*, Poly::EntityID);
 		public:
 			MovementComponent(Poly::Vector linVel, Poly::Vector linAcc, Poly::Quaternion angVel, Poly::Quaternion angAcc) :
 				LinearVelocity(linVel),
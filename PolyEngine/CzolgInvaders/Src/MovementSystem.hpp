@@ -4,7 +4,7 @@ namespace Poly
 {
 	class Vector;
 	class Quaternion;
-	class UniqueID;
+	class EntityID;
 	class World;
 }	
 
@@ -14,14 +14,14 @@ namespace Invaders
 	{
 		void MovementUpdatePhase(Poly::World*);
 
-		void SetLinearVelocity(Poly::World*, const Poly::UniqueID&, const Poly::Vector&);
-		const Poly::Vector& GetLinearVelocity(Poly::World*, Poly::UniqueID);
-		void SetLinearAcceleration(Poly::World*, const Poly::UniqueID&, const Poly::Vector&);
-		const Poly::Vector& GetLinearAcceleration(Poly::World*, Poly::UniqueID);
+		void SetLinearVelocity(Poly::World*, const Poly::EntityID&, const Poly::Vector&);
+		const Poly::Vector& GetLinearVelocity(Poly::World*, Poly::EntityID);
+		void SetLinearAcceleration(Poly::World*, const Poly::EntityID&, const Poly::Vector&);
+		const Poly::Vector& GetLinearAcceleration(Poly::World*, Poly::EntityID);
 
-		void SetAngularVelocity(Poly::World*, const Poly::UniqueID&, const Poly::Quaternion&);
-		const Poly::Quaternion& GetAngularVelocity(Poly::World*, Poly::UniqueID);
-		void SetAngularAcceleration(Poly::World*, const Poly::UniqueID&, const Poly::Quaternion&);
-		const Poly::Quaternion& GetAngularAcceleration(Poly::World*, Poly::UniqueID);
+		void SetAngularVelocity(Poly::World*, const Poly::EntityID&, const Poly::Quaternion&);
+		const Poly::Quaternion& GetAngularVelocity(Poly::World*, Poly::EntityID);
+		void SetAngularAcceleration(Poly::World*, const Poly::EntityID&, const Poly::Quaternion&);
+		const Poly::Quaternion& GetAngularAcceleration(Poly::World*, Poly::EntityID);
 	}
 }
\ No newline at end of file
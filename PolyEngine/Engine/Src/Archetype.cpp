@@ -0,0 +1,97 @@
+#include "EnginePCH.hpp"
+
+#include "Archetype.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	size_t AlignUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+}
+
+//------------------------------------------------------------------------------
+Archetype::Archetype(const ComponentSignature& signature, const Dynarray<ComponentTypeInfo>& types)
+	: Signature(signature), Types(types)
+{
+	HEAVY_ASSERTE(Signature.count() == Types.GetSize(), "Signature does not match provided component types!");
+	memset(AddEdges, 0, sizeof(Archetype*) * MAX_COMPONENTS_COUNT);
+	memset(RemoveEdges, 0, sizeof(Archetype*) * MAX_COMPONENTS_COUNT);
+	for (size_t i = 0; i < MAX_COMPONENTS_COUNT; ++i)
+		ColumnIndices[i] = -1;
+
+	// Entity column is always first, component columns follow. Every column needs up to (alignment - 1) bytes of padding.
+	size_t rowSize = sizeof(Entity*);
+	size_t padding = 0;
+	for (size_t i = 0; i < Types.GetSize(); ++i)
+	{
+		HEAVY_ASSERTE(Signature[Types[i].ID], "Component type not present in signature!");
+		ColumnIndices[Types[i].ID] = static_cast<int>(i);
+		rowSize += Types[i].Size;
+		padding += Types[i].Alignment - 1;
+	}
+	ChunkCapacity = CHUNK_SIZE > padding + rowSize ? (CHUNK_SIZE - padding) / rowSize : 1;
+
+	size_t offset = sizeof(Entity*) * ChunkCapacity;
+	ColumnOffsets.Reserve(Types.GetSize());
+	for (size_t i = 0; i < Types.GetSize(); ++i)
+	{
+		offset = AlignUp(offset, Types[i].Alignment);
+		ColumnOffsets.PushBack(offset);
+		offset += Types[i].Size * ChunkCapacity;
+	}
+	ChunkVersionOffset = AlignUp(offset, alignof(std::atomic<uint32_t>));
+	ChunkByteSize = ChunkVersionOffset + sizeof(std::atomic<uint32_t>);
+}
+
+//------------------------------------------------------------------------------
+Archetype::~Archetype()
+{
+	while (Size > 0)
+		RemoveRow(Size - 1, true);
+	HEAVY_ASSERTE(Chunks.IsEmpty(), "Chunks were not released!");
+}
+
+//------------------------------------------------------------------------------
+size_t Archetype::AddRow(Entity* entity)
+{
+	if (Size == Chunks.GetSize() * ChunkCapacity)
+	{
+		Chunks.PushBack(static_cast<uint8_t*>(DefaultAlloc(ChunkByteSize)));
+		::new(&GetChunkVersion(Chunks.GetSize() - 1)) std::atomic<uint32_t>(0);
+	}
+
+	const size_t row = Size++;
+	reinterpret_cast<Entity**>(Chunks[row / ChunkCapacity])[row % ChunkCapacity] = entity;
+	return row;
+}
+
+//------------------------------------------------------------------------------
+Entity* Archetype::RemoveRow(size_t row, bool destroyComponents)
+{
+	HEAVY_ASSERTE(row < Size, "Row out of bounds!");
+
+	if (destroyComponents)
+		for (size_t i = 0; i < Types.GetSize(); ++i)
+			Types[i].Destroy(GetColumnData(i, row));
+
+	const size_t last = Size - 1;
+	Entity* moved = nullptr;
+	if (row != last)
+	{
+		for (size_t i = 0; i < Types.GetSize(); ++i)
+			Types[i].Relocate(GetColumnData(i, row), GetColumnData(i, last));
+		moved = GetEntity(last);
+		// moved components keep their versions, so the chunk they land in must not look older
+		MarkChunkChanged(row, GetChunkChangeVersion(last));
+		reinterpret_cast<Entity**>(Chunks[row / ChunkCapacity])[row % ChunkCapacity] = moved;
+	}
+	--Size;
+
+	// release trailing chunk once it becomes empty
+	if (Size == (Chunks.GetSize() - 1) * ChunkCapacity)
+	{
+		DefaultFree(Chunks[Chunks.GetSize() - 1]);
+		Chunks.PopBack();
+	}
+	return moved;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <Core.hpp>
+#include <atomic>
+#include <bitset>
+
+#include "ComponentBase.hpp"
+
+namespace Poly
+{
+	/// <summary>Layout used by a world to store its components.</summary>
+	/// <see cref="Archetype"/>
+	enum class eComponentStorage
+	{
+		POOL,		// each component type lives in its own pool, component addresses never change
+		ARCHETYPE,	// entities with equal component sets share chunks, components are moved on structural changes
+		_COUNT
+	};
+
+	struct ComponentTypeInfo;
+
+	namespace Impl
+	{
+		typedef void (*CopyRangeFunction)(void* dst, const void* src, size_t count);
+
+		template<typename T>
+		CopyRangeFunction GetCopyConstructRange(std::true_type)
+		{
+			return [](void* dst, const void* src, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+					::new(static_cast<T*>(dst) + i) T(static_cast<const T*>(src)[i]);
+			};
+		}
+		template<typename T>
+		CopyRangeFunction GetCopyConstructRange(std::false_type) { return nullptr; }
+
+		template<typename T>
+		CopyRangeFunction GetCopyAssignRange(std::true_type)
+		{
+			return [](void* dst, const void* src, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+					static_cast<T*>(dst)[i] = static_cast<const T*>(src)[i];
+			};
+		}
+		template<typename T>
+		CopyRangeFunction GetCopyAssignRange(std::false_type) { return nullptr; }
+
+		template<typename T>
+		ComponentTypeInfo CreateComponentTypeInfo(size_t id, std::false_type);
+		template<typename T>
+		ComponentTypeInfo CreateComponentTypeInfo(size_t id, std::true_type);
+	}
+
+	/// <summary>Type erased description of a component type.
+	/// Used by storages that have to move or destroy components without knowing their static type.</summary>
+	struct ENGINE_DLLEXPORT ComponentTypeInfo : public BaseObjectLiteralType<>
+	{
+		size_t ID = 0;
+		eComponentKind Kind = eComponentKind::REGULAR;
+		/// Zero for tags, they take no space in archetype chunks and have no pools.
+		size_t Size = 0;
+		size_t Alignment = 0;
+		/// Move-constructs component at dst from the one at src, then destroys the one at src.
+		void (*Relocate)(void* dst, void* src) = nullptr;
+		void (*Destroy)(void* ptr) = nullptr;
+		/// Creates pool allocator for components of this type, used by pool storage.
+		IterablePoolAllocatorBase* (*CreatePool)(size_t count, bool useHugePages) = nullptr;
+		/// Copy-constructs count components at dst from the ones at src, null for types that cannot be copied.
+		void (*CopyConstructRange)(void* dst, const void* src, size_t count) = nullptr;
+		/// Copy-assigns count components at src to the ones at dst, null for types that cannot be copied.
+		void (*CopyAssignRange)(void* dst, const void* src, size_t count) = nullptr;
+
+		template<typename T>
+		static ComponentTypeInfo Create(size_t id)
+		{
+			return Impl::CreateComponentTypeInfo<T>(id, std::integral_constant<bool, Impl::ComponentTraits<T>::Kind == eComponentKind::TAG>());
+		}
+	};
+
+	namespace Impl
+	{
+		template<typename T>
+		ComponentTypeInfo CreateComponentTypeInfo(size_t id, std::false_type)
+		{
+			STATIC_ASSERTE(alignof(T) <= 16, "Components with alignment greater than 16 are not supported by archetype storage.");
+			ComponentTypeInfo info;
+			info.ID = id;
+			info.Kind = ComponentTraits<T>::Kind;
+			info.Size = sizeof(T);
+			info.Alignment = alignof(T);
+			info.Relocate = [](void* dst, void* src)
+			{
+				T* srcObj = static_cast<T*>(src);
+				ObjectLifetimeHelper::MoveCreate(static_cast<T*>(dst), std::move(*srcObj));
+				ObjectLifetimeHelper::Destroy(srcObj);
+			};
+			info.Destroy = [](void* ptr) { ObjectLifetimeHelper::Destroy(static_cast<T*>(ptr)); };
+			info.CreatePool = [](size_t count, bool useHugePages) -> IterablePoolAllocatorBase* { return new IterablePoolAllocator<T>(count, useHugePages); };
+			info.CopyConstructRange = GetCopyConstructRange<T>(std::is_copy_constructible<T>());
+			info.CopyAssignRange = GetCopyAssignRange<T>(std::is_copy_assignable<T>());
+			return info;
+		}
+
+		// Tags have no state, so there is nothing to move, copy or destroy
+		template<typename T>
+		ComponentTypeInfo CreateComponentTypeInfo(size_t id, std::true_type)
+		{
+			ComponentTypeInfo info;
+			info.ID = id;
+			info.Kind = eComponentKind::TAG;
+			info.Size = 0;
+			info.Alignment = 1;
+			info.Relocate = [](void*, void*) {};
+			info.Destroy = [](void*) {};
+			info.CopyConstructRange = [](void*, const void*, size_t) {};
+			info.CopyAssignRange = [](void*, const void*, size_t) {};
+			return info;
+		}
+	}
+
+	/// <summary>Archetype stores all entities that own exactly the same set of components.
+	/// Rows are kept in fixed-size chunks. Inside a chunk every component type has its own contiguous column,
+	/// so iterating over components of an archetype is a linear walk over arrays.
+	/// Rows are kept dense: removing a row moves the last row into its place.</summary>
+	class ENGINE_DLLEXPORT Archetype : public BaseObject<>
+	{
+	public:
+		/// <summary>Preferred size of a single chunk in bytes.</summary>
+		static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+		/// <param name="signature">Set of component IDs stored in this archetype.</param>
+		/// <param name="types">Type info for every component in signature.</param>
+		Archetype(const ComponentSignature& signature, const Dynarray<ComponentTypeInfo>& types);
+		~Archetype();
+
+		const ComponentSignature& GetSignature() const { return Signature; }
+		const Dynarray<ComponentTypeInfo>& GetComponentTypes() const { return Types; }
+		bool HasComponent(size_t componentID) const { return Signature[componentID]; }
+
+		/// <summary>Returns count of rows (entities) stored in this archetype.</summary>
+		size_t GetSize() const { return Size; }
+
+		/// <summary>Returns count of rows that fit in a single chunk.</summary>
+		size_t GetChunkCapacity() const { return ChunkCapacity; }
+
+		/// <summary>Returns count of bytes allocated for chunks.</summary>
+		size_t GetMemoryUsage() const { return Chunks.GetSize() * ChunkByteSize; }
+
+		/// <summary>Appends new row for given entity. Components of this row are left uninitialized.</summary>
+		/// <returns>Index of the new row.</returns>
+		size_t AddRow(Entity* entity);
+
+		/// <summary>Removes a row. The last row is relocated into the freed place to keep rows dense.</summary>
+		/// <param name="row">Row to remove.</param>
+		/// <param name="destroyComponents">If false components of removed row are assumed to be already destroyed or relocated.</param>
+		/// <returns>Entity that was moved into the removed row or nullptr if no relocation took place.</returns>
+		Entity* RemoveRow(size_t row, bool destroyComponents);
+
+		/// <summary>Returns pointer to a component in given row or nullptr if this archetype does not store given component.</summary>
+		void* GetComponent(size_t componentID, size_t row) const
+		{
+			HEAVY_ASSERTE(row < Size, "Row out of bounds!");
+			const int column = ColumnIndices[componentID];
+			if (column < 0)
+				return nullptr;
+			return GetColumnData(static_cast<size_t>(column), row);
+		}
+
+		/// <summary>Returns the greatest change version of components in the chunk of given row. Components of the chunk
+		/// were not changed after that version.</summary>
+		/// <see cref="ComponentBase.MarkChanged()"/>
+		uint32_t GetChunkChangeVersion(size_t row) const
+		{
+			HEAVY_ASSERTE(row < Size, "Row out of bounds!");
+			return GetChunkVersion(row / ChunkCapacity).load(std::memory_order_relaxed);
+		}
+
+		/// <summary>Raises change version of the chunk of given row. Can be called from many threads at once.</summary>
+		void MarkChunkChanged(size_t row, uint32_t version)
+		{
+			HEAVY_ASSERTE(row < Size, "Row out of bounds!");
+			std::atomic<uint32_t>& chunkVersion = GetChunkVersion(row / ChunkCapacity);
+			uint32_t current = chunkVersion.load(std::memory_order_relaxed);
+			while (current < version && !chunkVersion.compare_exchange_weak(current, version, std::memory_order_relaxed)) {}
+		}
+
+		/// <summary>Returns the entity stored in given row.</summary>
+		Entity* GetEntity(size_t row) const
+		{
+			HEAVY_ASSERTE(row < Size, "Row out of bounds!");
+			return reinterpret_cast<Entity**>(Chunks[row / ChunkCapacity])[row % ChunkCapacity];
+		}
+
+		/// <summary>Cached transitions to archetypes that differ from this one by a single component.</summary>
+		Archetype* GetAddEdge(size_t componentID) const { return AddEdges[componentID]; }
+		Archetype* GetRemoveEdge(size_t componentID) const { return RemoveEdges[componentID]; }
+		void SetAddEdge(size_t componentID, Archetype* archetype) { AddEdges[componentID] = archetype; }
+		void SetRemoveEdge(size_t componentID, Archetype* archetype) { RemoveEdges[componentID] = archetype; }
+
+	private:
+		std::atomic<uint32_t>& GetChunkVersion(size_t chunk) const { return *reinterpret_cast<std::atomic<uint32_t>*>(Chunks[chunk] + ChunkVersionOffset); }
+
+		void* GetColumnData(size_t column, size_t row) const
+		{
+			return Chunks[row / ChunkCapacity] + ColumnOffsets[column] + (row % ChunkCapacity) * Types[column].Size;
+		}
+
+		ComponentSignature Signature;
+		Dynarray<ComponentTypeInfo> Types;
+		Dynarray<size_t> ColumnOffsets;
+		int ColumnIndices[MAX_COMPONENTS_COUNT];
+
+		Dynarray<uint8_t*> Chunks;
+		size_t ChunkCapacity = 0;
+		size_t ChunkByteSize = 0;
+		// Change version of the chunk is stored after the last column
+		size_t ChunkVersionOffset = 0;
+		size_t Size = 0;
+
+		Archetype* AddEdges[MAX_COMPONENTS_COUNT];
+		Archetype* RemoveEdges[MAX_COMPONENTS_COUNT];
+	};
+
+	/// <summary>Position of a row inside a list of archetypes. Archetypes that do not store given component are skipped.
+	/// Used to iterate over all components of a given type in archetype storage.</summary>
+	class ENGINE_DLLEXPORT ArchetypeCursor : public BaseObjectLiteralType<>
+	{
+	public:
+		ArchetypeCursor() = default;
+		ArchetypeCursor(const Dynarray<Archetype*>* archetypes, size_t componentID, size_t archetypeIdx)
+			: Archetypes(archetypes), ComponentID(componentID), ArchetypeIdx(archetypeIdx) { SkipForward(); }
+
+		bool operator==(const ArchetypeCursor& rhs) const { return Archetypes == rhs.Archetypes && ArchetypeIdx == rhs.ArchetypeIdx && Row == rhs.Row; }
+		bool operator!=(const ArchetypeCursor& rhs) const { return !(*this == rhs); }
+
+		Archetype* GetArchetype() const { return (*Archetypes)[ArchetypeIdx]; }
+		size_t GetRow() const { return Row; }
+
+		void Next() { ++Row; SkipForward(); }
+		void Prev()
+		{
+			if (Row > 0)
+			{
+				--Row;
+				return;
+			}
+			do { --ArchetypeIdx; } while (!IsUsable(ArchetypeIdx));
+			Row = GetArchetype()->GetSize() - 1;
+		}
+
+	private:
+		bool IsUsable(size_t idx) const { return (*Archetypes)[idx]->HasComponent(ComponentID) && (*Archetypes)[idx]->GetSize() > 0; }
+		void SkipForward()
+		{
+			while (ArchetypeIdx < Archetypes->GetSize() && (Row >= (*Archetypes)[ArchetypeIdx]->GetSize() || !(*Archetypes)[ArchetypeIdx]->HasComponent(ComponentID)))
+			{
+				++ArchetypeIdx;
+				Row = 0;
+			}
+		}
+
+		const Dynarray<Archetype*>* Archetypes = nullptr;
+		size_t ComponentID = 0;
+		size_t ArchetypeIdx = 0;
+		size_t Row = 0;
+	};
+}
@@ -8,16 +8,18 @@ namespace Poly {
 	class ENGINE_DLLEXPORT CameraComponent : public ComponentBase
 	{
 		friend void CameraSystem::CameraUpdatePhase(World*);
+		friend void CameraSystem::OnCamerasAdded(World*, const Dynarray<CameraComponent*>&);
+		friend class WorldSerializer;
 	public:
 		CameraComponent(Angle fov, float zNear, float zFar);
 		CameraComponent(float top, float bottom, float left, float right, float zNear, float zFar);
 
 		const Matrix& GetProjectionMatrix() const { return Projection; }
-		const Matrix& GetModelViewMatrix() const { return ModelView; }
+		const AffineMatrix& GetModelViewMatrix() const { return ModelView; }
 		const Matrix& GetMVP() const { return MVP; }
 	private:
 		Matrix Projection;
-		Matrix ModelView;
+		AffineMatrix ModelView;
 		Matrix MVP;
 
 		bool IsPerspective = false;
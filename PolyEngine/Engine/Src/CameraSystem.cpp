@@ -2,6 +2,13 @@
 
 #include "CameraSystem.hpp"
 
+void Poly::CameraSystem::OnCamerasAdded(World* /*world*/, const Dynarray<CameraComponent*>& cameras)
+{
+	// aspect of a camera is known only once it is rendered in a viewport, invalid one forces projection update
+	for (CameraComponent* camera : cameras)
+		camera->Aspect = 0.f;
+}
+
 void Poly::CameraSystem::CameraUpdatePhase(World* world)
 {
 	ScreenSize screen = gEngine->GetRenderingDevice()->GetScreenSize();
@@ -16,7 +23,7 @@ void Poly::CameraSystem::CameraUpdatePhase(World* world)
 		if (transformCmp)
 		{
 			// reinit perspective
-			if (cameraCmp->CheckFlags(eComponentBaseFlags::NEWLY_CREATED) || cameraCmp->Aspect != aspect)
+			if (cameraCmp->Aspect != aspect)
 			{
 				cameraCmp->Aspect = aspect;
 				if (cameraCmp->IsPerspective)
@@ -25,7 +32,7 @@ void Poly::CameraSystem::CameraUpdatePhase(World* world)
 					cameraCmp->Projection.SetOrthographic(cameraCmp->Top, cameraCmp->Bottom, cameraCmp->Left, cameraCmp->Right, cameraCmp->Near, cameraCmp->Far);
 			}
 
-			cameraCmp->ModelView = transformCmp->GetGlobalTransformationMatrix().GetInversed();
+			cameraCmp->ModelView = transformCmp->GetGlobalTransformation().GetInversed();
 			cameraCmp->MVP = cameraCmp->Projection * cameraCmp->ModelView;
 		}
 		else
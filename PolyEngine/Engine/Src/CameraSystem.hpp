@@ -1,11 +1,17 @@
 #pragma once
 
+#include <Dynarray.hpp>
+
 namespace Poly
 {
 	class World;
+	class CameraComponent;
 
 	namespace CameraSystem
 	{
 		void CameraUpdatePhase(World* world);
+
+		/// <summary>Observer of new cameras, makes CameraUpdatePhase() initialize their projection.</summary>
+		void OnCamerasAdded(World* world, const Dynarray<CameraComponent*>& cameras);
 	}
 }
\ No newline at end of file
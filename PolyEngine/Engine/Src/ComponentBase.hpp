@@ -8,7 +8,6 @@ namespace Poly {
 	enum class eComponentBaseFlags
 	{
 		NONE = 0x00,
-		NEWLY_CREATED = 0x01,
 		ABOUT_TO_BE_REMOVED = 0x02
 	};
 
@@ -16,9 +15,11 @@ namespace Poly {
 	class ENGINE_DLLEXPORT ComponentBase : public BaseObject<>
 	{
 	friend class World;
+	friend class WorldSnapshot;
+	friend class QueryCursor;
 	public:
 		
-		/// <summary>Getter for a component of a specified type that shares UniqueID with this one.</summary>
+		/// <summary>Getter for a component of a specified type that shares EntityID with this one.</summary>
 		/// <returns>Pointer to a component of a specified type or a nullptr, if it does not exist.</returns>
 		template<typename T>
 		T* GetSibling()
@@ -27,7 +28,7 @@ namespace Poly {
 			return Owner->GetComponent<T>();
 		}
 
-		UniqueID GetOwnerID() const
+		EntityID GetOwnerID() const
 		{
 			HEAVY_ASSERTE(Owner, "Component was not properly initialized.");
 			return Owner->GetID();
@@ -38,9 +39,61 @@ namespace Poly {
 		const EnumFlags<eComponentBaseFlags>& GetFlags() { return Flags; }
 		bool CheckFlags(const EnumFlags<eComponentBaseFlags>& rhs) const { return (Flags & rhs) == rhs; }
 
+		/// <summary>Stamps the component with current change version of its world, so queries with Changed filter visit it.
+		/// Has to be called after modifying the component, unless its setters already do it. Adding a component marks it as well.</summary>
+		/// <see cref="World.GetChangeVersion()"/>
+		void MarkChanged();
+
+		/// <summary>Returns world change version from the last modification of this component.</summary>
+		uint32_t GetChangeVersion() const { return ChangeVersion; }
+
+	protected:
+		/// <summary>Returns world of the owner, nullptr if the component was not added to any world yet.</summary>
+		World* GetWorld() const { return Owner ? Owner->GetWorld() : nullptr; }
+
 	private:
 		Entity* Owner = nullptr;
 
 		EnumFlags<eComponentBaseFlags> Flags;
+		uint32_t ChangeVersion = 0;
 	};
+
+	/// <summary>Way a component type is stored, derived from the type itself.</summary>
+	/// <para>Components do not have to derive from ComponentBase. Plain components are small trivially copyable structs stored without
+	/// a vtable or owner, they can be accessed through entities and queries, but they are not change tracked. Tags are empty structs,
+	/// owning one is only a bit in the entity signature, so they are meant for With and Without filters of queries.</para>
+	enum class eComponentKind
+	{
+		REGULAR,	// derives from ComponentBase, knows its owner and change version
+		PLAIN,		// trivially copyable struct without owner and change version
+		TAG,		// empty struct without storage
+		_COUNT
+	};
+
+	namespace Impl
+	{
+		template<typename T>
+		struct ComponentTraits
+		{
+			static constexpr eComponentKind Kind = std::is_base_of<ComponentBase, T>::value ? eComponentKind::REGULAR
+				: (std::is_empty<T>::value ? eComponentKind::TAG : eComponentKind::PLAIN);
+			// components without ComponentBase are meant to be plain data, which can be stored and copied without any bookkeeping
+			static constexpr bool IsValid = Kind == eComponentKind::REGULAR || (std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value);
+		};
+		template<typename T>
+		constexpr eComponentKind ComponentTraits<T>::Kind;
+		template<typename T>
+		constexpr bool ComponentTraits<T>::IsValid;
+
+		// Entities keep plain components and tags behind ComponentBase pointers as well, they are only reinterpreted
+		template<typename T>
+		T* ComponentCast(ComponentBase* component, std::true_type) { return static_cast<T*>(component); }
+		template<typename T>
+		T* ComponentCast(ComponentBase* component, std::false_type) { return reinterpret_cast<T*>(component); }
+		template<typename T>
+		T* ComponentCast(ComponentBase* component) { return ComponentCast<T>(component, std::is_base_of<ComponentBase, T>()); }
+
+		inline ComponentBase* AsComponentBase(ComponentBase* component) { return component; }
+		inline ComponentBase* AsComponentBase(void* component) { return static_cast<ComponentBase*>(component); }
+	}
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <ThreadPool.hpp>
+
+#include "World.hpp"
+
 namespace Poly
 {
 	/// <summary>This is class where all core configuration variables are placed</summary>
@@ -11,6 +15,14 @@ namespace Poly
 		bool DebugNormalsFlag = false;
 		bool WireframeRendering = false;
 		bool DisplayFPS = true;
+
+		// ECS
+		eComponentStorage ComponentStorage = eComponentStorage::POOL;
+		size_t MaxEntityCount = DEFAULT_MAX_ENTITY_COUNT;
+		bool UseHugePages = false;
+
+		// Threading
+		size_t WorkerThreadCount = ThreadPool::GetDefaultWorkerCount();
 	};
 	ENGINE_DLLEXPORT extern CoreConfig gCoreConfig;
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "EnginePCH.hpp"
+
+#include "DeferredCommandBuffer.hpp"
+
+using namespace Poly;
+
+//------------------------------------------------------------------------------
+DeferredCommandBuffer::~DeferredCommandBuffer()
+{
+	DestroyCommands();
+}
+
+//------------------------------------------------------------------------------
+void DeferredCommandBuffer::ExecuteSpawns(World* w)
+{
+	for (const EntityID& entityId : Spawns)
+		w->SpawnEntity(entityId);
+	Spawns.Clear();
+}
+
+//------------------------------------------------------------------------------
+void DeferredCommandBuffer::ExecuteCommands(World* w)
+{
+	// commands can record new ones, so the array can grow during the loop
+	for (size_t i = 0; i < Commands.GetSize(); ++i)
+		Commands[i]->Execute(w);
+	DestroyCommands();
+}
+
+//------------------------------------------------------------------------------
+void DeferredCommandBuffer::DestroyCommands()
+{
+	for (DeferredTaskBase* command : Commands)
+		command->~DeferredTaskBase();
+	Commands.Clear();
+	Arena.Reset();
+}
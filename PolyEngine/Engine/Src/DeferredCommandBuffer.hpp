@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mutex>
+#include <Core.hpp>
+
+#include "DeferredTaskBase.hpp"
+#include "EntityID.hpp"
+
+namespace Poly
+{
+	class World;
+
+	/// <summary>Linear buffer of deferred world changes, normally recorded by a single thread.
+	/// Commands are constructed inline in an arena that is rewound after execution,
+	/// so recording does not allocate once the buffer has grown to the size of a typical frame.</summary>
+	class ENGINE_DLLEXPORT DeferredCommandBuffer : public BaseObject<>
+	{
+	public:
+		DeferredCommandBuffer() = default;
+		~DeferredCommandBuffer();
+
+		/// <summary>Records command of type T constructed from args.</summary>
+		template<typename T, typename... Args> void Record(Args&&... args)
+		{
+			STATIC_ASSERTE((std::is_base_of<DeferredTaskBase, T>::value), "Commands have to derive from DeferredTaskBase.");
+			std::lock_guard<std::mutex> lock(Mutex);
+			void* memory = Arena.Alloc(sizeof(T), alignof(T));
+			Commands.PushBack(::new(memory) T(std::forward<Args>(args)...));
+		}
+
+		/// <summary>Records spawn of entity with reserved ID.</summary>
+		void RecordSpawn(const EntityID& entityId)
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Spawns.PushBack(entityId);
+		}
+
+		bool IsEmpty() const { return Spawns.IsEmpty() && Commands.IsEmpty(); }
+
+		/// <summary>Spawns recorded entities.</summary>
+		void ExecuteSpawns(World* w);
+
+		/// <summary>Executes recorded commands in order of recording and rewinds the arena.
+		/// Commands recorded during execution are executed in the same call.</summary>
+		void ExecuteCommands(World* w);
+
+	private:
+		void DestroyCommands();
+
+		// Recording thread is almost always the only user, so the lock is not contended
+		std::mutex Mutex;
+		LinearAllocator Arena;
+		Dynarray<DeferredTaskBase*> Commands;
+		Dynarray<EntityID> Spawns;
+	};
+}
@@ -19,13 +19,13 @@ namespace Poly
 	class DestroyEntityDeferredTask : public DeferredTaskBase
 	{
 	public:
-		DestroyEntityDeferredTask(const UniqueID &entityID) : Id(entityID) {}
+		DestroyEntityDeferredTask(const EntityID &entityID) : Id(entityID) {}
 
 		virtual void Execute(World* w) { DeferredTaskSystem::DestroyEntityImmediate(w, Id); }
 
 		virtual const char* GetDescription() const { return "Destroy entity"; }
 	private:
-		const UniqueID Id;
+		const EntityID Id;
 	};
 
 	//---------------------------------------------------------------
@@ -33,7 +33,7 @@ namespace Poly
 	class AddComponentDeferredTask : public DeferredTaskBase
 	{
 	public:
-		AddComponentDeferredTask(const UniqueID &entityID, Args&&... args) : arguments(std::forward<Args>(args)...), Id(entityID) {}
+		AddComponentDeferredTask(const EntityID &entityID, Args&&... args) : arguments(std::forward<Args>(args)...), Id(entityID) {}
 
 		virtual void Execute(World* w) { func(w, arguments); }
 
@@ -42,7 +42,7 @@ namespace Poly
 		template <typename... ARG, std::size_t... Is> void func(World* w, std::tuple<ARG...>& tup, index<Is...>) { DeferredTaskSystem::AddComponentImmediate<T>(w, Id, std::get<Is>(tup)...); }
 		template <typename... ARG> void func(World* w, std::tuple<ARG...>& tup) { func(w, tup, gen_seq<sizeof...(ARG)>{}); }
 	private:
-		const UniqueID Id;
+		const EntityID Id;
 		std::tuple<Args...> arguments;
 	};
 
@@ -51,12 +51,12 @@ namespace Poly
 	class RemoveComponentDeferredTask : public DeferredTaskBase
 	{
 	public:
-		RemoveComponentDeferredTask(const UniqueID &entityID) : Id(entityID) {}
+		RemoveComponentDeferredTask(const EntityID &entityID) : Id(entityID) {}
 
 		virtual void Execute(World* w) { w->RemoveComponent<T>(Id); }
 
 		virtual const char* GetDescription() const { return "Remove component"; }
 	private:
-		const UniqueID Id;
+		const EntityID Id;
 	};
 }
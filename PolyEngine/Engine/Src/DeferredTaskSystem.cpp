@@ -4,45 +4,56 @@
 using namespace Poly;
 
 //------------------------------------------------------------------------------
-UniqueID DeferredTaskSystem::SpawnEntityImmediate(World* w)
+EntityID DeferredTaskSystem::SpawnEntityImmediate(World* w)
 {
 	return w->SpawnEntity();
 }
 
 //------------------------------------------------------------------------------
-void DeferredTaskSystem::DestroyEntityImmediate(World* w, const UniqueID& entityId)
+void DeferredTaskSystem::DestroyEntityImmediate(World* w, const EntityID& entityId)
 {
 	w->DestroyEntity(entityId);
 }
 
 //------------------------------------------------------------------------------
-void DeferredTaskSystem::DestroyEntity(World* w, const UniqueID& entityId)
+void DeferredTaskSystem::DestroyEntitiesImmediate(World* w, const Dynarray<EntityID>& entityIds)
+{
+	w->DestroyEntities(entityIds);
+}
+
+//------------------------------------------------------------------------------
+EntityID DeferredTaskSystem::SpawnEntity(World* w)
 {
 	DeferredTaskWorldComponent* cmp = w->GetWorldComponent<DeferredTaskWorldComponent>();
-	cmp->ScheduleTask(new DestroyEntityDeferredTask(entityId));
+	const EntityID id = w->ReserveEntityID();
+	cmp->ScheduleSpawn(id);
+	return id;
 }
 
 //------------------------------------------------------------------------------
-void DeferredTaskSystem::DeferredTaskPhase(World* w)
+void DeferredTaskSystem::DestroyEntity(World* w, const EntityID& entityId)
 {
 	DeferredTaskWorldComponent* cmp = w->GetWorldComponent<DeferredTaskWorldComponent>();
+	cmp->ScheduleTask<DestroyEntityDeferredTask>(entityId);
+}
 
-	// clear newly created flags after one tic.
-	for (ComponentBase* cmp : cmp->NewlyCreatedComponents)
-		cmp->ResetFlags(eComponentBaseFlags::NEWLY_CREATED);
-	cmp->NewlyCreatedComponents.Clear();
+//------------------------------------------------------------------------------
+void DeferredTaskSystem::DeferredTaskPhase(World* w)
+{
+	DeferredTaskWorldComponent* cmp = w->GetWorldComponent<DeferredTaskWorldComponent>();
 
-	// execute tasks from queue
-	while (!cmp->TasksQueue.IsEmpty())
+	// Spawns of all threads go first, so tasks recorded on one thread can refer to entities reserved on another.
+	// Tasks can schedule new ones, so repeat until every buffer is empty.
+	for (bool pending = true; pending;)
 	{
-		DeferredTaskBase *task = cmp->TasksQueue.Front();
-		ASSERTE(task, "The task doesn't exist!");
-
-		gConsole.LogDebug("Executing task: {}", task->GetDescription());
-		task->Execute(w);
-
-		cmp->TasksQueue.PopFront();
-		delete task;
+		for (size_t i = 0; i < cmp->BufferCount; ++i)
+			cmp->Buffers[i].ExecuteSpawns(w);
+		for (size_t i = 0; i < cmp->BufferCount; ++i)
+			cmp->Buffers[i].ExecuteCommands(w);
+
+		pending = false;
+		for (size_t i = 0; i < cmp->BufferCount; ++i)
+			pending |= !cmp->Buffers[i].IsEmpty();
 	}
 }
 
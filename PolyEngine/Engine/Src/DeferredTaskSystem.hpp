@@ -8,54 +8,80 @@ namespace Poly
 {
 	namespace DeferredTaskSystem
 	{
-		void DeferredTaskPhase(World* w);
+		void ENGINE_DLLEXPORT DeferredTaskPhase(World* w);
 
 		// NORMAL CALLS
+		/// <summary>Reserves entity ID immediately and spawns the entity after the end of frame.
+		/// Components can be added to returned ID with deferred AddComponent.</summary>
+		/// <param name="world">Pointer to world to create entity in.</summary>
+		/// <returns>ID of the entity that will be spawned.</returns>
+		EntityID ENGINE_DLLEXPORT SpawnEntity(World* world);
+
 		/// <summary>Destroys entity after the end of frame.</summary>
 		/// <param name="world">Pointer to world entity is in.</summary>
 		/// <param name="entityId">ID of the entity to be removed.</summary>
-		void ENGINE_DLLEXPORT DestroyEntity(World* world, const UniqueID& entityId);
+		void ENGINE_DLLEXPORT DestroyEntity(World* world, const EntityID& entityId);
 
 		/// <summary>Adds component to entity after the end of frame.</summary>
 		/// <param name="world">Pointer to world entity is in.</summary>
 		/// <param name="entityId">ID of the entity.</summary>
-		template<typename T, typename ...Args> void AddComponent(World* world, const UniqueID & entityId, Args && ...args)
+		template<typename T, typename ...Args> void AddComponent(World* world, const EntityID & entityId, Args && ...args)
 		{
 			DeferredTaskWorldComponent* cmp = world->GetWorldComponent<DeferredTaskWorldComponent>();
-			cmp->ScheduleTask(new AddComponentDeferredTask<T, typename std::conditional<!std::is_array<typename std::remove_reference<Args>::type>::value, Args, typename std::decay<Args>::type>::type...>(entityId, std::forward<Args>(args)...));
+			cmp->ScheduleTask<AddComponentDeferredTask<T, typename std::conditional<!std::is_array<typename std::remove_reference<Args>::type>::value, Args, typename std::decay<Args>::type>::type...>>(entityId, std::forward<Args>(args)...);
+		}
+
+		namespace Impl
+		{
+			// plain components and tags have no flags
+			inline void SetAboutToBeRemoved(ComponentBase* component) { component->SetFlags(eComponentBaseFlags::ABOUT_TO_BE_REMOVED); }
+			inline void SetAboutToBeRemoved(void*) {}
 		}
 
 		/// <summary>Removes component from entity after the end of frame.</summary>
 		/// <param name="world">Pointer to world entity is in.</summary>
 		/// <param name="entityId">ID of the entity.</summary>
-		template<typename T> void RemoveComponent(World* world, const UniqueID& entityId)
+		template<typename T> void RemoveComponent(World* world, const EntityID& entityId)
 		{
 			DeferredTaskWorldComponent* cmp = world->GetWorldComponent<DeferredTaskWorldComponent>();
-			world->GetComponent<T>(entityId)->SetFlags(eComponentBaseFlags::ABOUT_TO_BE_REMOVED);
-			cmp->ScheduleTask(new RemoveComponentDeferredTask<T>(entityId));
+			Impl::SetAboutToBeRemoved(world->GetComponent<T>(entityId));
+			cmp->ScheduleTask<RemoveComponentDeferredTask<T>>(entityId);
 		}
 
 		// IMMEDIATE CALLS
 		
 		/// <summary>Creates entity immediately.</summary>
 		/// <param name="world">Pointer to world to create entity in.</summary>
-		UniqueID ENGINE_DLLEXPORT SpawnEntityImmediate(World* w);
+		EntityID ENGINE_DLLEXPORT SpawnEntityImmediate(World* w);
 
 		/// <summary>Destroys entity immediately.</summary>
 		/// <param name="world">Pointer to world entity is in.</summary>
 		/// <param name="entityId">ID of the entity.</summary>
-		void ENGINE_DLLEXPORT DestroyEntityImmediate(World* w, const UniqueID& entityId);
+		void ENGINE_DLLEXPORT DestroyEntityImmediate(World* w, const EntityID& entityId);
+
+		/// <summary>Creates count entities with all Components immediately. Every component is constructed
+		/// from its own tuple of constructor arguments, the same for all entities.</summary>
+		/// <param name="world">Pointer to world to create entities in.</summary>
+		/// <param name="count">Number of entities to create.</summary>
+		/// <returns>IDs of created entities.</returns>
+		template<typename... Components, typename... ArgTuples> Dynarray<EntityID> SpawnEntitiesImmediate(World* w, size_t count, const ArgTuples&... args)
+		{
+			Dynarray<EntityID> ids;
+			w->SpawnEntities<Components...>(count, ids, args...);
+			return ids;
+		}
+
+		/// <summary>Destroys entities immediately.</summary>
+		/// <param name="world">Pointer to world entities are in.</summary>
+		/// <param name="entityIds">IDs of the entities, already destroyed ones are skipped.</summary>
+		void ENGINE_DLLEXPORT DestroyEntitiesImmediate(World* w, const Dynarray<EntityID>& entityIds);
 
 		/// <summary>Adds component to entity immediately.</summary>
 		/// <param name="world">Pointer to world entity is in.</summary>
 		/// <param name="entityId">ID of the entity.</summary>
-		template<typename T, typename ...Args> void AddComponentImmediate(World* w, const UniqueID & entityId, Args && ...args)
+		template<typename T, typename ...Args> void AddComponentImmediate(World* w, const EntityID & entityId, Args && ...args)
 		{
 			w->AddComponent<T>(entityId, std::forward<Args>(args)...);
-			DeferredTaskWorldComponent* cmp = w->GetWorldComponent<DeferredTaskWorldComponent>();
-			T* newCmp = w->GetComponent<T>(entityId);
-			cmp->NewlyCreatedComponents.PushBack(newCmp);
-			newCmp->SetFlags(eComponentBaseFlags::NEWLY_CREATED);
 		}
 
 		/// <summary>Adds world component to world.</summary>
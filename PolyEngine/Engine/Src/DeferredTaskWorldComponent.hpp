@@ -1,31 +1,41 @@
 #pragma once
 
-#include <Queue.hpp>
+#include <ThreadPool.hpp>
 
 #include "ComponentBase.hpp"
-#include "DeferredTaskBase.hpp"
+#include "DeferredCommandBuffer.hpp"
 
 namespace Poly
 {
 	namespace DeferredTaskSystem
 	{
 		void DeferredTaskPhase(World* w);
-		template<typename T, typename ...Args> void AddComponentImmediate(World* w, const UniqueID & entityId, Args && ...args);
 	}
 
 	class ENGINE_DLLEXPORT DeferredTaskWorldComponent : public ComponentBase
 	{
 		friend void DeferredTaskSystem::DeferredTaskPhase(World*);
-		template<typename T, typename ...Args> friend void DeferredTaskSystem::AddComponentImmediate(World* w, const UniqueID & entityId, Args && ...args);
 	public:
-		DeferredTaskWorldComponent() = default;
+		/// <param name="threadCount">Number of threads that record tasks, by default workers of the engine pool and the main thread.
+		/// Tasks recorded by threads with greater <see cref="ThreadPool.GetCurrentThreadIndex()"/> go to the buffer of the main thread.</param>
+		explicit DeferredTaskWorldComponent(size_t threadCount = gEngine && gEngine->GetThreadPool() ? gEngine->GetThreadPool()->GetWorkerCount() + 1 : 1)
+			: Buffers(new DeferredCommandBuffer[threadCount]), BufferCount(threadCount) {}
+
+		/// <summary>Records task of type T to be executed in DeferredTaskPhase. Can be called from many threads at once.</summary>
+		template<typename T, typename... Args> void ScheduleTask(Args&&... args) { GetCurrentBuffer().Record<T>(std::forward<Args>(args)...); }
+
+		/// <summary>Records spawn of entity with reserved ID. Spawns are executed before any other task.</summary>
+		void ScheduleSpawn(const EntityID& entityId) { GetCurrentBuffer().RecordSpawn(entityId); }
 
-		void ScheduleTask(DeferredTaskBase* task) {
-			TasksQueue.PushBack(task);
-			gConsole.LogDebug("New task scheduled: {}", task->GetDescription());
-		}
 	private:
-		Queue<DeferredTaskBase*> TasksQueue;
-		Dynarray<ComponentBase*> NewlyCreatedComponents;
+		DeferredCommandBuffer& GetCurrentBuffer()
+		{
+			const size_t index = ThreadPool::GetCurrentThreadIndex();
+			return Buffers[index < BufferCount ? index : 0];
+		}
+
+		// One buffer per recording thread, executed in order of thread indices so the result does not depend on timing
+		std::unique_ptr<DeferredCommandBuffer[]> Buffers;
+		size_t BufferCount;
 	};
-}
\ No newline at end of file
+}
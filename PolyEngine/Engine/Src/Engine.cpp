@@ -5,13 +5,21 @@ using namespace Poly;
 
 Engine* Poly::gEngine = nullptr;
 
+namespace
+{
+	size_t gRegistryGenerationCounter = 0;
+}
+
 //------------------------------------------------------------------------------
 Engine::Engine(std::unique_ptr<IGame> game, std::unique_ptr<IRenderingDevice> device) 
-	: Game(std::move(game)), RenderingDevice(std::move(device))
+	: WorldLoaded(false), MainThreadID(std::this_thread::get_id()), Game(std::move(game)), RenderingDevice(std::move(device)),
+	RegistryGeneration(++gRegistryGenerationCounter)
 {
 	ASSERTE(gEngine == nullptr, "Creating engine twice?");
 	gEngine = this;
-	BaseWorld = std::make_unique<World>();
+	Workers = std::make_unique<ThreadPool>(gCoreConfig.WorkerThreadCount);
+	for (auto& scheduler : GameUpdatePhases)
+		scheduler = std::make_unique<SystemScheduler>();
 	Game->RegisterEngine(this);
 
 	// Engine Components
@@ -28,18 +36,19 @@ Engine::Engine(std::unique_ptr<IGame> game, std::unique_ptr<IRenderingDevice> de
 	RegisterWorldComponent<DebugWorldComponent>((size_t)eEngineWorldComponents::DEBUG);
 	RegisterWorldComponent<DeferredTaskWorldComponent>((size_t)eEngineWorldComponents::DEFERRED_TASK);
 
-	// Add WorldComponents
-	DeferredTaskSystem::AddWorldComponentImmediate<InputWorldComponent>(BaseWorld.get());
-	DeferredTaskSystem::AddWorldComponentImmediate<ViewportWorldComponent>(BaseWorld.get());
-	DeferredTaskSystem::AddWorldComponentImmediate<TimeWorldComponent>(BaseWorld.get());
-	DeferredTaskSystem::AddWorldComponentImmediate<DebugWorldComponent>(BaseWorld.get());
-	DeferredTaskSystem::AddWorldComponentImmediate<DeferredTaskWorldComponent>(BaseWorld.get());
+	BaseWorld = CreateWorld();
 
 	// Engine update phases
-	RegisterUpdatePhase(TimeSystem::TimeUpdatePhase, eUpdatePhaseOrder::PREUPDATE);
-	RegisterUpdatePhase(InputSystem::InputPhase, eUpdatePhaseOrder::PREUPDATE);
-	RegisterUpdatePhase(MovementSystem::MovementUpdatePhase, eUpdatePhaseOrder::PREUPDATE);
-	RegisterUpdatePhase(CameraSystem::CameraUpdatePhase, eUpdatePhaseOrder::POSTUPDATE);
+	RegisterUpdatePhase(TimeSystem::TimeUpdatePhase, SystemAccess().WriteWorld<TimeWorldComponent>(), eUpdatePhaseOrder::PREUPDATE);
+	RegisterUpdatePhase(InputSystem::InputPhase, SystemAccess().WriteWorld<InputWorldComponent>(), eUpdatePhaseOrder::PREUPDATE);
+	RegisterUpdatePhase(MovementSystem::MovementUpdatePhase,
+		SystemAccess().ReadWorld<InputWorldComponent>().Read<FreeFloatMovementComponent>().Write<TransformComponent>(), eUpdatePhaseOrder::PREUPDATE);
+	// global transformations are updated in one pass before anything reads them
+	RegisterUpdatePhase(TransformSystem::TransformUpdatePhase, SystemAccess().Write<TransformComponent>(), eUpdatePhaseOrder::POSTUPDATE);
+	// global transformations of transforms changed later are still cached lazily, so reading them is a write
+	RegisterUpdatePhase(CameraSystem::CameraUpdatePhase,
+		SystemAccess().ReadWorld<ViewportWorldComponent>().Write<CameraComponent, TransformComponent>(), eUpdatePhaseOrder::POSTUPDATE);
+	// rendering device context is bound to the main thread
 	RegisterUpdatePhase(RenderingSystem::RenderingPhase, eUpdatePhaseOrder::POSTUPDATE);
 	RegisterUpdatePhase(DeferredTaskSystem::DeferredTaskPhase, eUpdatePhaseOrder::POSTUPDATE);
 	RegisterUpdatePhase(FPSSystem::FPSUpdatePhase, eUpdatePhaseOrder::POSTUPDATE);
@@ -51,24 +60,145 @@ Engine::Engine(std::unique_ptr<IGame> game, std::unique_ptr<IRenderingDevice> de
 //------------------------------------------------------------------------------
 Engine::~Engine()
 {
+	WaitForWorldLoader();
+	LoadedWorld.reset();
 	Game->Deinit();
 	BaseWorld.reset();
 	Game.reset();
 	RenderingDevice.reset();
+	Workers.reset();
 	gEngine = nullptr;
 }
 
+//------------------------------------------------------------------------------
+std::unique_ptr<World> Engine::CreateWorld() const
+{
+	std::unique_ptr<World> world = std::make_unique<World>(gCoreConfig.ComponentStorage, gCoreConfig.MaxEntityCount, gCoreConfig.UseHugePages);
+	DeferredTaskSystem::AddWorldComponentImmediate<InputWorldComponent>(world.get());
+	DeferredTaskSystem::AddWorldComponentImmediate<ViewportWorldComponent>(world.get());
+	DeferredTaskSystem::AddWorldComponentImmediate<TimeWorldComponent>(world.get());
+	DeferredTaskSystem::AddWorldComponentImmediate<DebugWorldComponent>(world.get());
+	DeferredTaskSystem::AddWorldComponentImmediate<DeferredTaskWorldComponent>(world.get());
+
+	// Engine observers
+	world->OnAdd<CameraComponent>(CameraSystem::OnCamerasAdded);
+	return world;
+}
+
+//------------------------------------------------------------------------------
+void Engine::SetWorld(std::unique_ptr<World> world)
+{
+	ASSERTE(world, "Active world can not be null!");
+	BaseWorld = std::move(world);
+}
+
+//------------------------------------------------------------------------------
+void Engine::LoadWorldAsync(const std::function<void(World*)>& build)
+{
+	ASSERTE(!IsLoadingWorld(), "Another world is being loaded!");
+	// world components are created here, so the loader thread touches only its own world
+	std::unique_ptr<World> world = CreateWorld();
+	WorldLoader = std::thread([this, build](std::unique_ptr<World> world)
+	{
+		try
+		{
+			build(world.get());
+			LoadedWorld = std::move(world);
+		}
+		catch (const std::exception& e)
+		{
+			gConsole.LogError("World loading failed: {}", e.what());
+			// resources of the partially built world have to be released on the main thread
+			RunOnMainThread([&world]() { world.reset(); });
+		}
+		WorldLoaded.store(true, std::memory_order_release);
+	}, std::move(world));
+}
+
+//------------------------------------------------------------------------------
+void Engine::WaitForWorldLoader()
+{
+	if (!WorldLoader.joinable())
+		return;
+	while (!WorldLoaded.load(std::memory_order_acquire))
+	{
+		ExecuteMainThreadTasks();
+		std::this_thread::yield();
+	}
+	WorldLoader.join();
+	WorldLoaded.store(false, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+void Engine::RunOnMainThread(const std::function<void()>& task)
+{
+	if (IsMainThread())
+	{
+		task();
+		return;
+	}
+
+	std::packaged_task<void()> packagedTask(task);
+	std::future<void> result = packagedTask.get_future();
+	{
+		std::lock_guard<std::mutex> lock(MainThreadTasksMutex);
+		MainThreadTasks.PushBack(&packagedTask);
+	}
+	result.get();
+}
+
+//------------------------------------------------------------------------------
+void Engine::ExecuteMainThreadTasks()
+{
+	Dynarray<std::packaged_task<void()>*> tasks;
+	{
+		std::lock_guard<std::mutex> lock(MainThreadTasksMutex);
+		std::swap(tasks, MainThreadTasks);
+	}
+	// packaged tasks pass exceptions to the waiting thread
+	for (std::packaged_task<void()>* task : tasks)
+		(*task)();
+}
+
 //------------------------------------------------------------------------------
 void Engine::RegisterUpdatePhase(const PhaseUpdateFunction& phaseFunction, eUpdatePhaseOrder order)
+{
+	RegisterUpdatePhase(phaseFunction, SystemAccess::Exclusive(), order);
+}
+
+//------------------------------------------------------------------------------
+void Engine::RegisterUpdatePhase(const PhaseUpdateFunction& phaseFunction, const SystemAccess& access, eUpdatePhaseOrder order)
 {
 	HEAVY_ASSERTE(order != eUpdatePhaseOrder::_COUNT, "_COUNT enum value passed to RegisterUpdatePhase(), which is an invalid value");
-	Dynarray<PhaseUpdateFunction>& UpdatePhases = GameUpdatePhases[static_cast<int>(order)];
-	UpdatePhases.PushBack(phaseFunction);
+	GameUpdatePhases[static_cast<int>(order)]->AddSystem(phaseFunction, access);
+}
+
+//------------------------------------------------------------------------------
+void Engine::RegisterGameUpdatePhase(const PhaseUpdateFunction& phaseFunction)
+{
+	RegisterUpdatePhase(phaseFunction, eUpdatePhaseOrder::UPDATE);
+}
+
+//------------------------------------------------------------------------------
+void Engine::UpdatePhases(eUpdatePhaseOrder order)
+{
+	HEAVY_ASSERTE(order != eUpdatePhaseOrder::_COUNT, "_COUNT enum value passed to UpdatePhases(), which is an invalid value");
+	GameUpdatePhases[static_cast<int>(order)]->Execute(GetWorld(), Workers.get());
 }
 
 //------------------------------------------------------------------------------
 void Engine::Update()
 {
+	ExecuteMainThreadTasks();
+	if (WorldLoaded.load(std::memory_order_acquire))
+	{
+		WaitForWorldLoader();
+		if (LoadedWorld)
+			SetWorld(std::move(LoadedWorld));
+	}
+	// components added since the previous frame, also by its deferred tasks, are seen by all systems of this one
+	GetWorld()->DispatchObserverEvents();
+
 	UpdatePhases(eUpdatePhaseOrder::PREUPDATE);
 	UpdatePhases(eUpdatePhaseOrder::UPDATE);
 	UpdatePhases(eUpdatePhaseOrder::POSTUPDATE);
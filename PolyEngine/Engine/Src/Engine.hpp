@@ -5,8 +5,13 @@
 #include <typeinfo>
 #include <unordered_map>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <future>
 
 #include <Core.hpp>
+#include <ThreadPool.hpp>
 #include "IRenderingDevice.hpp"
 
 #include "InputSystem.hpp"
@@ -15,8 +20,26 @@ namespace Poly
 {
 	class World;
 	class Engine;
+	class SystemAccess;
+	class SystemScheduler;
 	typedef std::function<void(World*)> PhaseUpdateFunction;
 
+	namespace Impl
+	{
+		/// <summary>Per type cache of registered component ID, so ID lookup does not need hashing.
+		/// Every module (executable or shared library) has its own instance of the cache, it is filled lazily from engine type maps
+		/// and is valid as long as its generation matches generation of the engine registry.</summary>
+		template<typename T, bool IsWorldComponent>
+		struct ComponentIDCache
+		{
+			static std::atomic<size_t> Generation;
+			// atomic, because the cache can be filled by many update phase functions at once
+			static std::atomic<size_t> ID;
+		};
+		template<typename T, bool IsWorldComponent> std::atomic<size_t> ComponentIDCache<T, IsWorldComponent>::Generation(0);
+		template<typename T, bool IsWorldComponent> std::atomic<size_t> ComponentIDCache<T, IsWorldComponent>::ID(0);
+	}
+
 	/// <summary>Enum used to identify components.
 	/// User should make his own enum for custom components.
 	/// Custom components ID's should be equal to or bigger than eEngineComponents::_COUNT. </summary>
@@ -77,12 +100,21 @@ namespace Poly
 			_COUNT
 		};
 
-		/// <summary>Registers a PhaseUpdateFunction to be executed in the update.</summary>
+		/// <summary>Registers a PhaseUpdateFunction to be executed in the update.
+		/// Function is exclusive, it runs alone and after all earlier registered functions.</summary>
 		/// <param name="phaseFunction"/>
-		void RegisterGameUpdatePhase(const PhaseUpdateFunction& phaseFunction) { RegisterUpdatePhase(phaseFunction, eUpdatePhaseOrder::UPDATE); }
+		void RegisterGameUpdatePhase(const PhaseUpdateFunction& phaseFunction);
+
+		/// <summary>Registers a PhaseUpdateFunction to be executed in the update.
+		/// Function can run concurrently with other functions whose declared access does not conflict with its own.</summary>
+		/// <param name="phaseFunction"/>
+		/// <param name="access">Components and world components the function reads and writes.</param>
+		/// <see cref="SystemAccess"/>
+		void RegisterGameUpdatePhase(const PhaseUpdateFunction& phaseFunction, const SystemAccess& access) { RegisterUpdatePhase(phaseFunction, access, eUpdatePhaseOrder::UPDATE); }
 
 		/// <summary>Executes update phases functions that were registered in RegisterUpdatePhase().
-		/// Functions are executrd with given order and with given update phase order.</summary>
+		/// Functions are executrd with given order and with given update phase order.
+		/// Every update phase order is a barrier, independent functions registered for one order run concurrently.</summary>
 		/// <see cref="Engine.RegisterUpdatePhase()"/>
 		/// <see cref="Engine.eUpdatePhaseOrder"/>
 		void Update();
@@ -111,8 +143,39 @@ namespace Poly
 		/// <returns>Pointer to current world.</returns>
 		World* GetWorld() { return BaseWorld.get(); }
 
+		/// <summary>Creates a world with engine world components, configured like the active one. The engine does not update it,
+		/// so it can be used for simulation only or filled and made active later with SetWorld().</summary>
+		/// <returns>New world owned by the caller.</returns>
+		std::unique_ptr<World> CreateWorld() const;
+
+		/// <summary>Makes given world the active one, the previous active world is destroyed.
+		/// Must not be called from update phase functions.</summary>
+		/// <param name="world">World created with CreateWorld().</param>
+		void SetWorld(std::unique_ptr<World> world);
+
+		/// <summary>Builds a new world on a background thread while the active world keeps running.
+		/// After build returns, the next Update() makes the new world active before running any update phase.
+		/// Only one world can be loaded at a time.</summary>
+		/// <param name="build">Function that fills the new world. It runs on the loader thread, so it can use only the world it is given.
+		/// Resources can be loaded from it, their rendering device objects are created on the main thread between frames.</param>
+		/// <see cref="Engine.RunOnMainThread()"/>
+		void LoadWorldAsync(const std::function<void(World*)>& build);
+
+		/// <summary>Returns true if a world started with LoadWorldAsync() was not made active yet.</summary>
+		bool IsLoadingWorld() const { return WorldLoader.joinable(); }
+
+		/// <summary>Executes a task on the main thread and waits until it is done.
+		/// Called from the main thread runs the task immediately, from other threads the task runs at the beginning of the next Update().
+		/// Used for rendering device calls, which are bound to the main thread. Exceptions thrown by the task are rethrown to the caller.</summary>
+		/// <param name="task">Function to execute.</param>
+		void RunOnMainThread(const std::function<void()>& task);
+
+		/// <summary>Returns true if called from the thread that created the engine.</summary>
+		bool IsMainThread() const { return std::this_thread::get_id() == MainThreadID; }
+
 		/// <summary>Registers component tyoe for further use.
-		/// Registered class must inherit from ComponentBase class.</summary>
+		/// Registered class should inherit from ComponentBase class, otherwise it is stored as a plain component or a tag.</summary>
+		/// <see cref="eComponentKind"/>
 		/// <tparam name="T">component typen</tparam>
 		/// <param name="id">Specifies what id should be associated to registered component.</param>
 		template<typename T> void RegisterComponent(size_t id)
@@ -127,6 +190,7 @@ namespace Poly
 				"Component type or id was registered twice!");
 
 			ComponentTypeMap[typeid(T)] = id;
+			StoreCachedID<T, false>(id);
 		}
 
 		/// <summary>If given component is registered function returns associated ID.</summary>
@@ -134,8 +198,14 @@ namespace Poly
 		/// <returns>Associated ID.</returns>
 		template<typename T> size_t GetComponentID() const
 		{
-			ASSERTE(ComponentTypeMap.find(typeid(T)) != ComponentTypeMap.end(), "Component was not registered!");
-			return ComponentTypeMap.at(typeid(T));
+			typedef Impl::ComponentIDCache<T, false> Cache;
+			if (Cache::Generation.load(std::memory_order_acquire) == RegistryGeneration)
+				return Cache::ID.load(std::memory_order_relaxed);
+
+			const auto it = ComponentTypeMap.find(typeid(T));
+			ASSERTE(it != ComponentTypeMap.end(), "Component was not registered!");
+			StoreCachedID<T, false>(it->second);
+			return it->second;
 		}
 
 		/// <summary>Registers world component tyoe for further use.
@@ -154,6 +224,7 @@ namespace Poly
 				"World component type or id was registered twice!");			
 				
 			WorldComponentTypeMap[typeid(T)] = id;
+			StoreCachedID<T, true>(id);
 		}
 
 		/// <summary>If given world component is registered function returns associated ID.</summary>
@@ -161,8 +232,14 @@ namespace Poly
 		/// <returns>Associated ID.</returns>
 		template<typename T> size_t GetWorldComponentID() const
 		{
-			ASSERTE(WorldComponentTypeMap.find(typeid(T)) != WorldComponentTypeMap.end(), "World component was not registered!");
-			return WorldComponentTypeMap.at(typeid(T));
+			typedef Impl::ComponentIDCache<T, true> Cache;
+			if (Cache::Generation.load(std::memory_order_acquire) == RegistryGeneration)
+				return Cache::ID.load(std::memory_order_relaxed);
+
+			const auto it = WorldComponentTypeMap.find(typeid(T));
+			ASSERTE(it != WorldComponentTypeMap.end(), "World component was not registered!");
+			StoreCachedID<T, true>(it->second);
+			return it->second;
 		}
 
 		/// <summary>Returns pointer to rendering device.</summary>
@@ -173,18 +250,26 @@ namespace Poly
 		/// <returns>Reference to InputQueue instance.</returns>
 		InputQueue& GetInputQueue() { return InputEventsQueue; }
 
+		/// <summary>Returns pool of worker threads used to run independent update phase functions.</summary>
+		ThreadPool* GetThreadPool() const { return Workers.get(); }
+
 		/// <summary>Makes renderer resizes its context.</summary>
 		/// <param name="size">New screen size</param>
 		void ResizeScreen(const ScreenSize& size);
 
 	private:
-		inline void UpdatePhases(eUpdatePhaseOrder order)
+		template<typename T, bool IsWorldComponent> void StoreCachedID(size_t id) const
 		{
-			HEAVY_ASSERTE(order != eUpdatePhaseOrder::_COUNT, "_COUNT enum value passed to UpdatePhases(), which is an invalid value");
-			for (auto& update : GameUpdatePhases[static_cast<int>(order)])
-				update(GetWorld());
+			typedef Impl::ComponentIDCache<T, IsWorldComponent> Cache;
+			Cache::ID.store(id, std::memory_order_relaxed);
+			Cache::Generation.store(RegistryGeneration, std::memory_order_release);
 		}
 
+		void UpdatePhases(eUpdatePhaseOrder order);
+		void ExecuteMainThreadTasks();
+		// Waits for the loader thread, executing tasks it sends to the main thread meanwhile
+		void WaitForWorldLoader();
+
 		/// Registers a PhaseUpdateFunction to be executed in the update.
 		/// part of a single frame in the same order as they were passed in.
 		/// @param phaseFunction - void function(World*)
@@ -192,15 +277,31 @@ namespace Poly
 		/// @see eUpdatePhaseOrder
 		void RegisterUpdatePhase(const PhaseUpdateFunction& phaseFunction, eUpdatePhaseOrder order);
 
+		/// Registers a PhaseUpdateFunction that declares accessed data, so it can run concurrently with independent functions.
+		/// @see SystemAccess
+		void RegisterUpdatePhase(const PhaseUpdateFunction& phaseFunction, const SystemAccess& access, eUpdatePhaseOrder order);
+
 		std::unique_ptr<World> BaseWorld;
+
+		// Background world loading, LoadedWorld is handed over by the loader thread when WorldLoaded is set
+		std::thread WorldLoader;
+		std::unique_ptr<World> LoadedWorld;
+		std::atomic<bool> WorldLoaded;
+
+		const std::thread::id MainThreadID;
+		std::mutex MainThreadTasksMutex;
+		Dynarray<std::packaged_task<void()>*> MainThreadTasks;
 		std::unique_ptr<IGame> Game;
 		std::unique_ptr<IRenderingDevice> RenderingDevice;
 		InputQueue InputEventsQueue;
 
-		Dynarray<PhaseUpdateFunction> GameUpdatePhases[static_cast<int>(eUpdatePhaseOrder::_COUNT)];
+		std::unique_ptr<SystemScheduler> GameUpdatePhases[static_cast<int>(eUpdatePhaseOrder::_COUNT)];
+		std::unique_ptr<ThreadPool> Workers;
 
 		std::unordered_map<std::type_index, size_t> ComponentTypeMap;
 		std::unordered_map<std::type_index, size_t> WorldComponentTypeMap;
+		// Unique for every engine instance, invalidates component ID caches filled by previous instances.
+		const size_t RegistryGeneration;
 	};
 
 	ENGINE_DLLEXPORT extern Engine* gEngine;
@@ -8,8 +8,13 @@
 
 // ECS
 #include "ComponentBase.hpp"
+#include "EntityID.hpp"
 #include "Entity.hpp"
+#include "Archetype.hpp"
+#include "Query.hpp"
+#include "TransformHierarchy.hpp"
 #include "World.hpp"
+#include "WorldSnapshot.hpp"
 
 // Rendering
 #include "IRenderingDevice.hpp"
@@ -41,6 +46,7 @@
 #include "DeferredTaskWorldComponent.hpp"
 
 // Systems
+#include "SystemScheduler.hpp"
 #include "DeferredTaskSystem.hpp"
 
 // Config
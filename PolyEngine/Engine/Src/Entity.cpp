@@ -4,14 +4,86 @@
 
 using namespace Poly;
 
-Entity::Entity(const World * world)
-: EntityID(UniqueID::Generate()), EntityWorld(world), ComponentPosessionFlags(0)
+namespace
 {
-	memset(Components, 0, sizeof(ComponentBase*) * MAX_COMPONENTS_COUNT);
+	// Packed component lists grow in powers of two, so most entities never reallocate after the first few components
+	size_t GetComponentListCapacity(size_t count)
+	{
+		if (count == 0)
+			return 0;
+		return count <= 4 ? 4 : size_t(1) << (FindLastSetBit(count - 1) + 1);
+	}
 }
 
+//------------------------------------------------------------------------------
+Entity::Entity(World * world, const EntityID& id)
+: ID(id), EntityWorld(world)
+{
+}
+
+//------------------------------------------------------------------------------
+Entity::~Entity()
+{
+	DefaultFree(Components);
+}
+
+//------------------------------------------------------------------------------
 bool Entity::HasComponent(size_t ID) const
 {
 	HEAVY_ASSERTE(ID < MAX_COMPONENTS_COUNT, "Invalid component ID - greater than MAX_COMPONENTS_COUNT.");
 	return ComponentPosessionFlags[ID];
 }
+
+//------------------------------------------------------------------------------
+void Entity::AddComponentSlot(size_t componentID, ComponentBase* component)
+{
+	HEAVY_ASSERTE(!ComponentPosessionFlags[componentID], "Component is already owned!");
+	if (EntityArchetype || EntityWorld->TagComponentIDs[componentID])
+	{
+		ComponentPosessionFlags.set(componentID);
+		return;
+	}
+
+	const ComponentSignature stored = ComponentPosessionFlags & ~EntityWorld->TagComponentIDs;
+	const size_t count = stored.count();
+	if (count + 1 > GetComponentListCapacity(count))
+	{
+		ComponentBase** list = static_cast<ComponentBase**>(DefaultAlloc(sizeof(ComponentBase*) * GetComponentListCapacity(count + 1)));
+		if (Components)
+			memcpy(list, Components, sizeof(ComponentBase*) * count);
+		DefaultFree(Components);
+		Components = list;
+	}
+
+	const size_t position = ComponentRank(stored, componentID);
+	memmove(Components + position + 1, Components + position, sizeof(ComponentBase*) * (count - position));
+	Components[position] = component;
+	ComponentPosessionFlags.set(componentID);
+}
+
+//------------------------------------------------------------------------------
+void Entity::RemoveComponentSlot(size_t componentID)
+{
+	HEAVY_ASSERTE(ComponentPosessionFlags[componentID], "Component is not owned!");
+	ComponentPosessionFlags.reset(componentID);
+	if (EntityArchetype || EntityWorld->TagComponentIDs[componentID])
+		return;
+
+	const ComponentSignature stored = ComponentPosessionFlags & ~EntityWorld->TagComponentIDs;
+	const size_t count = stored.count();
+	const size_t position = ComponentRank(stored, componentID);
+	memmove(Components + position, Components + position + 1, sizeof(ComponentBase*) * (count - position));
+	if (count == 0)
+	{
+		DefaultFree(Components);
+		Components = nullptr;
+	}
+}
+
+//------------------------------------------------------------------------------
+size_t Entity::GetComponentListMemoryUsage() const
+{
+	if (!Components)
+		return 0;
+	return sizeof(ComponentBase*) * GetComponentListCapacity((ComponentPosessionFlags & ~EntityWorld->TagComponentIDs).count());
+}
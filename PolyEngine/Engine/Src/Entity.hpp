@@ -4,18 +4,51 @@
 #include <bitset>
 
 #include "Engine.hpp"
+#include "EntityID.hpp"
 
 namespace Poly
 {
 	class ComponentBase;
-	constexpr unsigned int MAX_COMPONENTS_COUNT = 64;
+	class Archetype;
+	constexpr unsigned int MAX_COMPONENTS_COUNT = 128;
+
+	/// <summary>Set of component IDs owned by an entity. Entities with equal signatures share an archetype.</summary>
+	typedef std::bitset<MAX_COMPONENTS_COUNT> ComponentSignature;
+
+	/// <summary>Returns the smallest component ID in signature that is not smaller than from, or MAX_COMPONENTS_COUNT if there is none.
+	/// Visits 64 IDs at once, so loops over owned components do not test every possible ID.</summary>
+	inline size_t NextComponentID(const ComponentSignature& signature, size_t from)
+	{
+		static const ComponentSignature WORD_MASK(~0ull);
+		for (size_t word = from / 64; word * 64 < MAX_COMPONENTS_COUNT; ++word)
+		{
+			uint64_t bits = ((signature >> (word * 64)) & WORD_MASK).to_ullong();
+			if (word == from / 64)
+				bits &= ~0ull << (from % 64);
+			if (bits)
+				return word * 64 + FindFirstSetBit(bits);
+		}
+		return MAX_COMPONENTS_COUNT;
+	}
+
+	/// <summary>Returns count of component IDs in signature that are smaller than given one.</summary>
+	inline size_t ComponentRank(const ComponentSignature& signature, size_t componentID)
+	{
+		return (signature << (MAX_COMPONENTS_COUNT - componentID)).count();
+	}
 
 	/// <summary>Class that represent entity inside core engine systems. Should not be used anywhere else.</summary>
+	/// <para>Entity does not keep a table indexed by component ID. With archetype storage components are found
+	/// in the entity archetype row, with pool storage pointers to owned components are packed in ID order
+	/// and component position is the count of owned components with smaller IDs. Tags are never stored, owning them is only a bit in the signature.</para>
 	class ENGINE_DLLEXPORT Entity : public BaseObject<>
 	{
 	public:
-		const UniqueID& GetID() const { HEAVY_ASSERTE(EntityID, "Entity was not properly initialized");  return EntityID; }
-		const World* GetWorld() const { HEAVY_ASSERTE(EntityID, "Entity was not properly initialized");  return EntityWorld; }
+		~Entity();
+
+		const EntityID& GetID() const { HEAVY_ASSERTE(ID, "Entity was not properly initialized");  return ID; }
+		const World* GetWorld() const { HEAVY_ASSERTE(ID, "Entity was not properly initialized");  return EntityWorld; }
+		World* GetWorld() { HEAVY_ASSERTE(ID, "Entity was not properly initialized");  return EntityWorld; }
 
 		/// <summary>Checks whether there is a component of a given ID under this Entity's ID.</summary>
 		/// <param name="ID">ID of a component type</param>
@@ -25,16 +58,11 @@ namespace Poly
 		bool HasComponent(size_t ID) const;
 
 		/// <summary>Checks whether there are all of the specified components under this Entity's ID.</summary>
-		/// <param name="IDs">IDs is a bit field of component IDs to be checked for, see macro BIT()</param> 
+		/// <param name="IDs">Set of component IDs to be checked for.</param> 
 		/// <returns>True if has queried components, false otherwise.</summary>
 		/// <seealso cref="Entity.GetComponent()"/>
 		/// <seealso cref="Entity.HasComponent()"/>
-		inline bool HasComponents(unsigned long int IDs) const
-		{
-			//TODO This bit field has to be reimplemented - it will not work for MAX_COMPONENTS_COUNT greater than 64 in its current state.
-			STATIC_ASSERTE(MAX_COMPONENTS_COUNT <= 64, "MAX_COMPONENTS_COUNT greater than 64.");
-			return (ComponentPosessionFlags.to_ullong() & IDs) == IDs;
-		}
+		bool HasComponents(const ComponentSignature& IDs) const { return (ComponentPosessionFlags & IDs) == IDs; }
 
 		/// <summary>Gets a pointer to a component of a given ID.</summary>
 		/// <returns>A pointer to a component or nullptr if it does not exist.</returns>
@@ -42,14 +70,39 @@ namespace Poly
 		T* GetComponent(); //defined in World.hpp due to circular inclusion problem; FIXME: circular inclusion
 
 	private:
-		Entity(const World* world);
+		Entity(World* world, const EntityID& id);
+
+		/// <summary>Returns owned component of given ID or nullptr.</summary>
+		ComponentBase* GetComponentById(size_t componentID) const; //defined in World.hpp due to circular inclusion problem
+
+		/// <summary>Marks component as owned. With pool storage the pointer is inserted into the packed list, unless the component is a tag.</summary>
+		void AddComponentSlot(size_t componentID, ComponentBase* component);
+
+		/// <summary>Marks component as not owned. With pool storage the pointer is removed from the packed list.</summary>
+		void RemoveComponentSlot(size_t componentID);
+
+		/// <summary>Returns count of bytes allocated for the packed component list.</summary>
+		size_t GetComponentListMemoryUsage() const;
+
+		EntityID ID;
+		World* EntityWorld = nullptr;
 
-		UniqueID EntityID;
-		const World* EntityWorld = nullptr;
+		ComponentSignature ComponentPosessionFlags;
+		// Pool storage only. Pointers to owned components sorted by ID, capacity is derived from the count of owned components other than tags.
+		ComponentBase** Components = nullptr;
 
-		std::bitset<MAX_COMPONENTS_COUNT> ComponentPosessionFlags;
-		ComponentBase* Components[MAX_COMPONENTS_COUNT];
+		// Location of entity components when archetype storage is used
+		Archetype* EntityArchetype = nullptr;
+		size_t ArchetypeRow = 0;
 
 		friend class World;
+		friend class WorldSerializer;
+		friend class WorldSnapshot;
+		friend class ComponentBase;
+		friend struct QueryFilter;
+		friend class QueryCache;
+		friend class SortedQueryCache;
+		friend class QueryCursor;
+		template<typename Required, typename Optional> friend class QueryIterator;
 	};
 } //namespace Poly
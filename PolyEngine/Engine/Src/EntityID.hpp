@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Core.hpp>
+
+namespace Poly
+{
+	/// <summary>Handle that identifies an entity inside a world.
+	/// Consists of an index into the world entity slot table and the generation of that slot.
+	/// Slot generation changes every time an entity is destroyed, so handles to destroyed entities can be detected.</summary>
+	/// <see cref="World.IsEntityAlive()"/>
+	class ENGINE_DLLEXPORT EntityID : public BaseObjectLiteralType<>
+	{
+	public:
+		/// <summary>Constructs invalid handle.</summary>
+		EntityID() = default;
+
+		bool operator==(const EntityID& rhs) const { return Index == rhs.Index && Generation == rhs.Generation; }
+		bool operator!=(const EntityID& rhs) const { return !(*this == rhs); }
+
+		/// <summary>Returns true if handle was obtained from a world. It does not mean the entity is still alive.</summary>
+		explicit operator bool() const { return Generation != 0; }
+
+		size_t GetIndex() const { return Index; }
+		uint32_t GetGeneration() const { return Generation; }
+
+		size_t GetHash() const { return static_cast<size_t>((static_cast<uint64_t>(Generation) << 32) | Index); }
+
+	private:
+		EntityID(uint32_t index, uint32_t generation) : Index(index), Generation(generation) {}
+
+		uint32_t Index = 0;
+		uint32_t Generation = 0;
+
+		friend class World;
+	};
+}
+
+// hasher for EntityID
+namespace std {
+	template <> struct hash<Poly::EntityID> { std::size_t operator()(const Poly::EntityID& k) const { return k.GetHash(); } };
+}
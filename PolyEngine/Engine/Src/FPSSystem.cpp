@@ -14,7 +14,7 @@ void FPSSystem::FPSUpdatePhase(World* world)
 
 	if (gCoreConfig.DisplayFPS && !com->FPSData.DisplayingFPS)
 	{
-		UniqueID id = DeferredTaskSystem::SpawnEntityImmediate(world);
+		EntityID id = DeferredTaskSystem::SpawnEntityImmediate(world);
 		DeferredTaskSystem::AddComponentImmediate<ScreenSpaceTextComponent>(world,  id, Vector(0, 10, 0), "Fonts/Raleway/Raleway-Regular.ttf", 32);
 		com->FPSData.DisplayingFPS = true;
 	}
@@ -11,6 +11,24 @@ MeshRenderingComponent::MeshRenderingComponent(const String& meshPath)
 	Mesh = ResourceManager<MeshResource>::Load(meshPath);
 }
 
+MeshRenderingComponent::MeshRenderingComponent(const MeshRenderingComponent& rhs)
+	: ComponentBase(rhs), Mesh(rhs.Mesh)
+{
+	if (Mesh)
+		Mesh->AddRef();
+}
+
+MeshRenderingComponent& MeshRenderingComponent::operator=(const MeshRenderingComponent& rhs)
+{
+	ComponentBase::operator=(rhs);
+	if (rhs.Mesh)
+		rhs.Mesh->AddRef();
+	if (Mesh)
+		ResourceManager<MeshResource>::Release(Mesh);
+	Mesh = rhs.Mesh;
+	return *this;
+}
+
 Poly::MeshRenderingComponent::~MeshRenderingComponent()
 {
 	if (Mesh)
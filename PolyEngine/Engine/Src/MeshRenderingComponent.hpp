@@ -11,6 +11,10 @@ namespace Poly {
 		friend void RenderingSystem::RenderingPhase(World*);
 	public:
 		MeshRenderingComponent(const String& meshPath);
+		MeshRenderingComponent(MeshRenderingComponent&& rhs) : ComponentBase(rhs), Mesh(rhs.Mesh) { rhs.Mesh = nullptr; }
+		/// <summary>Copies share the mesh resource, each of them holds a reference.</summary>
+		MeshRenderingComponent(const MeshRenderingComponent& rhs);
+		MeshRenderingComponent& operator=(const MeshRenderingComponent& rhs);
 		virtual ~MeshRenderingComponent();
 
 		const MeshResource* GetMesh() const { return Mesh; }
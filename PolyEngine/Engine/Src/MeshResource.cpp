@@ -70,8 +70,12 @@ Poly::MeshResource::SubMesh::SubMesh(const String& path, aiMesh* mesh, aiMateria
 		}
 	}
 
-	MeshProxy = gEngine->GetRenderingDevice()->CreateMesh();
-	MeshProxy->SetContent(MeshData);
+	// meshes can be loaded by world loader thread, rendering device is bound to the main thread
+	gEngine->RunOnMainThread([this]()
+	{
+		MeshProxy = gEngine->GetRenderingDevice()->CreateMesh();
+		MeshProxy->SetContent(MeshData);
+	});
 
 	gConsole.LogDebug(
 		"Loaded mesh entry: {} with {} vertices, {} faces and parameters: "
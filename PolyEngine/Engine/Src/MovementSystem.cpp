@@ -6,20 +6,18 @@ using namespace Poly;
 
 void MovementSystem::MovementUpdatePhase(World* world)
 {
-	for (auto freeFloatTuple : world->IterateComponents<FreeFloatMovementComponent, TransformComponent>())
+	const InputWorldComponent* inputCmp = world->GetWorldComponent<InputWorldComponent>();
+	world->ParallelForEach<FreeFloatMovementComponent, TransformComponent>([inputCmp](FreeFloatMovementComponent* freeFloatMovementCmp, TransformComponent* transCmp)
 	{
-		TransformComponent* transCmp = std::get<TransformComponent*>(freeFloatTuple);
-		FreeFloatMovementComponent* freeFloatMovementCmp = std::get<FreeFloatMovementComponent*>(freeFloatTuple);
-
 		Vector move;
-		if (world->GetWorldComponent<InputWorldComponent>()->IsPressed(eKey::KEY_W))
+		if (inputCmp->IsPressed(eKey::KEY_W))
 			move -= Vector::UNIT_Z;
-		else if (world->GetWorldComponent<InputWorldComponent>()->IsPressed(eKey::KEY_S))
+		else if (inputCmp->IsPressed(eKey::KEY_S))
 			move += Vector::UNIT_Z;
 
-		if (world->GetWorldComponent<InputWorldComponent>()->IsPressed(eKey::KEY_A))
+		if (inputCmp->IsPressed(eKey::KEY_A))
 			move -= Vector::UNIT_X;
-		else if (world->GetWorldComponent<InputWorldComponent>()->IsPressed(eKey::KEY_D))
+		else if (inputCmp->IsPressed(eKey::KEY_D))
 			move += Vector::UNIT_X;
 
 		if (move.Length2() > 0)
@@ -28,9 +26,9 @@ void MovementSystem::MovementUpdatePhase(World* world)
 
 		transCmp->SetLocalTranslation(transCmp->GetLocalTranslation() + transCmp->GetLocalRotation() * move);
 		
-		if (world->GetWorldComponent<InputWorldComponent>()->IsPressed(eKey::MLBUTTON))
+		if (inputCmp->IsPressed(eKey::MLBUTTON))
 		{
-			Vector delta = world->GetWorldComponent<InputWorldComponent>()->GetMousePosDelta();
+			Vector delta = inputCmp->GetMousePosDelta();
 
 			Quaternion rot = Quaternion(Vector::UNIT_Y, Angle::FromRadians(-delta.X * freeFloatMovementCmp->GetRotationSpeed()));
 			rot *= transCmp->GetLocalRotation();
@@ -41,7 +39,7 @@ void MovementSystem::MovementUpdatePhase(World* world)
 				transCmp->SetLocalRotation(rot);
 			}
 		}
-	}
+	});
 }
 
 Vector MovementSystem::GetLocalForward(const TransformComponent* transform)
@@ -0,0 +1,278 @@
+#include "EnginePCH.hpp"
+
+#include "Query.hpp"
+
+using namespace Poly;
+
+//------------------------------------------------------------------------------
+bool QueryFilter::IsChanged(const Entity* entity) const
+{
+	for (size_t id = NextComponentID(Changed, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(Changed, id + 1))
+		if (entity->GetComponentById(id)->GetChangeVersion() > ChangedSince)
+			return true;
+	return Changed.none();
+}
+
+//------------------------------------------------------------------------------
+void QueryCache::OnEntityChanged(Entity* entity)
+{
+	const size_t slot = entity->GetID().GetIndex();
+	const bool matched = slot < EntityPositions.GetSize() && EntityPositions[slot] != 0;
+	const bool matches = Filter.Matches(entity->ComponentPosessionFlags);
+
+	if (matches && !matched)
+	{
+		if (slot >= EntityPositions.GetSize())
+		{
+			const size_t oldSize = EntityPositions.GetSize();
+			EntityPositions.Resize(slot + 1);
+			for (size_t i = oldSize; i < EntityPositions.GetSize(); ++i)
+				EntityPositions[i] = 0;
+		}
+		Entities.PushBack(entity);
+		EntityPositions[slot] = Entities.GetSize();
+	}
+	else if (!matches && matched)
+		RemoveEntity(slot);
+}
+
+//------------------------------------------------------------------------------
+void QueryCache::OnEntityDestroyed(Entity* entity)
+{
+	const size_t slot = entity->GetID().GetIndex();
+	if (slot < EntityPositions.GetSize() && EntityPositions[slot] != 0)
+		RemoveEntity(slot);
+}
+
+//------------------------------------------------------------------------------
+void QueryCache::OnArchetypeCreated(Archetype* archetype)
+{
+	if (Filter.Matches(archetype->GetSignature()))
+		Archetypes.PushBack(archetype);
+}
+
+//------------------------------------------------------------------------------
+void QueryCache::RemoveEntity(size_t slot)
+{
+	// move the last entity into the hole
+	const size_t idx = EntityPositions[slot] - 1;
+	Entity* last = Entities[Entities.GetSize() - 1];
+	Entities[idx] = last;
+	EntityPositions[last->GetID().GetIndex()] = idx + 1;
+	Entities.PopBack();
+	EntityPositions[slot] = 0;
+}
+
+//------------------------------------------------------------------------------
+void SortedQueryCache::OnEntityChanged(Entity* entity)
+{
+	const size_t slot = entity->GetID().GetIndex();
+	const bool matched = slot < Tokens.GetSize() && Tokens[slot] != 0;
+	const bool matches = Filter.Matches(entity->ComponentPosessionFlags);
+
+	if (matches && !matched)
+	{
+		if (slot >= Tokens.GetSize())
+		{
+			const size_t oldSize = Tokens.GetSize();
+			Tokens.Resize(slot + 1);
+			for (size_t i = oldSize; i < Tokens.GetSize(); ++i)
+				Tokens[i] = 0;
+		}
+		Tokens[slot] = NextToken++;
+		Pending.PushBack(Entry{ 0, slot, Tokens[slot], entity });
+	}
+	else if (!matches && matched)
+		Invalidate(slot);
+}
+
+//------------------------------------------------------------------------------
+void SortedQueryCache::OnEntityDestroyed(Entity* entity)
+{
+	const size_t slot = entity->GetID().GetIndex();
+	if (slot < Tokens.GetSize() && Tokens[slot] != 0)
+		Invalidate(slot);
+}
+
+//------------------------------------------------------------------------------
+void SortedQueryCache::Invalidate(size_t slot)
+{
+	// entries are removed lazily by Update(), token makes the entry invalid even if the entity is matched again
+	Tokens[slot] = 0;
+	++StaleCount;
+}
+
+//------------------------------------------------------------------------------
+void SortedQueryCache::Update(uint32_t changedSince)
+{
+	std::lock_guard<std::mutex> lock(UpdateMutex);
+
+	// entities with changed keys leave their place and are merged again with new ones
+	for (const Entry& entry : Entries)
+	{
+		if (!IsValid(entry))
+			continue;
+		const ComponentBase* component = entry.Ent->GetComponentById(KeyComponentID);
+		if (component->GetChangeVersion() <= changedSince)
+			continue;
+		const uint64_t key = Key(component);
+		if (key == entry.Key)
+			continue;
+		Invalidate(entry.Slot);
+		Tokens[entry.Slot] = NextToken++;
+		Pending.PushBack(Entry{ key, entry.Slot, Tokens[entry.Slot], entry.Ent });
+	}
+
+	if (StaleCount == 0 && Pending.IsEmpty())
+		return;
+
+	if (StaleCount > 0)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < Entries.GetSize(); ++i)
+			if (IsValid(Entries[i]))
+				Entries[count++] = Entries[i];
+		Entries.Resize(count);
+		StaleCount = 0;
+	}
+
+	// entities can be removed before they were merged
+	const size_t sortedCount = Entries.GetSize();
+	for (Entry& entry : Pending)
+	{
+		if (!IsValid(entry))
+			continue;
+		entry.Key = Key(entry.Ent->GetComponentById(KeyComponentID));
+		Entries.PushBack(entry);
+	}
+	Pending.Clear();
+	Entry* entries = Entries.GetData();
+	std::sort(entries + sortedCount, entries + Entries.GetSize());
+	std::inplace_merge(entries, entries + sortedCount, entries + Entries.GetSize());
+
+	Entities.Resize(Entries.GetSize());
+	for (size_t i = 0; i < Entries.GetSize(); ++i)
+		Entities[i] = Entries[i].Ent;
+}
+
+//------------------------------------------------------------------------------
+QueryCursor QueryCursor::FromPool(const QueryFilter& filter, const IterablePoolAllocatorBase* pool, bool atEnd)
+{
+	QueryCursor cursor;
+	cursor.Source = eSource::POOL;
+	cursor.Filter = filter;
+	cursor.Pool = pool;
+	if (!pool)
+		return cursor;
+
+	cursor.Index = atEnd ? pool->GetCapacity() : pool->NextOccupied(0);
+	cursor.SkipNotMatching();
+	return cursor;
+}
+
+//------------------------------------------------------------------------------
+QueryCursor QueryCursor::FromEntities(const QueryFilter& filter, const Dynarray<Entity*>* entities, bool atEnd)
+{
+	QueryCursor cursor;
+	cursor.Source = eSource::ENTITIES;
+	cursor.Filter = filter;
+	cursor.Entities = entities;
+	cursor.Index = atEnd ? entities->GetSize() : 0;
+	cursor.SkipNotMatching();
+	return cursor;
+}
+
+//------------------------------------------------------------------------------
+QueryCursor QueryCursor::FromArchetypes(const QueryFilter& filter, const Dynarray<Archetype*>* archetypes, bool atEnd)
+{
+	QueryCursor cursor;
+	cursor.Source = eSource::ARCHETYPES;
+	cursor.Filter = filter;
+	cursor.Archetypes = archetypes;
+	cursor.Index = atEnd ? archetypes->GetSize() : 0;
+	cursor.SkipNotMatching();
+	return cursor;
+}
+
+//------------------------------------------------------------------------------
+Entity* QueryCursor::GetEntity() const
+{
+	switch (Source)
+	{
+	case eSource::POOL:
+		return static_cast<const ComponentBase*>(Pool->GetCell(Index))->Owner;
+	case eSource::ENTITIES:
+		return (*Entities)[Index];
+	case eSource::ARCHETYPES:
+		return (*Archetypes)[Index]->GetEntity(Row);
+	default:
+		ASSERTE(false, "Invalid query cursor source!");
+		return nullptr;
+	}
+}
+
+//------------------------------------------------------------------------------
+void QueryCursor::Next()
+{
+	switch (Source)
+	{
+	case eSource::POOL:
+		Index = Pool->NextOccupied(Index + 1);
+		break;
+	case eSource::ENTITIES:
+		++Index;
+		break;
+	case eSource::ARCHETYPES:
+		++Row;
+		break;
+	default:
+		ASSERTE(false, "Invalid query cursor source!");
+	}
+	SkipNotMatching();
+}
+
+//------------------------------------------------------------------------------
+void QueryCursor::SkipNotMatching()
+{
+	if (Source == eSource::POOL)
+	{
+		// components are stored with ComponentBase at offset 0, so the owner can be read without knowing the type
+		while (Index < Pool->GetCapacity())
+		{
+			const Entity* owner = static_cast<const ComponentBase*>(Pool->GetCell(Index))->Owner;
+			if (Filter.Matches(owner->ComponentPosessionFlags) && Filter.IsChanged(owner))
+				break;
+			Index = Pool->NextOccupied(Index + 1);
+		}
+	}
+	else if (Source == eSource::ENTITIES)
+	{
+		// entities were matched by the cache, only changes are left to check
+		if (Filter.Changed.any())
+			while (Index < Entities->GetSize() && !Filter.IsChanged((*Entities)[Index]))
+				++Index;
+	}
+	else if (Source == eSource::ARCHETYPES)
+	{
+		for (;;)
+		{
+			// whole archetype either matches or not, only its rows are visited
+			while (Index < Archetypes->GetSize() && (Row >= (*Archetypes)[Index]->GetSize() || !Filter.Matches((*Archetypes)[Index]->GetSignature())))
+			{
+				++Index;
+				Row = 0;
+			}
+			if (Index == Archetypes->GetSize() || Filter.Changed.none())
+				return;
+
+			// chunks that were not modified are skipped as a whole
+			const Archetype* archetype = (*Archetypes)[Index];
+			if (archetype->GetChunkChangeVersion(Row) <= Filter.ChangedSince)
+				Row = (Row / archetype->GetChunkCapacity() + 1) * archetype->GetChunkCapacity();
+			else if (!Filter.IsChanged(archetype->GetEntity(Row)))
+				++Row;
+			else
+				return;
+		}
+	}
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <Core.hpp>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include "Entity.hpp"
+#include "Archetype.hpp"
+
+namespace Poly
+{
+	/// <summary>Query filter. Matched entities must own all listed components, pointers to them are returned.</summary>
+	/// <see cref="World.Query()"/>
+	template<typename... Components> struct With {};
+
+	/// <summary>Query filter. Listed components are returned when entity owns them, nullptr otherwise. They do not affect matching.</summary>
+	/// <see cref="World.Query()"/>
+	template<typename... Components> struct Optional {};
+
+	/// <summary>Query filter. Entities owning any of listed components are skipped.</summary>
+	/// <see cref="World.Query()"/>
+	template<typename... Components> struct Without {};
+
+	/// <summary>Query filter. Same as With, but entities are visited only when any of listed components
+	/// was modified after the version passed to the query.</summary>
+	/// <see cref="World.Query()"/>
+	/// <see cref="ComponentBase.MarkChanged()"/>
+	template<typename... Components> struct Changed {};
+
+	/// <summary>Component masks that entities are matched against.</summary>
+	struct ENGINE_DLLEXPORT QueryFilter : public BaseObjectLiteralType<>
+	{
+		ComponentSignature Required;
+		ComponentSignature Excluded;
+		// Subset of Required, at least one of these has to be changed after ChangedSince
+		ComponentSignature Changed;
+		uint32_t ChangedSince = 0;
+
+		bool Matches(const ComponentSignature& signature) const { return (signature & Required) == Required && (signature & Excluded).none(); }
+
+		/// <summary>Checks Changed part of the filter for an entity that matches the rest of it.</summary>
+		bool IsChanged(const Entity* entity) const;
+
+		/// <summary>Compares component masks, ChangedSince is a parameter of a single query, so it is ignored.</summary>
+		bool operator==(const QueryFilter& rhs) const { return Required == rhs.Required && Excluded == rhs.Excluded && Changed == rhs.Changed; }
+		bool operator!=(const QueryFilter& rhs) const { return !(*this == rhs); }
+	};
+
+	/// <summary>Incrementally updated results of a query. Owned by world, which notifies it about every structural change.
+	/// With pool storage the list of matched entities is kept, with archetype storage the list of matched archetypes.</summary>
+	/// <see cref="World.CachedQuery()"/>
+	class ENGINE_DLLEXPORT QueryCache : public BaseObject<>
+	{
+	public:
+		explicit QueryCache(const QueryFilter& filter) : Filter(filter) {}
+
+		const QueryFilter& GetFilter() const { return Filter; }
+		const Dynarray<Entity*>& GetEntities() const { return Entities; }
+		const Dynarray<Archetype*>& GetArchetypes() const { return Archetypes; }
+
+		/// <summary>Stores change version of the current call and returns the one stored by the previous call.</summary>
+		uint32_t ExchangeChangeVersion(uint32_t version) { return LastChangeVersion.exchange(version, std::memory_order_relaxed); }
+
+		/// <summary>Called after components of the entity changed. Adds or removes the entity from results.</summary>
+		void OnEntityChanged(Entity* entity);
+
+		/// <summary>Called before the entity is destroyed.</summary>
+		void OnEntityDestroyed(Entity* entity);
+
+		/// <summary>Called after new archetype was created.</summary>
+		void OnArchetypeCreated(Archetype* archetype);
+
+	private:
+		void RemoveEntity(size_t slot);
+
+		QueryFilter Filter;
+		Dynarray<Entity*> Entities;
+		// Indexed by entity slot index. Position of the entity in Entities plus one, zero if entity is not matched.
+		Dynarray<size_t> EntityPositions;
+		Dynarray<Archetype*> Archetypes;
+		std::atomic<uint32_t> LastChangeVersion{ 0 };
+	};
+
+	/// <summary>Incrementally updated results of a query kept in order of a sort key computed from one of the required components.
+	/// Owned by world, which notifies it about every structural change. Works the same way with both component storages.</summary>
+	/// <para>New entities are sorted and merged into the order, removed ones are dropped and entities whose key component
+	/// was marked changed get their key recomputed, so a frame with few changes costs a pass over change versions instead of a full sort.
+	/// Entities with equal keys are ordered by slot index.</para>
+	/// <see cref="World.SortedQuery()"/>
+	class ENGINE_DLLEXPORT SortedQueryCache : public BaseObject<>
+	{
+	public:
+		typedef std::function<uint64_t(const ComponentBase*)> KeyFunction;
+		// Identity of the function the key was created from, used to find the cache again
+		typedef void (*KeyFunctionID)();
+
+		SortedQueryCache(const QueryFilter& filter, size_t keyComponentID, KeyFunctionID keyID, const KeyFunction& key)
+			: Filter(filter), KeyComponentID(keyComponentID), KeyID(keyID), Key(key) {}
+
+		const QueryFilter& GetFilter() const { return Filter; }
+		bool IsSortedBy(size_t keyComponentID, KeyFunctionID keyID) const { return KeyComponentID == keyComponentID && KeyID == keyID; }
+
+		/// <summary>Returns matched entities in order of their keys. Valid after Update() until the next structural change.</summary>
+		const Dynarray<Entity*>& GetEntities() const { return Entities; }
+
+		/// <summary>Stores change version of the current call and returns the one stored by the previous call.</summary>
+		uint32_t ExchangeChangeVersion(uint32_t version) { return LastChangeVersion.exchange(version, std::memory_order_relaxed); }
+
+		/// <summary>Called after components of the entity changed. Adds or removes the entity from results.</summary>
+		void OnEntityChanged(Entity* entity);
+
+		/// <summary>Called before the entity is destroyed.</summary>
+		void OnEntityDestroyed(Entity* entity);
+
+		/// <summary>Brings the order up to date: recomputes keys of components changed after changedSince,
+		/// drops removed entities and merges added ones.</summary>
+		void Update(uint32_t changedSince);
+
+	private:
+		struct Entry
+		{
+			uint64_t Key;
+			size_t Slot;
+			// Entry is valid as long as its token is the current token of the slot
+			uint32_t Token;
+			Entity* Ent;
+
+			bool operator<(const Entry& rhs) const { return Key < rhs.Key || (Key == rhs.Key && Slot < rhs.Slot); }
+		};
+
+		void Invalidate(size_t slot);
+		bool IsValid(const Entry& entry) const { return Tokens[entry.Slot] == entry.Token; }
+
+		QueryFilter Filter;
+		const size_t KeyComponentID;
+		const KeyFunctionID KeyID;
+		KeyFunction Key;
+
+		Dynarray<Entry> Entries;
+		Dynarray<Entity*> Entities;
+		// Indexed by entity slot index. Token of the valid entry of the entity, zero if entity is not matched.
+		Dynarray<uint32_t> Tokens;
+		uint32_t NextToken = 1;
+		// Entries that are not in the order yet, their keys are computed by Update()
+		Dynarray<Entry> Pending;
+		size_t StaleCount = 0;
+		std::atomic<uint32_t> LastChangeVersion{ 0 };
+		// Queries of the same cache can be run by concurrent update phases
+		std::mutex UpdateMutex;
+	};
+
+	/// <summary>Type independent position in results of a query. Visits only entities that match the filter.</summary>
+	class ENGINE_DLLEXPORT QueryCursor : public BaseObjectLiteralType<>
+	{
+	public:
+		QueryCursor() = default;
+
+		/// <summary>Cursor that scans all components in a pool and checks their owners against the filter.</summary>
+		/// <param name="pool">Pool to scan. Can be null, which means there is nothing to visit.</param>
+		static QueryCursor FromPool(const QueryFilter& filter, const IterablePoolAllocatorBase* pool, bool atEnd);
+
+		/// <summary>Cursor over already matched entities. Only Changed part of the filter is checked.</summary>
+		static QueryCursor FromEntities(const QueryFilter& filter, const Dynarray<Entity*>* entities, bool atEnd);
+
+		/// <summary>Cursor over all rows of archetypes that match the filter.</summary>
+		static QueryCursor FromArchetypes(const QueryFilter& filter, const Dynarray<Archetype*>* archetypes, bool atEnd);
+
+		bool operator==(const QueryCursor& rhs) const { return Index == rhs.Index && Row == rhs.Row; }
+		bool operator!=(const QueryCursor& rhs) const { return !(*this == rhs); }
+
+		Entity* GetEntity() const;
+		void Next();
+
+	private:
+		enum class eSource
+		{
+			POOL,
+			ENTITIES,
+			ARCHETYPES,
+			_COUNT
+		};
+
+		void SkipNotMatching();
+
+		eSource Source = eSource::POOL;
+		QueryFilter Filter;
+		const IterablePoolAllocatorBase* Pool = nullptr;
+		const Dynarray<Entity*>* Entities = nullptr;
+		const Dynarray<Archetype*>* Archetypes = nullptr;
+		size_t Index = 0;	// pool cell, entity or archetype index
+		size_t Row = 0;		// row in archetype
+	};
+
+	namespace Impl
+	{
+		template<typename... Types> struct TypeList {};
+
+		template<typename A, typename B> struct ConcatTypeLists;
+		template<typename... A, typename... B> struct ConcatTypeLists<TypeList<A...>, TypeList<B...>> { typedef TypeList<A..., B...> Type; };
+
+		template<typename... Types> struct AreChangeTracked : std::true_type {};
+		template<typename T, typename... Rest> struct AreChangeTracked<T, Rest...>
+			: std::integral_constant<bool, ComponentTraits<T>::Kind == eComponentKind::REGULAR && AreChangeTracked<Rest...>::value> {};
+
+		template<typename Filter> struct QueryFilterTraits;
+		template<typename... Types> struct QueryFilterTraits<With<Types...>> { typedef TypeList<Types...> Required; typedef TypeList<> Optional; typedef TypeList<> Excluded; typedef TypeList<> Changed; };
+		template<typename... Types> struct QueryFilterTraits<Optional<Types...>> { typedef TypeList<> Required; typedef TypeList<Types...> Optional; typedef TypeList<> Excluded; typedef TypeList<> Changed; };
+		template<typename... Types> struct QueryFilterTraits<Without<Types...>> { typedef TypeList<> Required; typedef TypeList<> Optional; typedef TypeList<Types...> Excluded; typedef TypeList<> Changed; };
+		template<typename... Types> struct QueryFilterTraits<Changed<Types...>>
+		{
+			STATIC_ASSERTE(AreChangeTracked<Types...>::value, "Only components deriving from ComponentBase have change versions.");
+			typedef TypeList<Types...> Required; typedef TypeList<> Optional; typedef TypeList<> Excluded; typedef TypeList<Types...> Changed;
+		};
+
+		/// <summary>Collects component types from all filters of a query.</summary>
+		template<typename... Filters> struct QueryTraits
+		{
+			typedef TypeList<> Required;
+			typedef TypeList<> Optional;
+			typedef TypeList<> Excluded;
+			typedef TypeList<> Changed;
+		};
+
+		template<typename Filter, typename... Rest> struct QueryTraits<Filter, Rest...>
+		{
+			typedef typename ConcatTypeLists<typename QueryFilterTraits<Filter>::Required, typename QueryTraits<Rest...>::Required>::Type Required;
+			typedef typename ConcatTypeLists<typename QueryFilterTraits<Filter>::Optional, typename QueryTraits<Rest...>::Optional>::Type Optional;
+			typedef typename ConcatTypeLists<typename QueryFilterTraits<Filter>::Excluded, typename QueryTraits<Rest...>::Excluded>::Type Excluded;
+			typedef typename ConcatTypeLists<typename QueryFilterTraits<Filter>::Changed, typename QueryTraits<Rest...>::Changed>::Type Changed;
+		};
+
+		template<typename... Types> ComponentSignature MakeSignature(TypeList<Types...>)
+		{
+			ComponentSignature signature;
+			int expand[] = { 0, (signature.set(gEngine->GetComponentID<Types>()), 0)... };
+			UNUSED(expand);
+			return signature;
+		}
+
+		template<typename... Filters> QueryFilter MakeQueryFilter()
+		{
+			QueryFilter filter;
+			filter.Required = MakeSignature(typename QueryTraits<Filters...>::Required());
+			filter.Excluded = MakeSignature(typename QueryTraits<Filters...>::Excluded());
+			filter.Changed = MakeSignature(typename QueryTraits<Filters...>::Changed());
+			return filter;
+		}
+	}
+
+	template<typename Required, typename Optional> class QueryIterator;
+
+	/// <summary>Iterator over query results. Dereferences to a tuple of pointers to required components followed by optional ones.</summary>
+	template<typename... Required, typename... Optional>
+	class QueryIterator<Impl::TypeList<Required...>, Impl::TypeList<Optional...>> : public BaseObject<>,
+		public std::iterator<std::forward_iterator_tag, std::tuple<typename std::add_pointer<Required>::type..., typename std::add_pointer<Optional>::type...>>
+	{
+	public:
+		typedef std::tuple<typename std::add_pointer<Required>::type..., typename std::add_pointer<Optional>::type...> ValueType;
+		typedef std::array<size_t, sizeof...(Required) + sizeof...(Optional)> ComponentIDs;
+
+		bool operator==(const QueryIterator& rhs) const { return Cursor == rhs.Cursor; }
+		bool operator!=(const QueryIterator& rhs) const { return !(*this == rhs); }
+
+		ValueType operator*() const { return Get(std::index_sequence_for<Required..., Optional...>()); }
+		ValueType operator->() const { return **this; }
+
+		QueryIterator& operator++() { Cursor.Next(); return *this; }
+		QueryIterator operator++(int) { QueryIterator ret(*this); Cursor.Next(); return ret; }
+
+		/// <summary>Returns the entity owning current components.</summary>
+		EntityID GetEntityID() const { return Cursor.GetEntity()->GetID(); }
+
+	private:
+		QueryIterator(const QueryCursor& cursor, const ComponentIDs& ids) : Cursor(cursor), IDs(ids) {}
+
+		template<size_t... Idx> ValueType Get(std::index_sequence<Idx...>) const
+		{
+			const Entity* entity = Cursor.GetEntity();
+			return ValueType(Impl::ComponentCast<typename std::remove_pointer<typename std::tuple_element<Idx, ValueType>::type>::type>(entity->GetComponentById(IDs[Idx]))...);
+		}
+
+		QueryCursor Cursor;
+		ComponentIDs IDs;
+
+		template<typename... Filters> friend class QueryResult;
+	};
+
+	/// <summary>Results of a query. Can be used in range-for loop.</summary>
+	/// <see cref="World.Query()"/>
+	template<typename... Filters>
+	class QueryResult : public BaseObject<>
+	{
+		typedef Impl::QueryTraits<Filters...> Traits;
+	public:
+		typedef QueryIterator<typename Traits::Required, typename Traits::Optional> Iterator;
+
+		Iterator Begin() const { return Iterator(BeginCursor, IDs); }
+		Iterator End() const { return Iterator(EndCursor, IDs); }
+		Iterator begin() const { return Begin(); }
+		Iterator end() const { return End(); }
+
+	private:
+		QueryResult(const QueryCursor& begin, const QueryCursor& end)
+			: BeginCursor(begin), EndCursor(end)
+		{
+			FillIDs(typename Traits::Required(), typename Traits::Optional());
+		}
+
+		template<typename... Required, typename... Optional> void FillIDs(Impl::TypeList<Required...>, Impl::TypeList<Optional...>)
+		{
+			STATIC_ASSERTE(sizeof...(Required) > 0, "Query needs at least one required component.");
+			IDs = {{ gEngine->GetComponentID<Required>()..., gEngine->GetComponentID<Optional>()... }};
+		}
+
+		QueryCursor BeginCursor;
+		QueryCursor EndCursor;
+		typename Iterator::ComponentIDs IDs;
+
+		friend class World;
+	};
+}
@@ -11,6 +11,24 @@ DEFINE_RESOURCE(MeshResource, gMeshResourcesMap)
 DEFINE_RESOURCE(TextureResource, gTextureResourcesMap)
 DEFINE_RESOURCE(FontResource, gFontResourcesMap)
 
+//------------------------------------------------------------------------------
+std::mutex& Poly::Impl::GetResourcesMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+//------------------------------------------------------------------------------
+void Poly::Impl::DestroyOnMainThread(const std::function<void()>& destroy)
+{
+	// resources can be used without engine, e.g. in tools and tests
+	if (gEngine)
+		gEngine->RunOnMainThread(destroy);
+	else
+		destroy();
+}
+
+//------------------------------------------------------------------------------
 
 const String& Poly::GetResourcesAbsolutePath()
 {
@@ -7,6 +7,8 @@
 #include "ResourceBase.hpp"
 
 #include <map>
+#include <mutex>
+#include <functional>
 
 namespace Poly
 {
@@ -16,7 +18,16 @@ namespace Poly
 
 	ENGINE_DLLEXPORT const String& GetResourcesAbsolutePath();
 
-	namespace Impl { template<typename T> std::map<String, std::unique_ptr<T>>& GetResources(); }
+	namespace Impl
+	{
+		template<typename T> std::map<String, std::unique_ptr<T>>& GetResources();
+
+		// Guards resource maps and reference counts, resources can be loaded by world loader thread
+		ENGINE_DLLEXPORT std::mutex& GetResourcesMutex();
+
+		// Resources own rendering device objects, so they are destroyed on the main thread
+		ENGINE_DLLEXPORT void DestroyOnMainThread(const std::function<void()>& destroy);
+	}
 
 #define DECLARE_RESOURCE(type, map_name) \
 	namespace Impl { \
@@ -38,17 +49,11 @@ namespace Poly
 		//------------------------------------------------------------------------------
 		static T* Load(const String& relativePath, bool absolute = true)
 		{
-			auto it = Impl::GetResources<T>().find(relativePath);
-
 			// Check if it is already loaded
-			if (it != Impl::GetResources<T>().end())
-			{
-				T* resource = it->second.get();
-				resource->AddRef();
+			if (T* resource = FindAndAddRef(relativePath))
 				return resource;
-			}
 
-			// Load the resource
+			// Load the resource, lock is not held here as loading can take long and wait for the main thread
 			T* resource = nullptr;
 			try {
 				//TODO create wrapper for path
@@ -74,6 +79,17 @@ namespace Poly
 				return nullptr;
 			}
 
+			std::unique_lock<std::mutex> lock(Impl::GetResourcesMutex());
+			auto it = Impl::GetResources<T>().find(relativePath);
+			if (it != Impl::GetResources<T>().end())
+			{
+				// other thread loaded the same resource meanwhile
+				T* loaded = it->second.get();
+				loaded->AddRef();
+				lock.unlock();
+				Impl::DestroyOnMainThread([resource]() { delete resource; });
+				return loaded;
+			}
 			Impl::GetResources<T>().insert(std::make_pair(relativePath, std::unique_ptr<T>(resource)));
 			resource->Path = relativePath;
 			resource->AddRef();
@@ -83,12 +99,30 @@ namespace Poly
 		//------------------------------------------------------------------------------
 		static void Release(T* resource)
 		{
-			if (resource->RemoveRef())
+			std::unique_ptr<T> released;
 			{
+				std::lock_guard<std::mutex> lock(Impl::GetResourcesMutex());
+				if (!resource->RemoveRef())
+					return;
 				auto it = Impl::GetResources<T>().find(resource->GetPath());
 				HEAVY_ASSERTE(it != Impl::GetResources<T>().end(), "Resource creation failed!");
+				released = std::move(it->second);
 				Impl::GetResources<T>().erase(it);
 			}
+			Impl::DestroyOnMainThread([&released]() { released.reset(); });
+		}
+
+	private:
+		//------------------------------------------------------------------------------
+		static T* FindAndAddRef(const String& relativePath)
+		{
+			std::lock_guard<std::mutex> lock(Impl::GetResourcesMutex());
+			auto it = Impl::GetResources<T>().find(relativePath);
+			if (it == Impl::GetResources<T>().end())
+				return nullptr;
+			T* resource = it->second.get();
+			resource->AddRef();
+			return resource;
 		}
 	};	
 }
@@ -0,0 +1,48 @@
+#include "EnginePCH.hpp"
+
+#include "SystemScheduler.hpp"
+
+using namespace Poly;
+
+//------------------------------------------------------------------------------
+bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+{
+	if (ExclusiveAccess || other.ExclusiveAccess)
+		return true;
+
+	return (WrittenComponents & (other.ReadComponents | other.WrittenComponents)).any()
+		|| (other.WrittenComponents & ReadComponents).any()
+		|| (WrittenWorldComponents & (other.ReadWorldComponents | other.WrittenWorldComponents)).any()
+		|| (other.WrittenWorldComponents & ReadWorldComponents).any();
+}
+
+//------------------------------------------------------------------------------
+void SystemScheduler::AddSystem(const PhaseUpdateFunction& function, const SystemAccess& access)
+{
+	System system;
+	system.Function = function;
+	system.Access = access;
+
+	// run after every conflicting system registered earlier, so their relative order is preserved
+	for (const System& earlier : Systems)
+		if (access.ConflictsWith(earlier.Access))
+			system.Level = std::max(system.Level, earlier.Level + 1);
+
+	if (system.Level == Levels.GetSize())
+		Levels.PushBack(Dynarray<size_t>());
+	Levels[system.Level].PushBack(Systems.GetSize());
+	Systems.PushBack(system);
+}
+
+//------------------------------------------------------------------------------
+void SystemScheduler::Execute(World* world, ThreadPool* pool) const
+{
+	for (const Dynarray<size_t>& level : Levels)
+	{
+		// exclusive systems are always alone in their level, so they run on the calling thread
+		if (level.GetSize() == 1)
+			Systems[level[0]].Function(world);
+		else
+			pool->Run(level.GetSize(), [this, &level, world](size_t i) { Systems[level[i]].Function(world); });
+	}
+}
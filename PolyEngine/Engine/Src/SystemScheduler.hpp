@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Core.hpp>
+#include <ThreadPool.hpp>
+
+#include "World.hpp"
+
+namespace Poly
+{
+	/// <summary>Declaration of components and world components that an update phase function reads and writes.
+	/// Functions that access the same data and at least one of them writes it are never executed concurrently.
+	/// Reading has to be free of side effects, e.g. lazily cached transformations of TransformComponent have to be declared as written.
+	/// Structural changes of the world (spawning, destroying, adding or removing components) are allowed only in exclusive functions,
+	/// others have to schedule them with DeferredTaskSystem and declare DeferredTaskWorldComponent as written.</summary>
+	/// <see cref="Engine.RegisterGameUpdatePhase()"/>
+	class ENGINE_DLLEXPORT SystemAccess : public BaseObjectLiteralType<>
+	{
+	public:
+		/// <summary>Constructs declaration of a function that does not access any components.</summary>
+		SystemAccess() = default;
+
+		/// <summary>Declaration of a function that can access anything. Such function conflicts with every other one
+		/// and is always executed alone on the thread that calls Engine::Update().</summary>
+		static SystemAccess Exclusive() { SystemAccess access; access.ExclusiveAccess = true; return access; }
+
+		template<typename... Components> SystemAccess& Read() { int expand[] = { 0, (ReadComponent(gEngine->GetComponentID<Components>()), 0)... }; UNUSED(expand); return *this; }
+		template<typename... Components> SystemAccess& Write() { int expand[] = { 0, (WriteComponent(gEngine->GetComponentID<Components>()), 0)... }; UNUSED(expand); return *this; }
+		template<typename... Components> SystemAccess& ReadWorld() { int expand[] = { 0, (ReadWorldComponent(gEngine->GetWorldComponentID<Components>()), 0)... }; UNUSED(expand); return *this; }
+		template<typename... Components> SystemAccess& WriteWorld() { int expand[] = { 0, (WriteWorldComponent(gEngine->GetWorldComponentID<Components>()), 0)... }; UNUSED(expand); return *this; }
+
+		SystemAccess& ReadComponent(size_t componentID) { ReadComponents.set(componentID); return *this; }
+		SystemAccess& WriteComponent(size_t componentID) { WrittenComponents.set(componentID); return *this; }
+		SystemAccess& ReadWorldComponent(size_t componentID) { ReadWorldComponents.set(componentID); return *this; }
+		SystemAccess& WriteWorldComponent(size_t componentID) { WrittenWorldComponents.set(componentID); return *this; }
+
+		bool IsExclusive() const { return ExclusiveAccess; }
+
+		/// <summary>Checks whether functions with given declarations can not be executed concurrently.</summary>
+		bool ConflictsWith(const SystemAccess& other) const;
+
+	private:
+		bool ExclusiveAccess = false;
+		ComponentSignature ReadComponents;
+		ComponentSignature WrittenComponents;
+		std::bitset<MAX_WORLD_COMPONENTS_COUNT> ReadWorldComponents;
+		std::bitset<MAX_WORLD_COMPONENTS_COUNT> WrittenWorldComponents;
+	};
+
+	/// <summary>Executes update phase functions registered for one part of the update.
+	/// Dependency graph is built at registration: every function depends on all earlier registered functions it conflicts with.
+	/// Functions are grouped into levels of that graph, functions of a single level run concurrently on a thread pool
+	/// and every level starts after the previous one finished.</summary>
+	class ENGINE_DLLEXPORT SystemScheduler : public BaseObject<>
+	{
+	public:
+		/// <summary>Adds function to the schedule.</summary>
+		/// <param name="function">Function to execute.</param>
+		/// <param name="access">Data accessed by the function.</param>
+		void AddSystem(const PhaseUpdateFunction& function, const SystemAccess& access);
+
+		/// <summary>Executes all functions and returns when all of them finished.</summary>
+		/// <param name="world">World passed to the functions.</param>
+		/// <param name="pool">Pool used to execute independent functions concurrently.</param>
+		void Execute(World* world, ThreadPool* pool) const;
+
+		size_t GetSystemCount() const { return Systems.GetSize(); }
+		size_t GetLevelCount() const { return Levels.GetSize(); }
+
+	private:
+		struct System
+		{
+			PhaseUpdateFunction Function;
+			SystemAccess Access;
+			size_t Level = 0;
+		};
+
+		Dynarray<System> Systems;
+		// Indices of systems grouped by level, systems in a single level do not conflict with each other
+		Dynarray<Dynarray<size_t>> Levels;
+	};
+}
@@ -6,6 +6,13 @@
 
 using namespace Poly;
 
+Text2D::Text2D(Text2D&& rhs)
+	: Text(std::move(rhs.Text)), FontName(std::move(rhs.FontName)), FontSize(rhs.FontSize), FontColor(rhs.FontColor), Dirty(rhs.Dirty),
+	TextFieldBufferProxy(std::move(rhs.TextFieldBufferProxy)), Font(rhs.Font)
+{
+	rhs.Font = nullptr;
+}
+
 Text2D::~Text2D()
 {
 	if(Font)
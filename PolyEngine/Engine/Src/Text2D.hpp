@@ -13,6 +13,7 @@ namespace Poly
 	public:
 		Text2D(const String& fontName, size_t fontSize, const String& text = "", const Color& fontColor = Color(1,1,1)) 
 			: Text(text), FontName(fontName), FontSize(fontSize), FontColor(fontColor) {}
+		Text2D(Text2D&& rhs);
 		~Text2D() override;
 
 		void SetText(const String& text) { Text = text; Dirty = true; }
@@ -18,7 +18,7 @@ TextureResource::TextureResource(const String& path)
 
 	// Flip Y axis
 	int rowSize = Width*Channels;
-	static Dynarray<unsigned char> row;
+	Dynarray<unsigned char> row;
 	row.Resize(rowSize);
 	for (int i = 0; i < Height/2; ++i) {
 		memcpy(row.GetData(), Image + ((Height - i - 1) * Width*Channels), sizeof(unsigned char) * rowSize);
@@ -26,8 +26,12 @@ TextureResource::TextureResource(const String& path)
 		memcpy(Image + (i * Width*Channels), row.GetData(), sizeof(unsigned char) * rowSize);
 	}
 
-	TextureProxy = gEngine->GetRenderingDevice()->CreateTexture(Width, Height, eTextureUsageType::DIFFUSE); //HACK, remove deffise from here
-	TextureProxy->SetContent(eTextureDataFormat::RGBA, Image);
+	// textures can be loaded by world loader thread, rendering device is bound to the main thread
+	gEngine->RunOnMainThread([this]()
+	{
+		TextureProxy = gEngine->GetRenderingDevice()->CreateTexture(Width, Height, eTextureUsageType::DIFFUSE); //HACK, remove deffise from here
+		TextureProxy->SetContent(eTextureDataFormat::RGBA, Image);
+	});
 }
 
 //-----------------------------------------------------------------------------
@@ -2,11 +2,42 @@
 
 using namespace Poly;
 
+//-----------------------------------------------------------------------------
+TransformComponent::TransformComponent(TransformComponent&& rhs)
+	: ComponentBase(rhs), Parent(rhs.Parent), FirstChild(rhs.FirstChild), LastChild(rhs.LastChild),
+	PrevSibling(rhs.PrevSibling), NextSibling(rhs.NextSibling), ChildCount(rhs.ChildCount),
+	LocalTranslation(rhs.LocalTranslation), GlobalTranslation(rhs.GlobalTranslation),
+	LocalRotation(rhs.LocalRotation), GlobalRotation(rhs.GlobalRotation),
+	LocalScale(rhs.LocalScale), GlobalScale(rhs.GlobalScale),
+	LocalTransform(rhs.LocalTransform), GlobalTransform(rhs.GlobalTransform),
+	LocalDirty(rhs.LocalDirty), GlobalDirty(rhs.GlobalDirty), GlobalDecompositionDirty(rhs.GlobalDecompositionDirty),
+	DirtyListed(rhs.DirtyListed), UpdateCount(rhs.UpdateCount), ParentUpdateCount(rhs.ParentUpdateCount), CheckedChangeCount(rhs.CheckedChangeCount)
+{
+	if (Parent != nullptr)
+	{
+		(PrevSibling ? PrevSibling->NextSibling : Parent->FirstChild) = this;
+		(NextSibling ? NextSibling->PrevSibling : Parent->LastChild) = this;
+	}
+	for (TransformComponent* c = FirstChild; c; c = c->NextSibling)
+		c->Parent = this;
+	rhs.Parent = rhs.FirstChild = rhs.LastChild = rhs.PrevSibling = rhs.NextSibling = nullptr;
+	rhs.ChildCount = 0;
+	InvalidateHierarchy();
+}
+
 //-----------------------------------------------------------------------------
 TransformComponent::~TransformComponent() {
 	if (Parent != nullptr)
 	{
-		Parent->Children.Remove(this);
+		Parent->UnlinkChild(this);
+	}
+	// world destroys children first, children of a standalone transform or of a removed component become roots
+	while (FirstChild)
+	{
+		TransformComponent* child = FirstChild;
+		UnlinkChild(child);
+		child->MarkChanged();
+		child->SetGlobalDirty();
 	}
 }
 
@@ -15,7 +46,7 @@ void TransformComponent::SetParent(TransformComponent* parent)
 {
 	if (parent != nullptr)
 	{
-		parent->UpdateGlobalTransformationCache();
+		parent->UpdateGlobalDecomposition();
 		LocalTranslation = LocalTranslation - parent->GlobalTranslation;
 		LocalRotation = LocalRotation * parent->GlobalRotation.GetConjugated();
 		Vector parentGlobalScale = parent->GlobalScale;
@@ -24,8 +55,9 @@ void TransformComponent::SetParent(TransformComponent* parent)
 		LocalScale.Z = LocalScale.Z / parentGlobalScale.Z;
 		UpdateLocalTransformationCache();
 
-		Parent = parent;
-		Parent->Children.PushBack(this);
+		parent->LinkChild(this);
+		MarkChanged();
+		SetGlobalDirty();
 	}
 	else
 	{
@@ -33,14 +65,83 @@ void TransformComponent::SetParent(TransformComponent* parent)
 	}
 }
 
+//-----------------------------------------------------------------------------
+void TransformComponent::AttachToParent(TransformComponent* parent)
+{
+	HEAVY_ASSERTE(parent && !Parent, "Transform is already attached!");
+	parent->LinkChild(this);
+	MarkChanged();
+	SetGlobalDirty();
+}
+
+//-----------------------------------------------------------------------------
+void TransformComponent::DetachFromParent()
+{
+	HEAVY_ASSERTE(Parent, "Transform is not attached!");
+	Parent->UnlinkChild(this);
+	MarkChanged();
+	SetGlobalDirty();
+}
+
 //-----------------------------------------------------------------------------
 void TransformComponent::ResetParent()
 {
 	ASSERTE(Parent, "ResetParent() called with parent == nullptr");
-	Matrix globalTransform = GetGlobalTransformationMatrix();
-	Parent->Children.Remove(this);
-	Parent = nullptr;
-	SetLocalTransformationMatrix(globalTransform);
+	AffineMatrix globalTransform = GetGlobalTransformation();
+	Parent->UnlinkChild(this);
+	SetLocalTransformation(globalTransform);
+}
+
+//-----------------------------------------------------------------------------
+Dynarray<TransformComponent*> TransformComponent::GetChildren() const
+{
+	Dynarray<TransformComponent*> children(ChildCount);
+	for (TransformComponent* c = FirstChild; c; c = c->NextSibling)
+		children.PushBack(c);
+	return children;
+}
+
+//-----------------------------------------------------------------------------
+TransformComponent* TransformComponent::GetNextInSubtree(const TransformComponent* node, const TransformComponent* root)
+{
+	if (node->FirstChild)
+		return node->FirstChild;
+	// climb until a node with next sibling is found, without leaving the subtree
+	while (node != root && !node->NextSibling)
+		node = node->Parent;
+	return node == root ? nullptr : node->NextSibling;
+}
+
+//-----------------------------------------------------------------------------
+void TransformComponent::LinkChild(TransformComponent* child)
+{
+	HEAVY_ASSERTE(!child->Parent, "Child is already attached!");
+	child->Parent = this;
+	child->PrevSibling = LastChild;
+	child->NextSibling = nullptr;
+	(LastChild ? LastChild->NextSibling : FirstChild) = child;
+	LastChild = child;
+	++ChildCount;
+	InvalidateHierarchy();
+}
+
+//-----------------------------------------------------------------------------
+void TransformComponent::UnlinkChild(TransformComponent* child)
+{
+	HEAVY_ASSERTE(child->Parent == this, "Not a child of this transform!");
+	(child->PrevSibling ? child->PrevSibling->NextSibling : FirstChild) = child->NextSibling;
+	(child->NextSibling ? child->NextSibling->PrevSibling : LastChild) = child->PrevSibling;
+	child->Parent = child->PrevSibling = child->NextSibling = nullptr;
+	--ChildCount;
+	InvalidateHierarchy();
+}
+
+//-----------------------------------------------------------------------------
+void TransformComponent::InvalidateHierarchy() const
+{
+	// standalone transforms have no world to notify
+	if (World* world = GetWorld())
+		world->GetTransformHierarchy().Invalidate();
 }
 
 //------------------------------------------------------------------------------
@@ -55,13 +156,14 @@ void TransformComponent::SetLocalTranslation(const Vector& position)
 {
 	LocalTranslation = position;
 	LocalDirty = true;
+	MarkChanged();
 	SetGlobalDirty();
 }
 
 //------------------------------------------------------------------------------
 const Quaternion& TransformComponent::GetGlobalRotation() const
 {
-	UpdateGlobalTransformationCache();
+	UpdateGlobalDecomposition();
 	return GlobalRotation;
 }
 
@@ -70,13 +172,14 @@ void TransformComponent::SetLocalRotation(const Quaternion& quaternion)
 {
 	LocalRotation = quaternion;
 	LocalDirty = true;
+	MarkChanged();
 	SetGlobalDirty();
 }
 
 //------------------------------------------------------------------------------
 const Vector& TransformComponent::GetGlobalScale() const
 {
-	UpdateGlobalTransformationCache();
+	UpdateGlobalDecomposition();
 	return GlobalScale;
 }
 
@@ -85,29 +188,31 @@ void TransformComponent::SetLocalScale(const Vector& scale)
 {
 	LocalScale = scale;
 	LocalDirty = true;
+	MarkChanged();
 	SetGlobalDirty();
 }
 
 //------------------------------------------------------------------------------
-const Matrix& TransformComponent::GetLocalTransformationMatrix() const
+const AffineMatrix& TransformComponent::GetLocalTransformation() const
 {
 	UpdateLocalTransformationCache();
 	return LocalTransform;
 }
 
 //------------------------------------------------------------------------------
-const Matrix& TransformComponent::GetGlobalTransformationMatrix() const
+const AffineMatrix& TransformComponent::GetGlobalTransformation() const
 {
 	UpdateGlobalTransformationCache();
 	return GlobalTransform;
 }
 
 //------------------------------------------------------------------------------
-void TransformComponent::SetLocalTransformationMatrix(const Matrix& localTransformation)
+void TransformComponent::SetLocalTransformation(const AffineMatrix& localTransformation)
 {
 	LocalTransform = localTransformation;
 	localTransformation.Decompose(LocalTranslation, LocalRotation, LocalScale);
 	LocalDirty = false;
+	MarkChanged();
 	SetGlobalDirty();
 }
 
@@ -116,12 +221,7 @@ bool TransformComponent::UpdateLocalTransformationCache() const
 {
 	if (LocalDirty)
 	{
-		Matrix translation;
-		Matrix rotation = LocalRotation.ToRotationMatrix();
-		Matrix scale;
-		translation.SetTranslation(LocalTranslation);
-		scale.SetScale(LocalScale);
-		LocalTransform = translation * rotation * scale;
+		LocalTransform = AffineMatrix(LocalTranslation, LocalRotation, LocalScale);
 		LocalDirty = false;
 		return true;
 	}
@@ -131,25 +231,81 @@ bool TransformComponent::UpdateLocalTransformationCache() const
 //------------------------------------------------------------------------------
 void TransformComponent::UpdateGlobalTransformationCache() const
 {
-	if (!GlobalDirty) return;
+	// after TransformUpdatePhase all transforms of a world stay valid until something changes
+	World* world = GetWorld();
+	const uint64_t changeCount = world ? world->GetTransformHierarchy().GetChangeCount() : 0;
+	if (world && (CheckedChangeCount == changeCount || world->GetTransformHierarchy().AreGlobalTransformationsValid(changeCount)))
+		return;
+
+	if (Parent != nullptr)
+		Parent->UpdateGlobalTransformationCache();
+	UpdateGlobalFromParent();
+	CheckedChangeCount = changeCount;
+}
+
+//------------------------------------------------------------------------------
+bool TransformComponent::UpdateGlobalFromParent() const
+{
+	if (!GlobalDirty && (Parent == nullptr || ParentUpdateCount == Parent->UpdateCount))
+		return false;
+
 	if (Parent == nullptr)
 	{
-		GlobalTransform = GetLocalTransformationMatrix();
+		GlobalTransform = GetLocalTransformation();
 	}
 	else
 	{
-		GlobalTransform = Parent->GetGlobalTransformationMatrix() * GetLocalTransformationMatrix();
+		GlobalTransform = Parent->GlobalTransform * GetLocalTransformation();
+		ParentUpdateCount = Parent->UpdateCount;
 	}
-	GlobalTransform.Decompose(GlobalTranslation, GlobalRotation, GlobalScale);
+	GlobalTranslation = GlobalTransform.GetTranslation();
+	GlobalDecompositionDirty = true;
 	GlobalDirty = false;
+	++UpdateCount;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void TransformComponent::UpdateGlobalDecomposition() const
+{
+	UpdateGlobalTransformationCache();
+	if (!GlobalDecompositionDirty) return;
+	if (Parent == nullptr)
+	{
+		GlobalRotation = LocalRotation;
+		GlobalScale = LocalScale;
+	}
+	else if (!Parent->GlobalDecompositionDirty && Cmpf(Parent->GlobalScale.X, Parent->GlobalScale.Y) && Cmpf(Parent->GlobalScale.Y, Parent->GlobalScale.Z))
+	{
+		// uniform scale commutes with rotation, so global rotation and scale are composed separately without decomposing the matrix
+		GlobalRotation = Parent->GlobalRotation * LocalRotation;
+		GlobalScale = Vector(Parent->GlobalScale.X * LocalScale.X, Parent->GlobalScale.Y * LocalScale.Y, Parent->GlobalScale.Z * LocalScale.Z);
+	}
+	else
+	{
+		Vector translation;
+		GlobalTransform.Decompose(translation, GlobalRotation, GlobalScale);
+	}
+	GlobalDecompositionDirty = false;
 }
 
 //------------------------------------------------------------------------------
 void TransformComponent::SetGlobalDirty() const
 {
+	// repeated changes before the next TransformUpdatePhase cost nothing
+	if (GlobalDirty && DirtyListed)
+		return;
 	GlobalDirty = true;
-	for (TransformComponent* c : Children)
+
+	// descendants are marked changed and updated by TransformUpdatePhase
+	World* world = GetWorld();
+	if (!world)
+		return;
+	TransformHierarchy& hierarchy = world->GetTransformHierarchy();
+	hierarchy.AddChange();
+	if (!DirtyListed)
 	{
-		c->SetGlobalDirty();
+		DirtyListed = true;
+		hierarchy.AddDirtyRoot(GetOwnerID());
 	}
-}
+}
\ No newline at end of file
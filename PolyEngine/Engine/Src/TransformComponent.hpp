@@ -1,12 +1,19 @@
 #pragma once
 
 #include "ComponentBase.hpp"
+#include "TransformSystem.hpp"
 
 namespace Poly {
 	class ENGINE_DLLEXPORT TransformComponent : public ComponentBase
 	{
+		friend class WorldSerializer;
+		friend class WorldSnapshot;
+		friend class TransformHierarchy;
+		friend void TransformSystem::TransformUpdatePhase(World*);
 	public:
 		TransformComponent(TransformComponent* parent = nullptr) { if(parent) SetParent(parent); };
+		/// <summary>Moves transform to a new address keeping hierarchy links valid. Used by archetype storage.</summary>
+		TransformComponent(TransformComponent&& rhs);
 		~TransformComponent();
 
 		const TransformComponent* GetParent() const { return Parent; }
@@ -26,14 +33,33 @@ namespace Poly {
 		void SetLocalScale(const Vector& scale);
 		void SetLocalScale(float scale) { SetLocalScale(Vector(scale, scale, scale)); };
 
-		const Matrix& GetLocalTransformationMatrix() const;
-		const Matrix& GetGlobalTransformationMatrix() const;
-		void SetLocalTransformationMatrix(const Matrix& localTransformation);
+		const AffineMatrix& GetLocalTransformation() const;
+		const AffineMatrix& GetGlobalTransformation() const;
+		void SetLocalTransformation(const AffineMatrix& localTransformation);
+
+		/// <summary>Returns transformations as 4x4 matrices, prefer GetLocalTransformation() and GetGlobalTransformation(), which return cached values.</summary>
+		Matrix GetLocalTransformationMatrix() const { return GetLocalTransformation().ToMatrix(); }
+		Matrix GetGlobalTransformationMatrix() const { return GetGlobalTransformation().ToMatrix(); }
+		void SetLocalTransformationMatrix(const Matrix& localTransformation) { SetLocalTransformation(AffineMatrix(localTransformation)); }
 		
-		const Dynarray<TransformComponent*>& GetChildren() const { return Children; }
+		/// <summary>Returns list of children in order of attaching. Use GetFirstChild() and GetNextSibling() to visit them without allocation.</summary>
+		Dynarray<TransformComponent*> GetChildren() const;
+		size_t GetChildCount() const { return ChildCount; }
+		const TransformComponent* GetFirstChild() const { return FirstChild; }
+		const TransformComponent* GetNextSibling() const { return NextSibling; }
+
+		/// <summary>Returns transform that follows given one in pre-order walk of the subtree of root, nullptr at the end of the subtree.
+		/// Walking from root->GetFirstChild() visits all descendants of root, every one after its parent.</summary>
+		static TransformComponent* GetNextInSubtree(const TransformComponent* node, const TransformComponent* root);
 	private:
+		// Hierarchy links, children form a doubly linked list, so attaching and detaching are O(1) and need no allocation.
+		// World keeps the same hierarchy flattened by depth in TransformHierarchy.
 		TransformComponent* Parent = nullptr;
-		Dynarray<TransformComponent*> Children;
+		TransformComponent* FirstChild = nullptr;
+		TransformComponent* LastChild = nullptr;
+		TransformComponent* PrevSibling = nullptr;
+		TransformComponent* NextSibling = nullptr;
+		size_t ChildCount = 0;
 
 		Vector LocalTranslation;
 		mutable Vector GlobalTranslation;
@@ -42,13 +68,34 @@ namespace Poly {
 		Vector LocalScale = Vector(1.f, 1.f, 1.f);
 		mutable Vector GlobalScale = Vector(1.f, 1.f, 1.f);
 
-		mutable Matrix LocalTransform;
-		mutable Matrix GlobalTransform;
+		mutable AffineMatrix LocalTransform;
+		mutable AffineMatrix GlobalTransform;
 		mutable bool LocalDirty = false;
+		// Set when local transformation or parent changed. Descendants are not marked, they compare UpdateCount of their parent
+		// with the one they were updated with, which keeps changes O(1) regardless of the subtree size.
 		mutable bool GlobalDirty = false;
+		// Global translation is read from GlobalTransform, global rotation and scale are found only when they are asked for
+		mutable bool GlobalDecompositionDirty = false;
+		// Set while the transform is in the list of changed transforms of its world
+		mutable bool DirtyListed = false;
+		mutable uint32_t UpdateCount = 0;
+		mutable uint32_t ParentUpdateCount = 0;
+		// Change count of the world transform hierarchy the global transformation was validated at
+		mutable uint64_t CheckedChangeCount = 0;
 
 		bool UpdateLocalTransformationCache() const;
 		void UpdateGlobalTransformationCache() const;
+		// Updates global transformation if it is outdated, parent global transformation has to be valid. Returns true if it was updated.
+		bool UpdateGlobalFromParent() const;
+		void UpdateGlobalDecomposition() const;
 		void SetGlobalDirty() const;
+		// Attaches to parent without converting local transformation, which is already relative to it.
+		void AttachToParent(TransformComponent* parent);
+		// Detaches from parent without converting local transformation.
+		void DetachFromParent();
+		// Hierarchy link updates, they invalidate TransformHierarchy of the world
+		void LinkChild(TransformComponent* child);
+		void UnlinkChild(TransformComponent* child);
+		void InvalidateHierarchy() const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "EnginePCH.hpp"
+
+#include "TransformHierarchy.hpp"
+
+using namespace Poly;
+
+constexpr size_t TransformHierarchy::NO_PARENT;
+
+//------------------------------------------------------------------------------
+void TransformHierarchy::Update(World* world)
+{
+	if (Valid)
+		return;
+
+	Nodes.Clear();
+	DepthOffsets.Clear();
+	DepthOffsets.PushBack(0);
+	for (auto components : world->Query<With<TransformComponent>>())
+	{
+		TransformComponent* transform = std::get<TransformComponent*>(components);
+		if (!transform->GetParent())
+			Nodes.PushBack(Node{ transform, NO_PARENT, 0, 0 });
+	}
+
+	// every level is built from children of the previous one, so children of a node end up next to each other
+	for (size_t begin = 0; begin < Nodes.GetSize();)
+	{
+		const size_t end = Nodes.GetSize();
+		DepthOffsets.PushBack(end);
+		for (size_t i = begin; i < end; ++i)
+		{
+			Nodes[i].FirstChild = Nodes.GetSize();
+			for (TransformComponent* child = Nodes[i].Transform->FirstChild; child; child = child->NextSibling)
+				Nodes.PushBack(Node{ child, i, 0, 0 });
+			Nodes[i].ChildCount = Nodes.GetSize() - Nodes[i].FirstChild;
+		}
+		begin = end;
+	}
+	Valid = true;
+}
+
+//------------------------------------------------------------------------------
+void TransformHierarchy::AddDirtyRoot(const EntityID& entityId)
+{
+	std::lock_guard<std::mutex> lock(DirtyRootsMutex);
+	DirtyRoots.PushBack(entityId);
+}
+
+//------------------------------------------------------------------------------
+void TransformHierarchy::TakeDirtyRoots(Dynarray<EntityID>& entityIds)
+{
+	std::lock_guard<std::mutex> lock(DirtyRootsMutex);
+	entityIds = std::move(DirtyRoots);
+	DirtyRoots.Clear();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Core.hpp>
+#include <mutex>
+
+#include "EntityID.hpp"
+
+namespace Poly
+{
+	class World;
+	class TransformComponent;
+
+	/// <summary>Transform hierarchy of a world flattened into arrays ordered by depth: all roots first, then all their children and so on.
+	/// Children of every node are stored next to each other, so a node keeps only index of its parent, its first child and count of children.</summary>
+	/// <para>Owned by world and rebuilt lazily by <see cref="TransformHierarchy.Update()"/> after transforms were attached, detached,
+	/// added or removed, so hierarchy edits stay O(1). Passes over the order visit parents before children without recursion.</para>
+	/// <para>Also collects transforms changed since the last <see cref="TransformSystem.TransformUpdatePhase()"/>. Changing a transform
+	/// only adds it to that list and increments the change count, descendants are updated by the phase.</para>
+	class ENGINE_DLLEXPORT TransformHierarchy : public BaseObject<>
+	{
+	public:
+		/// <summary>Index of parent of roots.</summary>
+		static constexpr size_t NO_PARENT = static_cast<size_t>(-1);
+
+		/// <summary>Marks the order outdated. Called by the world on every structural change and by transforms when they are attached or detached.</summary>
+		void Invalidate() { Valid = false; AddChange(); }
+
+		/// <summary>Returns true if the order reflects current hierarchy.</summary>
+		bool IsValid() const { return Valid; }
+
+		/// <summary>Rebuilds the order if it is outdated. Nodes, their indices and pointers to transforms are valid until the next structural change.</summary>
+		void Update(World* world);
+
+		size_t GetSize() const { return Nodes.GetSize(); }
+
+		/// <summary>Returns count of hierarchy levels, roots are level 0.</summary>
+		size_t GetDepthCount() const { return DepthOffsets.GetSize() - 1; }
+		/// <summary>Returns index of the first node of given depth. Nodes of a depth end where nodes of the next one begin.</summary>
+		size_t GetDepthBegin(size_t depth) const { return DepthOffsets[depth]; }
+		size_t GetDepthEnd(size_t depth) const { return DepthOffsets[depth + 1]; }
+
+		TransformComponent* GetTransform(size_t node) const { return Nodes[node].Transform; }
+		size_t GetParent(size_t node) const { return Nodes[node].Parent; }
+		size_t GetFirstChild(size_t node) const { return Nodes[node].FirstChild; }
+		size_t GetChildCount(size_t node) const { return Nodes[node].ChildCount; }
+
+		/// <summary>Returns count of changes of transforms and of the hierarchy. Global transformation validated at the current count is still valid.</summary>
+		uint64_t GetChangeCount() const { return ChangeCount.load(std::memory_order_relaxed); }
+		void AddChange() { ChangeCount.fetch_add(1, std::memory_order_relaxed); }
+
+		/// <summary>Returns true if nothing changed since the last update of all global transformations.</summary>
+		bool AreGlobalTransformationsValid(uint64_t changeCount) const { return changeCount == ValidChangeCount; }
+		void SetGlobalTransformationsValid() { ValidChangeCount = GetChangeCount(); }
+
+		/// <summary>Adds transform of given entity to the list of changed transforms. Every transform is added once until the list is taken. Thread safe.</summary>
+		void AddDirtyRoot(const EntityID& entityId);
+		/// <summary>Moves the list of changed transforms to given array and clears it.</summary>
+		void TakeDirtyRoots(Dynarray<EntityID>& entityIds);
+
+	private:
+		struct Node
+		{
+			TransformComponent* Transform;
+			size_t Parent;
+			size_t FirstChild;
+			size_t ChildCount;
+		};
+
+		Dynarray<Node> Nodes;
+		// Index of the first node of every depth followed by the node count
+		Dynarray<size_t> DepthOffsets = { 0 };
+		bool Valid = false;
+
+		std::atomic<uint64_t> ChangeCount{ 0 };
+		uint64_t ValidChangeCount = 0;
+		Dynarray<EntityID> DirtyRoots;
+		std::mutex DirtyRootsMutex;
+	};
+}
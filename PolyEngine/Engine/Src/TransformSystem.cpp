@@ -0,0 +1,110 @@
+#include "EnginePCH.hpp"
+
+#include "TransformSystem.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	// Calls function(begin, end) for ranges of [0, count) on the engine thread pool and returns when all of them were processed.
+	// Every transform is computed by the same code from the same inputs on whichever thread, so results do not depend on the split.
+	template<typename Function>
+	void ParallelForRanges(size_t count, const Function& function)
+	{
+		const size_t taskCount = (count + DEFAULT_PARALLEL_GRAIN_SIZE - 1) / DEFAULT_PARALLEL_GRAIN_SIZE;
+		ThreadPool* pool = gEngine ? gEngine->GetThreadPool() : nullptr;
+		if (!pool || taskCount <= 1)
+		{
+			function(size_t(0), count);
+			return;
+		}
+		pool->Run(taskCount, [count, &function](size_t task)
+		{
+			function(task * DEFAULT_PARALLEL_GRAIN_SIZE, std::min(count, (task + 1) * DEFAULT_PARALLEL_GRAIN_SIZE));
+		});
+	}
+}
+
+//------------------------------------------------------------------------------
+void Poly::TransformSystem::TransformUpdatePhase(World* world)
+{
+	TransformHierarchy& hierarchy = world->GetTransformHierarchy();
+	Dynarray<EntityID> dirtyRoots;
+	hierarchy.TakeDirtyRoots(dirtyRoots);
+
+	// transforms of one level depend only on their parents, so a level is processed concurrently once the previous one is done
+	if (!hierarchy.IsValid())
+	{
+		// transforms could be added or attached in any state, so the whole hierarchy is checked
+		hierarchy.Update(world);
+		Dynarray<bool> moved;
+		moved.Resize(hierarchy.GetSize());
+		for (size_t depth = 0; depth < hierarchy.GetDepthCount(); ++depth)
+		{
+			const size_t levelBegin = hierarchy.GetDepthBegin(depth);
+			ParallelForRanges(hierarchy.GetDepthEnd(depth) - levelBegin, [&hierarchy, &moved, levelBegin](size_t begin, size_t end)
+			{
+				for (size_t i = levelBegin + begin; i < levelBegin + end; ++i)
+				{
+					TransformComponent* transform = hierarchy.GetTransform(i);
+					const size_t parent = hierarchy.GetParent(i);
+					const bool updated = transform->UpdateGlobalFromParent();
+					moved[i] = updated || transform->DirtyListed || (parent != TransformHierarchy::NO_PARENT && moved[parent]);
+					if (moved[i])
+						transform->MarkChanged();
+					transform->DirtyListed = false;
+				}
+			});
+		}
+	}
+	else
+	{
+		// only subtrees of changed transforms are visited, a subtree is visited once even if its transforms changed several times
+		Dynarray<Dynarray<TransformComponent*>> levels;
+		for (const EntityID& id : dirtyRoots)
+		{
+			TransformComponent* root = world->IsEntityAlive(id) ? world->GetComponent<TransformComponent>(id) : nullptr;
+			if (!root || !root->DirtyListed)
+				continue;
+			size_t depth = 0;
+			for (const TransformComponent* ancestor = root->Parent; ancestor; ancestor = ancestor->Parent)
+				++depth;
+			while (levels.GetSize() <= depth)
+				levels.PushBack(Dynarray<TransformComponent*>());
+			levels[depth].PushBack(root);
+		}
+
+		for (size_t depth = 0; depth < levels.GetSize(); ++depth)
+		{
+			const Dynarray<TransformComponent*>& level = levels[depth];
+			ParallelForRanges(level.GetSize(), [&level](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					level[i]->UpdateGlobalFromParent();
+					level[i]->MarkChanged();
+					level[i]->DirtyListed = false;
+				}
+			});
+
+			// children that changed themselves are already in the next level
+			Dynarray<TransformComponent*> children;
+			for (const TransformComponent* transform : level)
+			{
+				for (TransformComponent* child = transform->FirstChild; child; child = child->NextSibling)
+				{
+					if (!child->DirtyListed)
+						children.PushBack(child);
+				}
+			}
+			if (children.IsEmpty())
+				continue;
+			if (depth + 1 == levels.GetSize())
+				levels.PushBack(std::move(children));
+			else
+				for (TransformComponent* child : children)
+					levels[depth + 1].PushBack(child);
+		}
+	}
+	hierarchy.SetGlobalTransformationsValid();
+}
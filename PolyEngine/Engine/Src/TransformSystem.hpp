@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Defines.hpp>
+
+namespace Poly
+{
+	class World;
+
+	namespace TransformSystem
+	{
+		/// <summary>Updates global transformations of all changed transforms in one pass over the world transform hierarchy,
+		/// parents before children. Global transformation getters called after this phase only load cached values.</summary>
+		/// <para>Hierarchy is processed level by level, transforms of a level are split into ranges updated concurrently
+		/// by engine thread pool. Every transform is computed the same way as in serial update, so results are bit-identical.</para>
+		/// <see cref="TransformHierarchy"/>
+		void ENGINE_DLLEXPORT TransformUpdatePhase(World* world);
+	}
+}
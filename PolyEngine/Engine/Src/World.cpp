@@ -2,66 +2,265 @@
 
 using namespace Poly;
 
+namespace
+{
+	// shared by all worlds, so structure versions are never reused
+	std::atomic<uint64_t> gNextStructureVersion(1);
+}
+
 //------------------------------------------------------------------------------
-World::World()
-	: EntitiesAllocator(MAX_ENTITY_COUNT)
+World::World(eComponentStorage storage, size_t maxEntityCount, bool useHugePages)
+	: Storage(storage), MaxEntityCount(maxEntityCount), UseHugePages(useHugePages),
+	EntitySlotMemory(sizeof(EntitySlot) * maxEntityCount, useHugePages), EntitySlotCount(0),
+	FreeEntitySlotMemory(sizeof(size_t) * maxEntityCount, useHugePages), FreeEntitySlotCount(0),
+	EntitiesAllocator(maxEntityCount, useHugePages), ChangeVersion(1)
 {
+	ASSERTE(maxEntityCount > 0 && maxEntityCount <= std::numeric_limits<uint32_t>::max(), "Invalid entity limit!");
+	EntitySlots = reinterpret_cast<EntitySlot*>(EntitySlotMemory.GetData());
+	FreeEntitySlots = reinterpret_cast<size_t*>(FreeEntitySlotMemory.GetData());
 	memset(ComponentAllocators, 0, sizeof(IterablePoolAllocatorBase*) * MAX_COMPONENTS_COUNT);
 	memset(WorldComponents, 0, sizeof(ComponentBase*) * MAX_WORLD_COMPONENTS_COUNT);
+	MarkStructureChanged();
 }
 
 //------------------------------------------------------------------------------
 World::~World()
 {
-	// copy entities
-	auto entityMap = IDToEntityMap;
-	for (auto& kv : entityMap)
+	// destroying an entity destroys its children too, so check the slot every time
+	const size_t slotCount = std::min(EntitySlotCount.load(), MaxEntityCount);
+	for (size_t i = 0; i < slotCount; ++i)
 	{
-		if(IDToEntityMap.find(kv.second->EntityID) != IDToEntityMap.end())
-			DestroyEntity(kv.second->EntityID);
+		if (EntitySlots[i].Ent)
+			DestroyEntity(EntitySlots[i].Ent->GetID());
 	}
-	
+
 	for (size_t i = 0; i < MAX_COMPONENTS_COUNT; ++i)
 	{
 		if (ComponentAllocators[i])
 			delete ComponentAllocators[i];
 	}
 
+	for (Archetype* archetype : Archetypes)
+		delete archetype;
+
+	for (QueryCache* cache : QueryCaches)
+		delete cache;
+	for (SortedQueryCache* cache : SortedQueryCaches)
+		delete cache;
+
 	for (size_t i = 0; i < MAX_WORLD_COMPONENTS_COUNT; i++)
 		if (WorldComponents[i])
 			delete (WorldComponents[i]);
 }
 
 //------------------------------------------------------------------------------
-UniqueID World::SpawnEntity()
+size_t World::GetMemoryUsage() const
 {
+	size_t bytes = EntitySlotMemory.GetCommittedSize() + FreeEntitySlotMemory.GetCommittedSize() + EntitiesAllocator.GetMemoryUsage();
+
+	const size_t slotCount = std::min(EntitySlotCount.load(), MaxEntityCount);
+	for (size_t i = 0; i < slotCount; ++i)
+	{
+		if (EntitySlots[i].Ent)
+			bytes += EntitySlots[i].Ent->GetComponentListMemoryUsage();
+	}
+
+	for (size_t i = 0; i < MAX_COMPONENTS_COUNT; ++i)
+	{
+		if (ComponentAllocators[i])
+			bytes += ComponentAllocators[i]->GetMemoryUsage();
+	}
+
+	for (const Archetype* archetype : Archetypes)
+		bytes += archetype->GetMemoryUsage();
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+EntityID World::ReserveEntityID()
+{
+	// reuse slot released by destroyed entity, pop is safe as slots are pushed only when entities are destroyed
+	size_t freeCount = FreeEntitySlotCount.load(std::memory_order_acquire);
+	while (freeCount > 0 && !FreeEntitySlotCount.compare_exchange_weak(freeCount, freeCount - 1, std::memory_order_acq_rel, std::memory_order_acquire)) {}
+
+	size_t index;
+	if (freeCount > 0)
+		index = FreeEntitySlots[freeCount - 1];
+	else
+	{
+		index = EntitySlotCount.fetch_add(1, std::memory_order_relaxed);
+		ASSERTE(index < MaxEntityCount, "Entity limit exceeded!");
+		EntitySlotMemory.Commit((index + 1) * sizeof(EntitySlot));
+	}
+	return EntityID(static_cast<uint32_t>(index), EntitySlots[index].Version + 1);
+}
+
+//------------------------------------------------------------------------------
+void World::ReserveEntityIDs(size_t count, Dynarray<EntityID>& ids)
+{
+	ids.Reserve(ids.GetSize() + count);
+
+	// take as many released slots as possible in a single step
+	size_t freeCount = FreeEntitySlotCount.load(std::memory_order_acquire);
+	size_t taken = std::min(freeCount, count);
+	while (taken > 0 && !FreeEntitySlotCount.compare_exchange_weak(freeCount, freeCount - taken, std::memory_order_acq_rel, std::memory_order_acquire))
+		taken = std::min(freeCount, count);
+	for (size_t i = 0; i < taken; ++i)
+	{
+		const size_t index = FreeEntitySlots[freeCount - 1 - i];
+		ids.PushBack(EntityID(static_cast<uint32_t>(index), EntitySlots[index].Version + 1));
+	}
+
+	// and the rest from the end of slot table
+	const size_t rest = count - taken;
+	if (rest == 0)
+		return;
+	const size_t first = EntitySlotCount.fetch_add(rest, std::memory_order_relaxed);
+	ASSERTE(first + rest <= MaxEntityCount, "Entity limit exceeded!");
+	EntitySlotMemory.Commit((first + rest) * sizeof(EntitySlot));
+	for (size_t index = first; index < first + rest; ++index)
+		ids.PushBack(EntityID(static_cast<uint32_t>(index), EntitySlots[index].Version + 1));
+}
+
+//------------------------------------------------------------------------------
+EntityID World::SpawnEntity(const EntityID& reservedId)
+{
+	HEAVY_ASSERTE(reservedId && reservedId.Index < EntitySlotCount.load(), "Invalid entity ID");
+	EntitySlot& slot = EntitySlots[reservedId.Index];
+	HEAVY_ASSERTE(!slot.Ent && slot.Version + 1 == reservedId.Generation, "Entity ID was not reserved or entity was already spawned!");
+	MarkStructureChanged();
+
 	Entity* ent = EntitiesAllocator.Alloc();
-	::new(ent) Entity(this);
-	IDToEntityMap[ent->EntityID] = ent;
-	return ent->EntityID;
+	::new(ent) Entity(this, reservedId);
+	slot.Ent = ent;
+	return reservedId;
 }
 
 //------------------------------------------------------------------------------
-void World::DestroyEntity(const UniqueID& entityId)
+void World::SpawnEntities(size_t count, const Dynarray<ComponentTypeInfo>& types, const ComponentConstructor& construct, Dynarray<EntityID>& ids)
 {
-	Entity* ent = IDToEntityMap[entityId];
-	HEAVY_ASSERTE(ent, "Invalid entity ID");
+	const size_t first = ids.GetSize();
+	ReserveEntityIDs(count, ids);
+	SpawnReservedEntities(ids.GetData() + first, count, types, construct);
+}
 
-	TransformComponent* transform = ent->GetComponent<TransformComponent>();
-	if (transform)
+//------------------------------------------------------------------------------
+void World::SpawnReservedEntities(const EntityID* ids, size_t count, const Dynarray<ComponentTypeInfo>& types, const ComponentConstructor& construct)
+{
+	ComponentSignature signature;
+	for (const ComponentTypeInfo& type : types)
 	{
-		for (auto it : transform->GetChildren())
-			DestroyEntity(it->GetOwnerID());
+		HEAVY_ASSERTE(!signature[type.ID] && NextComponentID(signature, type.ID) == MAX_COMPONENTS_COUNT, "Component types have to be unique and sorted by ID!");
+		signature.set(type.ID);
 	}
 
-	for (size_t i = 0; i < MAX_COMPONENTS_COUNT; ++i)
+	Archetype* archetype = nullptr;
+	if (Storage == eComponentStorage::ARCHETYPE)
+	{
+		if (!types.IsEmpty())
+			archetype = GetArchetype(signature, types);
+	}
+	else
 	{
-		if (ent->Components[i])
-			RemoveComponentById(ent, i);
+		for (const ComponentTypeInfo& type : types)
+			if (ComponentAllocators[type.ID] == nullptr && !TagComponentIDs[type.ID])
+				RegisterPoolComponentType(type);
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		SpawnEntity(ids[i]);
+		Entity* ent = EntitySlots[ids[i].Index].Ent;
+		if (archetype)
+		{
+			ent->EntityArchetype = archetype;
+			ent->ArchetypeRow = archetype->AddRow(ent);
+		}
+		for (size_t t = 0; t < types.GetSize(); ++t)
+		{
+			const size_t componentID = types[t].ID;
+			ComponentBase* component = nullptr;
+			if (types[t].Kind != eComponentKind::TAG)
+			{
+				void* memory = archetype ? archetype->GetComponent(componentID, ent->ArchetypeRow) : ComponentAllocators[componentID]->AllocCell();
+				construct(i, t, memory);
+				component = static_cast<ComponentBase*>(memory);
+			}
+			ent->AddComponentSlot(componentID, component);
+			if (types[t].Kind == eComponentKind::REGULAR)
+				AttachComponent(ent, component, std::true_type());
+			RecordAddition(ent, componentID);
+		}
+		UpdateQueryCaches(ent);
+	}
+}
+
+//------------------------------------------------------------------------------
+void World::DestroyEntity(const EntityID& entityId)
+{
+	MarkStructureChanged();
+	Entity* ent = GetEntity(entityId);
+	// entityId may refer to the ID stored in the entity itself, which is destroyed below
+	const size_t slotIndex = entityId.Index;
+
+	// Descendants are destroyed first, deepest ones before their parents. They are collected up front, as destroying them
+	// can move transforms with archetype storage, and every one of them has no children left when it is destroyed.
+	const TransformComponent* transform = ent->GetComponent<TransformComponent>();
+	if (transform && transform->GetFirstChild())
+	{
+		Dynarray<EntityID> descendants;
+		for (const TransformComponent* t = transform->GetFirstChild(); t; t = TransformComponent::GetNextInSubtree(t, transform))
+			descendants.PushBack(t->GetOwnerID());
+		for (size_t i = descendants.GetSize(); i > 0; --i)
+			DestroyEntity(descendants[i - 1]);
+	}
+
+	const ComponentSignature observed = ent->ComponentPosessionFlags & ObservedRemovals;
+	for (size_t id = NextComponentID(observed, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(observed, id + 1))
+		RecordRemoval(ent, id);
+
+	if (Storage == eComponentStorage::POOL)
+		for (QueryCache* cache : QueryCaches)
+			cache->OnEntityDestroyed(ent);
+	for (SortedQueryCache* cache : SortedQueryCaches)
+		cache->OnEntityDestroyed(ent);
+
+	if (Storage == eComponentStorage::ARCHETYPE)
+	{
+		if (ent->EntityArchetype)
+		{
+			Entity* moved = ent->EntityArchetype->RemoveRow(ent->ArchetypeRow, true);
+			if (moved)
+				moved->ArchetypeRow = ent->ArchetypeRow;
+		}
+	}
+	else
+	{
+		// visit only owned components
+		const ComponentSignature owned = ent->ComponentPosessionFlags;
+		for (size_t id = NextComponentID(owned, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(owned, id + 1))
+			RemoveComponentById(ent, id);
 	}
-	IDToEntityMap.erase(entityId);
 	ent->~Entity();
 	EntitiesAllocator.Free(ent);
+
+	// invalidate handles to this entity and release the slot, generation 0 is reserved for invalid handles
+	EntitySlot& slot = EntitySlots[slotIndex];
+	slot.Ent = nullptr;
+	if (++slot.Version == std::numeric_limits<uint32_t>::max())
+		slot.Version = 0;
+	const size_t freeCount = FreeEntitySlotCount.load(std::memory_order_relaxed);
+	FreeEntitySlotMemory.Commit((freeCount + 1) * sizeof(size_t));
+	FreeEntitySlots[freeCount] = slotIndex;
+	FreeEntitySlotCount.store(freeCount + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+void World::DestroyEntities(const Dynarray<EntityID>& entityIds)
+{
+	for (const EntityID& entityId : entityIds)
+		if (IsEntityAlive(entityId))
+			DestroyEntity(entityId);
 }
 
 //------------------------------------------------------------------------------
@@ -74,7 +273,319 @@ bool World::HasWorldComponent(size_t ID) const
 //------------------------------------------------------------------------------
 void World::RemoveComponentById(Entity* ent, size_t id)
 {
-	HEAVY_ASSERTE(ent->Components[id], "Removing not present component");
-	ent->Components[id]->~ComponentBase();
-	ComponentAllocators[id]->Free(ent->Components[id]);
+	ComponentBase* component = ent->GetComponentById(id);
+	HEAVY_ASSERTE(component, "Removing not present component");
+	ent->RemoveComponentSlot(id);
+	if (TagComponentIDs[id])
+		return;
+	PoolComponentTypes[id].Destroy(component);
+	ComponentAllocators[id]->Free(component);
+}
+
+//------------------------------------------------------------------------------
+void World::RegisterPoolComponentType(const ComponentTypeInfo& type)
+{
+	HEAVY_ASSERTE(!ComponentAllocators[type.ID] && !TagComponentIDs[type.ID], "Component type was already registered!");
+	PoolComponentTypes[type.ID] = type;
+	if (type.Kind == eComponentKind::TAG)
+		TagComponentIDs.set(type.ID);
+	else
+		ComponentAllocators[type.ID] = type.CreatePool(MaxEntityCount, UseHugePages);
+	if (type.Kind != eComponentKind::REGULAR)
+		OwnerlessComponentIDs.set(type.ID);
+}
+
+//------------------------------------------------------------------------------
+Archetype* World::GetArchetypeWith(Archetype* archetype, const ComponentTypeInfo& type)
+{
+	if (archetype && archetype->GetAddEdge(type.ID))
+		return archetype->GetAddEdge(type.ID);
+
+	ComponentSignature signature;
+	Dynarray<ComponentTypeInfo> types;
+	if (archetype)
+	{
+		signature = archetype->GetSignature();
+		types = archetype->GetComponentTypes();
+	}
+	HEAVY_ASSERTE(!signature[type.ID], "Archetype already contains given component!");
+	signature.set(type.ID);
+
+	// keep columns ordered by component ID
+	size_t idx = 0;
+	while (idx < types.GetSize() && types[idx].ID < type.ID)
+		++idx;
+	types.Insert(idx, type);
+
+	Archetype* result = GetArchetype(signature, types);
+	if (archetype)
+	{
+		archetype->SetAddEdge(type.ID, result);
+		result->SetRemoveEdge(type.ID, archetype);
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------
+Archetype* World::GetArchetypeWithout(Archetype* archetype, size_t componentID)
+{
+	HEAVY_ASSERTE(archetype && archetype->HasComponent(componentID), "Archetype does not contain given component!");
+	if (archetype->GetRemoveEdge(componentID))
+		return archetype->GetRemoveEdge(componentID);
+
+	ComponentSignature signature = archetype->GetSignature();
+	signature.reset(componentID);
+	if (signature.none())
+		return nullptr;
+
+	Dynarray<ComponentTypeInfo> types;
+	for (const ComponentTypeInfo& type : archetype->GetComponentTypes())
+		if (type.ID != componentID)
+			types.PushBack(type);
+
+	Archetype* result = GetArchetype(signature, types);
+	archetype->SetRemoveEdge(componentID, result);
+	result->SetAddEdge(componentID, archetype);
+	return result;
+}
+
+//------------------------------------------------------------------------------
+Archetype* World::GetArchetype(const ComponentSignature& signature, const Dynarray<ComponentTypeInfo>& types)
+{
+	auto it = ArchetypesBySignature.find(signature);
+	if (it != ArchetypesBySignature.end())
+		return it->second;
+
+	Archetype* archetype = new Archetype(signature, types);
+	Archetypes.PushBack(archetype);
+	ArchetypesBySignature[signature] = archetype;
+	for (QueryCache* cache : QueryCaches)
+		cache->OnArchetypeCreated(archetype);
+	return archetype;
+}
+
+//------------------------------------------------------------------------------
+void World::MoveToArchetype(Entity* ent, Archetype* archetype)
+{
+	Archetype* prevArchetype = ent->EntityArchetype;
+	const size_t prevRow = ent->ArchetypeRow;
+
+	if (archetype)
+	{
+		const size_t row = archetype->AddRow(ent);
+		if (prevArchetype)
+		{
+			// components missing in the new archetype were already destroyed by the caller
+			for (const ComponentTypeInfo& type : prevArchetype->GetComponentTypes())
+				if (archetype->HasComponent(type.ID))
+					type.Relocate(archetype->GetComponent(type.ID, row), prevArchetype->GetComponent(type.ID, prevRow));
+		}
+		ent->EntityArchetype = archetype;
+		ent->ArchetypeRow = row;
+		if (prevArchetype)
+			archetype->MarkChunkChanged(row, prevArchetype->GetChunkChangeVersion(prevRow));
+	}
+	else
+	{
+		ent->EntityArchetype = nullptr;
+		ent->ArchetypeRow = 0;
+	}
+
+	if (prevArchetype)
+	{
+		Entity* moved = prevArchetype->RemoveRow(prevRow, false);
+		if (moved)
+			moved->ArchetypeRow = prevRow;
+	}
+}
+
+//------------------------------------------------------------------------------
+const IterablePoolAllocatorBase* World::GetSmallestPool(const ComponentSignature& components) const
+{
+	const IterablePoolAllocatorBase* smallest = nullptr;
+	for (size_t i = 0; i < MAX_COMPONENTS_COUNT; ++i)
+	{
+		if (!components[i])
+			continue;
+		// pool is created with the first component of its type, there is nothing to iterate without it
+		if (!ComponentAllocators[i] && !TagComponentIDs[i])
+			return nullptr;
+		if (OwnerlessComponentIDs[i])
+			continue;
+		if (!smallest || ComponentAllocators[i]->GetSize() < smallest->GetSize())
+			smallest = ComponentAllocators[i];
+	}
+	return smallest;
+}
+
+//------------------------------------------------------------------------------
+Dynarray<World::ComponentRange> World::SplitIntoRanges(const ComponentSignature& components, size_t grainSize, const IterablePoolAllocatorBase*& pool, const Dynarray<Entity*>*& entities)
+{
+	entities = nullptr;
+	Dynarray<ComponentRange> ranges;
+	grainSize = std::max<size_t>(grainSize, 1);
+	if (Storage == eComponentStorage::ARCHETYPE)
+	{
+		pool = nullptr;
+		for (Archetype* archetype : Archetypes)
+		{
+			if ((archetype->GetSignature() & components) != components)
+				continue;
+			// ranges consist of whole chunks, so no chunk is shared between tasks
+			const size_t chunkCapacity = archetype->GetChunkCapacity();
+			const size_t step = (grainSize + chunkCapacity - 1) / chunkCapacity * chunkCapacity;
+			for (size_t begin = 0; begin < archetype->GetSize(); begin += step)
+				ranges.PushBack({ archetype, begin, std::min(begin + step, archetype->GetSize()) });
+		}
+		return ranges;
+	}
+
+	pool = GetSmallestPool(components);
+	if (!pool && (components & ~OwnerlessComponentIDs).none())
+	{
+		QueryFilter filter;
+		filter.Required = components;
+		entities = &GetQueryCache(filter)->GetEntities();
+	}
+	if (!pool && !entities)
+		return ranges;
+	const size_t end = pool ? pool->GetInitializedCount() : entities->GetSize();
+	for (size_t begin = 0; begin < end; begin += grainSize)
+		ranges.PushBack({ nullptr, begin, std::min(begin + grainSize, end) });
+	return ranges;
+}
+
+//------------------------------------------------------------------------------
+QueryCache* World::GetQueryCache(const QueryFilter& filter)
+{
+	std::lock_guard<std::mutex> lock(QueryCachesMutex);
+	for (QueryCache* cache : QueryCaches)
+		if (cache->GetFilter() == filter)
+			return cache;
+
+	QueryCache* cache = new QueryCache(filter);
+	QueryCaches.PushBack(cache);
+	if (Storage == eComponentStorage::ARCHETYPE)
+	{
+		for (Archetype* archetype : Archetypes)
+			cache->OnArchetypeCreated(archetype);
+	}
+	else
+	{
+		const size_t slotCount = std::min(EntitySlotCount.load(), MaxEntityCount);
+		for (size_t i = 0; i < slotCount; ++i)
+			if (EntitySlots[i].Ent)
+				cache->OnEntityChanged(EntitySlots[i].Ent);
+	}
+	return cache;
+}
+
+//------------------------------------------------------------------------------
+SortedQueryCache* World::GetSortedQueryCache(const QueryFilter& filter, size_t keyComponentID, SortedQueryCache::KeyFunctionID keyID, const SortedQueryCache::KeyFunction& key)
+{
+	std::lock_guard<std::mutex> lock(QueryCachesMutex);
+	for (SortedQueryCache* cache : SortedQueryCaches)
+		if (cache->GetFilter() == filter && cache->IsSortedBy(keyComponentID, keyID))
+			return cache;
+
+	SortedQueryCache* cache = new SortedQueryCache(filter, keyComponentID, keyID, key);
+	SortedQueryCaches.PushBack(cache);
+	const size_t slotCount = std::min(EntitySlotCount.load(), MaxEntityCount);
+	for (size_t i = 0; i < slotCount; ++i)
+		if (EntitySlots[i].Ent)
+			cache->OnEntityChanged(EntitySlots[i].Ent);
+	return cache;
+}
+
+//------------------------------------------------------------------------------
+void World::MarkStructureChanged()
+{
+	StructureVersion = gNextStructureVersion.fetch_add(1, std::memory_order_relaxed);
+	Hierarchy.Invalidate();
+}
+
+//------------------------------------------------------------------------------
+World::ComponentObservers& World::GetObservers(size_t componentID)
+{
+	HEAVY_ASSERTE(componentID < MAX_COMPONENTS_COUNT, "Invalid component ID");
+	if (!Observers[componentID])
+		Observers[componentID] = std::make_unique<ComponentObservers>();
+	return *Observers[componentID];
+}
+
+//------------------------------------------------------------------------------
+void World::DispatchObserverEvents()
+{
+	// entity can gain or lose a component several times between dispatches, observers get it once
+	const auto sortUnique = [](Dynarray<EntityID>& ids)
+	{
+		std::sort(ids.Begin(), ids.End(), [](const EntityID& a, const EntityID& b) { return a.Index < b.Index || (a.Index == b.Index && a.Generation < b.Generation); });
+		size_t count = 0;
+		for (size_t i = 0; i < ids.GetSize(); ++i)
+			if (count == 0 || !(ids[count - 1] == ids[i]))
+				ids[count++] = ids[i];
+		ids.Resize(count);
+	};
+
+	// observers can add and remove components as well, repeat until nothing is left
+	const ComponentSignature observed = ObservedAdditions | ObservedRemovals;
+	for (bool pending = true; pending;)
+	{
+		pending = false;
+		for (size_t id = NextComponentID(observed, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(observed, id + 1))
+		{
+			ComponentObservers& observers = *Observers[id];
+			if (!observers.Added.IsEmpty())
+			{
+				Dynarray<EntityID> added = std::move(observers.Added);
+				sortUnique(added);
+				for (const ObserverFunction& observer : observers.OnAdd)
+					observer(this, added);
+				pending = true;
+			}
+			if (!observers.Removed.IsEmpty())
+			{
+				Dynarray<EntityID> removed = std::move(observers.Removed);
+				sortUnique(removed);
+				for (const ObserverFunction& observer : observers.OnRemove)
+					observer(this, removed);
+				pending = true;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void World::Snapshot(WorldSnapshot& snapshot)
+{
+	snapshot.Capture(this);
+}
+
+//------------------------------------------------------------------------------
+void World::Restore(const WorldSnapshot& snapshot)
+{
+	snapshot.RestoreTo(this);
+}
+
+//------------------------------------------------------------------------------
+void World::UpdateQueryCaches(Entity* ent)
+{
+	// archetype storage caches whole archetypes, they are updated when archetypes are created
+	if (Storage == eComponentStorage::POOL)
+		for (QueryCache* cache : QueryCaches)
+			cache->OnEntityChanged(ent);
+	// sorted caches keep entities with both storages, archetypes have no order of their own
+	for (SortedQueryCache* cache : SortedQueryCaches)
+		cache->OnEntityChanged(ent);
+}
+
+//------------------------------------------------------------------------------
+void ComponentBase::MarkChanged()
+{
+	// components that are being constructed are marked when they are added
+	if (!Owner)
+		return;
+	ChangeVersion = Owner->GetWorld()->GetChangeVersion();
+	if (Owner->EntityArchetype)
+		Owner->EntityArchetype->MarkChunkChanged(Owner->ArchetypeRow, ChangeVersion);
 }
@@ -1,10 +1,15 @@
 #pragma once
 
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
 #include <Core.hpp>
 
 #include "Entity.hpp"
 #include "Engine.hpp"
+#include "Archetype.hpp"
+#include "Query.hpp"
+#include "TransformHierarchy.hpp"
 
 #include "ComponentBase.hpp"
 
@@ -12,44 +17,148 @@ namespace Poly {
 
 	namespace DeferredTaskSystem
 	{
-		UniqueID ENGINE_DLLEXPORT SpawnEntityImmediate(World* w);
-		void ENGINE_DLLEXPORT DestroyEntityImmediate(World* w, const UniqueID& entityId);
-		template<typename T, typename ...Args> void AddComponentImmediate(World* w, const UniqueID & entityId, Args && ...args);
+		EntityID ENGINE_DLLEXPORT SpawnEntityImmediate(World* w);
+		void ENGINE_DLLEXPORT DestroyEntityImmediate(World* w, const EntityID& entityId);
+		template<typename... Components, typename... ArgTuples> Dynarray<EntityID> SpawnEntitiesImmediate(World* w, size_t count, const ArgTuples&... args);
+		void ENGINE_DLLEXPORT DestroyEntitiesImmediate(World* w, const Dynarray<EntityID>& entityIds);
+		template<typename T, typename ...Args> void AddComponentImmediate(World* w, const EntityID & entityId, Args && ...args);
 		template<typename T, typename ...Args> void AddWorldComponentImmediate(World* w, Args && ...args);
 		template<typename T> void RemoveWorldComponentImmediate(World* w);
 	}
 	struct InputState;
+	class WorldSnapshot;
 
-	/// <summary>Entities per world limit.</summary>
-	constexpr size_t MAX_ENTITY_COUNT = 65536;
+	/// <summary>Default limit of entities per world. Memory is reserved for that many entities, but committed only when used.</summary>
+	/// <see cref="World.World()"/>
+	constexpr size_t DEFAULT_MAX_ENTITY_COUNT = 65536;
 
 	/// <summary>World components in limit.</summary>
 	constexpr size_t MAX_WORLD_COMPONENTS_COUNT = 64;
 
+	/// <summary>Default count of entities (or pool cells) processed by a single task of World::ParallelForEach().</summary>
+	constexpr size_t DEFAULT_PARALLEL_GRAIN_SIZE = 256;
+
 	/// <summary>World represents world/scene/level in engine.
-	/// It contains entities, its components and world components.</summary>
+	/// It contains entities, its components and world components.
+	/// <para>Components are kept either in per-type pools or in archetype chunks, see <see cref="eComponentStorage"/>.
+	/// With archetype storage components are moved whenever a component is added to or removed from their entity,
+	/// so pointers to components must not be kept across such changes - keep entity IDs instead.</para></summary>
 	class ENGINE_DLLEXPORT World : public BaseObject<>
 	{
 	public:
-		/// <summary>Allocates memory for entities, world components and components allocators.</summary>
-		World();
+		/// <summary>Reserves address space for entities and component allocators. Memory is committed as entities are spawned.</summary>
+		/// <param name="storage">Layout used to store components of this world.</param>
+		/// <param name="maxEntityCount">Limit of entities that can exist in this world at once.</param>
+		/// <param name="useHugePages">Whether memory of entities and components should be backed by huge pages when possible.</param>
+		explicit World(eComponentStorage storage = eComponentStorage::POOL, size_t maxEntityCount = DEFAULT_MAX_ENTITY_COUNT, bool useHugePages = false);
 
 		virtual ~World();
 
-		/// <summary>Gets a component of a specified type from entity with given UniqueID.</summary>
-		/// <param name="entityId">UniqueID of the entity.</param>
+		/// <summary>Returns layout used to store components of this world.</summary>
+		eComponentStorage GetComponentStorage() const { return Storage; }
+
+		/// <summary>Returns limit of entities that can exist in this world at once.</summary>
+		size_t GetMaxEntityCount() const { return MaxEntityCount; }
+
+		/// <summary>Returns count of bytes used by entities and components: committed entity slots, entity and component pools,
+		/// packed component lists and archetype chunks. Reserved address space, world components and query caches are not counted.</summary>
+		size_t GetMemoryUsage() const;
+
+		/// <summary>Gets a component of a specified type from entity with given EntityID.</summary>
+		/// <param name="entityId">EntityID of the entity.</param>
 		/// <returns>Pointer to a specified component or a nullptr, if none was found.</returns>
 		/// <see cref="World.AddComponent()">
 		/// <see cref="World.RemoveComponent()">
 		template<typename T>
-		T* GetComponent(const UniqueID& entityId)
+		T* GetComponent(const EntityID& entityId)
+		{
+			return GetEntity(entityId)->GetComponent<T>();
+		}
+
+		/// <summary>Checks whether given handle refers to an entity that exists in this world.
+		/// Returns false for handles of destroyed entities and for reserved handles that were not spawned yet.</summary>
+		/// <param name="entityId">EntityID of the entity.</param>
+		bool IsEntityAlive(const EntityID& entityId) const
+		{
+			// slots past committed memory were never used
+			if (!entityId || entityId.Index >= EntitySlotMemory.GetCommittedSize() / sizeof(EntitySlot))
+				return false;
+			const EntitySlot& slot = EntitySlots[entityId.Index];
+			return slot.Ent != nullptr && slot.Version + 1 == entityId.Generation;
+		}
+
+		/// <summary>Returns current change version. Components modified now are stamped with it.</summary>
+		/// <see cref="ComponentBase.MarkChanged()"/>
+		uint32_t GetChangeVersion() const { return ChangeVersion.load(std::memory_order_relaxed); }
+
+		/// <summary>Starts a new change version, so modifications made from now on are newer than everything seen so far.
+		/// Systems that use Changed filter with <see cref="World.Query()"/> store the returned value and pass it to the next query.</summary>
+		/// <returns>Version that was current before the call.</returns>
+		uint32_t AdvanceChangeVersion() { return ChangeVersion.fetch_add(1, std::memory_order_relaxed); }
+
+		/// <summary>Copies all entities and their components into the snapshot, so the world can be brought back to this state with Restore().
+		/// If the snapshot already holds state of this world and no entities or components were added or removed since it was taken or restored,
+		/// only components changed since then are copied. With archetype storage unchanged chunks are skipped at once.</summary>
+		/// <para>World components are not captured. Components have to be copyable, TransformComponent hierarchy is handled by the world.</para>
+		/// <see cref="ComponentBase.MarkChanged()"/>
+		void Snapshot(WorldSnapshot& snapshot);
+
+		/// <summary>Brings entities and components back to the state captured in the snapshot, entities keep their IDs.
+		/// Without structural changes since the snapshot only changed components are copied back, otherwise all entities are destroyed
+		/// and spawned again from the snapshot. Restored components are marked as changed.</summary>
+		/// <para>Handles of entities spawned after the snapshot was taken may become valid again, so they should be dropped.
+		/// Has to be called when no deferred tasks are pending.</para>
+		void Restore(const WorldSnapshot& snapshot);
+
+		/// <summary>Returns hierarchy of transforms of this world flattened by depth. It has to be updated before use.</summary>
+		/// <see cref="TransformHierarchy.Update()"/>
+		TransformHierarchy& GetTransformHierarchy() { return Hierarchy; }
+
+		/// <summary>Registers observer of additions of components of type T. Additions are collected as they happen, also when entities are spawned,
+		/// and delivered by DispatchObserverEvents() in a single batch per type, so observers do not have to look for new components.</summary>
+		/// <para>Observer receives components that exist at the time of dispatch, components added and removed again in between are skipped.</para>
+		/// <param name="observer">Function called with the world and components added since the previous dispatch.</param>
+		template<typename T>
+		void OnAdd(const std::function<void(World*, const Dynarray<T*>&)>& observer)
+		{
+			const size_t componentID = gEngine->GetComponentID<T>();
+			GetObservers(componentID).OnAdd.PushBack([observer](World* world, const Dynarray<EntityID>& ids)
+			{
+				Dynarray<T*> components;
+				components.Reserve(ids.GetSize());
+				for (const EntityID& id : ids)
+					if (world->IsEntityAlive(id))
+						if (T* component = world->GetComponent<T>(id))
+							components.PushBack(component);
+				if (!components.IsEmpty())
+					observer(world, components);
+			});
+			ObservedAdditions.set(componentID);
+		}
+
+		/// <summary>Registers observer of removals of components of type T, including removals caused by destroying entities.
+		/// Removals are delivered by DispatchObserverEvents() in a single batch per type.</summary>
+		/// <param name="observer">Function called with the world and IDs of entities that lost the component since the previous dispatch.
+		/// The components are already destroyed and the entities may be destroyed as well.</param>
+		template<typename T>
+		void OnRemove(const std::function<void(World*, const Dynarray<EntityID>&)>& observer)
 		{
-			HEAVY_ASSERTE(!!entityId, "Invalid entity ID");
-			auto iter = IDToEntityMap.find(entityId);
-			HEAVY_ASSERTE(iter != IDToEntityMap.end(), "Invalid entityId - entity with that ID does not exist!");
-			return iter->second->GetComponent<T>();
+			const size_t componentID = gEngine->GetComponentID<T>();
+			GetObservers(componentID).OnRemove.PushBack(observer);
+			ObservedRemovals.set(componentID);
 		}
 
+		/// <summary>Delivers collected component additions and removals to observers, type by type.
+		/// Changes made by observers are delivered in the same call. Called by the engine at the beginning of every frame.</summary>
+		/// <see cref="World.OnAdd()"/>
+		/// <see cref="World.OnRemove()"/>
+		void DispatchObserverEvents();
+
+		/// <summary>Reserves handle for an entity that will be spawned later (e.g. by deferred task).
+		/// Lock-free, can be called from many threads at once, but not concurrently with spawning or destroying entities.</summary>
+		/// <returns>Handle that is not alive until the entity is spawned.</returns>
+		EntityID ReserveEntityID();
+
 		/// <summary>Checks whether world has component of given ID.</summary>
 		/// <param name="ID">Registered component ID.</param>
 		/// <returns>True when world has component of given ID, false otherwise</returns>
@@ -64,6 +173,128 @@ namespace Poly {
 			return reinterpret_cast<T*>(WorldComponents[gEngine->GetWorldComponentID<T>()]);
 		}
 
+		/// <summary>Returns entities matching given filters. Only full matches are visited, so required components are never null.</summary>
+		/// <example><code>for (auto components : world->Query{With{A, B}, Optional{C}, Without{D}}())</code>
+		/// visits entities owning A and B but not D. Iterator dereferences to a tuple of A*, B* and C*, where C* can be null.</example>
+		/// <para>With pool storage iteration is driven by the smallest pool of required components and owners of its components are matched
+		/// against the filter. With archetype storage only archetypes matching the filter are visited.</para>
+		/// <para>Pools of plain components and tags do not know owners of their cells, so with pool storage queries requiring only those
+		/// are served from the cache of <see cref="World.CachedQuery()"/>.</para>
+		/// <para>Changed filter additionally skips entities whose listed components were not modified after changedSince,
+		/// with archetype storage whole chunks are skipped at once.</para>
+		/// <param name="changedSince">Version returned by <see cref="World.AdvanceChangeVersion()"/> when the caller ran last time.
+		/// Used only with Changed filter, by default all components are treated as changed.</param>
+		/// <returns>Object that can be used in a range-for loop.</returns>
+		/// <see cref="World.CachedQuery()"/>
+		template<typename... Filters>
+		QueryResult<Filters...> Query(uint32_t changedSince = 0)
+		{
+			QueryFilter filter = Impl::MakeQueryFilter<Filters...>();
+			filter.ChangedSince = changedSince;
+			if (Storage == eComponentStorage::ARCHETYPE)
+				return QueryResult<Filters...>(QueryCursor::FromArchetypes(filter, &Archetypes, false), QueryCursor::FromArchetypes(filter, &Archetypes, true));
+
+			const IterablePoolAllocatorBase* pool = GetSmallestPool(filter.Required);
+			if (!pool && (filter.Required & ~OwnerlessComponentIDs).none())
+			{
+				const Dynarray<Entity*>& entities = GetQueryCache(filter)->GetEntities();
+				return QueryResult<Filters...>(QueryCursor::FromEntities(filter, &entities, false), QueryCursor::FromEntities(filter, &entities, true));
+			}
+			return QueryResult<Filters...>(QueryCursor::FromPool(filter, pool, false), QueryCursor::FromPool(filter, pool, true));
+		}
+
+		/// <summary>Same as <see cref="World.Query()"/>, but results are cached by the world and updated incrementally on every structural change,
+		/// so iteration does not visit entities that do not match. Cache is created on first call and lives as long as the world.</summary>
+		/// <para>Structural changes (spawning/destroying entities, adding/removing components) reorder cached results,
+		/// so they should not be done immediately while iterating - use deferred tasks instead.</para>
+		/// <para>With Changed filter every call visits components modified since the previous call of the same cached query,
+		/// so the filter should be unique to a single system.</para>
+		/// <returns>Object that can be used in a range-for loop.</returns>
+		template<typename... Filters>
+		QueryResult<Filters...> CachedQuery()
+		{
+			QueryCache* cache = GetQueryCache(Impl::MakeQueryFilter<Filters...>());
+			QueryFilter filter = cache->GetFilter();
+			if (filter.Changed.any())
+				filter.ChangedSince = cache->ExchangeChangeVersion(AdvanceChangeVersion());
+			if (Storage == eComponentStorage::ARCHETYPE)
+				return QueryResult<Filters...>(QueryCursor::FromArchetypes(filter, &cache->GetArchetypes(), false), QueryCursor::FromArchetypes(filter, &cache->GetArchetypes(), true));
+			return QueryResult<Filters...>(QueryCursor::FromEntities(filter, &cache->GetEntities(), false), QueryCursor::FromEntities(filter, &cache->GetEntities(), true));
+		}
+
+		/// <summary>Same as <see cref="World.CachedQuery()"/>, but results are visited in order of a key computed from a required component,
+		/// e.g. by mesh for rendering in batches or by spatial cell for collision. The order is kept by the world and updated incrementally
+		/// on every call: added and removed entities are merged in and out and keys of components marked changed are recomputed.</summary>
+		/// <example><code>world->SortedQuery{With{MeshRenderingComponent, TransformComponent}}(&amp;GetMeshKey)</code>
+		/// where GetMeshKey is a function taking const MeshRenderingComponent* and returning uint64_t.</example>
+		/// <para>Cache is identified by the filters, key component and key function, so the same function has to be passed on every call.
+		/// Keys have to depend only on the key component, changes of other data are not tracked.</para>
+		/// <param name="key">Function computing sort key of a component. Captureless lambdas can be passed with unary plus.</param>
+		/// <returns>Object that can be used in a range-for loop.</returns>
+		template<typename... Filters, typename T>
+		QueryResult<Filters...> SortedQuery(uint64_t (*key)(const T*))
+		{
+			STATIC_ASSERTE(Impl::ComponentTraits<T>::Kind == eComponentKind::REGULAR, "Key component has to be change tracked, so it has to derive from ComponentBase.");
+			QueryFilter filter = Impl::MakeQueryFilter<Filters...>();
+			const size_t keyComponentID = gEngine->GetComponentID<T>();
+			HEAVY_ASSERTE(filter.Required[keyComponentID], "Key component has to be required by the query!");
+			SortedQueryCache* cache = GetSortedQueryCache(filter, keyComponentID, reinterpret_cast<SortedQueryCache::KeyFunctionID>(key),
+				[key](const ComponentBase* component) { return key(static_cast<const T*>(component)); });
+
+			filter.ChangedSince = cache->ExchangeChangeVersion(AdvanceChangeVersion());
+			cache->Update(filter.ChangedSince);
+			return QueryResult<Filters...>(QueryCursor::FromEntities(filter, &cache->GetEntities(), false), QueryCursor::FromEntities(filter, &cache->GetEntities(), true));
+		}
+
+		/// <summary>Calls function for every entity that owns all given components. Component storage is split into ranges
+		/// of roughly grainSize entities (pool cells or archetype chunks), which are processed concurrently by engine thread pool.
+		/// Returns when all ranges were processed.</summary>
+		/// <para>Function is called concurrently for different entities, each entity is visited once. It can read and write
+		/// components passed to it and read data that nothing writes during the loop. It must not touch components of other entities,
+		/// which includes lazily cached global transformations of TransformComponent and children that are marked dirty
+		/// when local transformation changes, unless those entities are not visited by the loop.
+		/// Structural changes (spawning/destroying entities, adding/removing components) must not be done immediately,
+		/// they have to be scheduled with DeferredTaskSystem, which can be used from many threads at once.</para>
+		/// <para>Called from a function that already runs on the thread pool, the loop is executed serially.</para>
+		/// <tparam name="Components">Required components, pointers to them are passed to the function.</tparam>
+		/// <param name="function">Callable taking Components*... .</param>
+		/// <param name="grainSize">Count of entities processed by a single task.</param>
+		template<typename... Components, typename Function>
+		void ParallelForEach(const Function& function, size_t grainSize = DEFAULT_PARALLEL_GRAIN_SIZE)
+		{
+			STATIC_ASSERTE(sizeof...(Components) > 0, "ParallelForEach needs at least one component.");
+			const std::array<size_t, sizeof...(Components)> ids = {{ gEngine->GetComponentID<Components>()... }};
+			QueryFilter filter;
+			filter.Required = Impl::MakeSignature(Impl::TypeList<Components...>());
+			const IterablePoolAllocatorBase* pool = nullptr;
+			const Dynarray<Entity*>* entities = nullptr;
+			const Dynarray<ComponentRange> ranges = SplitIntoRanges(filter.Required, grainSize, pool, entities);
+
+			gEngine->GetThreadPool()->Run(ranges.GetSize(), [&](size_t i)
+			{
+				const ComponentRange& range = ranges[i];
+				if (range.RangeArchetype)
+				{
+					for (size_t row = range.Begin; row < range.End; ++row)
+						InvokeForRow<Components...>(function, range.RangeArchetype, row, ids, std::index_sequence_for<Components...>());
+					return;
+				}
+				if (entities)
+				{
+					for (size_t idx = range.Begin; idx < range.End; ++idx)
+						InvokeForEntity<Components...>(function, (*entities)[idx], ids, std::index_sequence_for<Components...>());
+					return;
+				}
+				// components are stored with ComponentBase at offset 0, so the owner can be read without knowing the type
+				for (size_t cell = pool->NextOccupied(range.Begin); cell < range.End; cell = pool->NextOccupied(cell + 1))
+				{
+					const Entity* entity = static_cast<const ComponentBase*>(pool->GetCell(cell))->Owner;
+					if (filter.Matches(entity->ComponentPosessionFlags))
+						InvokeForEntity<Components...>(function, entity, ids, std::index_sequence_for<Components...>());
+				}
+			});
+		}
+
 		template<typename PrimaryComponent, typename... SecondaryComponents>
 		struct IteratorProxy;
 
@@ -75,11 +306,14 @@ namespace Poly {
 		/// e.g. <code>for(auto [a, b] : world->IterateComponents{ComponentA, ComponentB}())</code></example>
 		/// <param name="PrimaryComponent">At least one component type must be specified</param>
 		/// <param name="SecondaryComponents">Additional component types (warning: returned pointers might be null!)</param>
+		/// With archetype storage components are visited chunk by chunk and secondary components are read from
+		/// the same row of the archetype, so no per-entity lookups are done.
 		/// <returns>A proxy object that can be used in a range-for loop.</returns>
 		/// <see cref="World.ComponentIterator"/>
 		template<typename PrimaryComponent, typename... SecondaryComponents>
 		IteratorProxy<PrimaryComponent, SecondaryComponents...> IterateComponents()
 		{
+			STATIC_ASSERTE(Impl::ComponentTraits<PrimaryComponent>::Kind == eComponentKind::REGULAR, "Primary component has to derive from ComponentBase, use Query() for plain components and tags.");
 			return {this};
 		}
 
@@ -89,11 +323,18 @@ namespace Poly {
 		                          public std::iterator<std::bidirectional_iterator_tag, std::tuple<typename std::add_pointer<PrimaryComponent>::type, typename std::add_pointer<SecondaryComponents>::type...>>
 		{
 			public:
-			bool operator==(const ComponentIterator& rhs) const { return primary_iter == rhs.primary_iter; }
+			bool operator==(const ComponentIterator& rhs) const { return primary_iter == rhs.primary_iter && cursor == rhs.cursor; }
 			bool operator!=(const ComponentIterator& rhs) const { return !(*this == rhs); }
 
 			std::tuple<typename std::add_pointer<PrimaryComponent>::type, typename std::add_pointer<SecondaryComponents>::type...> operator*() const
 			{
+				if (use_archetypes)
+				{
+					const Archetype* archetype = cursor.GetArchetype();
+					const size_t row = cursor.GetRow();
+					return std::make_tuple(static_cast<PrimaryComponent*>(archetype->GetComponent(gEngine->GetComponentID<PrimaryComponent>(), row)),
+						static_cast<SecondaryComponents*>(archetype->GetComponent(gEngine->GetComponentID<SecondaryComponents>(), row))...);
+				}
 				PrimaryComponent* primary = &*primary_iter;
 				return std::make_tuple(primary, primary->template GetSibling<SecondaryComponents>()...);
 			}
@@ -102,16 +343,19 @@ namespace Poly {
 				return **this;
 			}
 
-			ComponentIterator& operator++() { ++primary_iter; return *this; }
-			ComponentIterator operator++(int) { ComponentIterator ret(primary_iter); ++primary_iter; return ret; }
-			ComponentIterator& operator--() { --primary_iter; return *this; }
-			ComponentIterator operator--(int) { ComponentIterator ret(primary_iter); --primary_iter; return ret; }
+			ComponentIterator& operator++() { if (use_archetypes) cursor.Next(); else ++primary_iter; return *this; }
+			ComponentIterator operator++(int) { ComponentIterator ret(*this); ++(*this); return ret; }
+			ComponentIterator& operator--() { if (use_archetypes) cursor.Prev(); else --primary_iter; return *this; }
+			ComponentIterator operator--(int) { ComponentIterator ret(*this); --(*this); return ret; }
 
 			private:
 			explicit ComponentIterator(typename IterablePoolAllocator<PrimaryComponent>::Iterator parent) : primary_iter(parent) {}
+			explicit ComponentIterator(const ArchetypeCursor& parent) : cursor(parent), use_archetypes(true) {}
 			friend struct IteratorProxy<PrimaryComponent, SecondaryComponents...>;
 
 			typename IterablePoolAllocator<PrimaryComponent>::Iterator primary_iter;
+			ArchetypeCursor cursor;
+			bool use_archetypes = false;
 		};
 
 		/// Iterator proxy
@@ -121,10 +365,14 @@ namespace Poly {
 			IteratorProxy(World* w) : W(w) {}
 			World::ComponentIterator<PrimaryComponent, SecondaryComponents...> Begin()
 			{
+				if (W->Storage == eComponentStorage::ARCHETYPE)
+					return ComponentIterator<PrimaryComponent, SecondaryComponents...>(ArchetypeCursor(&W->Archetypes, gEngine->GetComponentID<PrimaryComponent>(), 0));
 				return ComponentIterator<PrimaryComponent, SecondaryComponents...>(W->GetComponentAllocator<PrimaryComponent>()->Begin());
 			}
 			World::ComponentIterator<PrimaryComponent, SecondaryComponents...> End()
 			{
+				if (W->Storage == eComponentStorage::ARCHETYPE)
+					return ComponentIterator<PrimaryComponent, SecondaryComponents...>(ArchetypeCursor(&W->Archetypes, gEngine->GetComponentID<PrimaryComponent>(), W->Archetypes.GetSize()));
 				return ComponentIterator<PrimaryComponent, SecondaryComponents...>(W->GetComponentAllocator<PrimaryComponent>()->End());
 			}
 			auto begin() { return Begin(); }
@@ -133,64 +381,175 @@ namespace Poly {
 		};
 
 	private:
-		friend class SpawnEntityDeferredTask;
+		friend class Entity;
+		friend class DeferredCommandBuffer;
+		friend class WorldSerializer;
+		friend class WorldSnapshot;
 		friend class DestroyEntityDeferredTask;
 		template<typename T,typename... Args> friend class AddComponentDeferredTask;
 		template<typename T> friend class RemoveComponentDeferredTask;
 
-		friend UniqueID DeferredTaskSystem::SpawnEntityImmediate(World*);
-		friend void DeferredTaskSystem::DestroyEntityImmediate(World* w, const UniqueID& entityId);
-		template<typename T, typename ...Args> friend void DeferredTaskSystem::AddComponentImmediate(World* w, const UniqueID & entityId, Args && ...args);
+		friend EntityID DeferredTaskSystem::SpawnEntityImmediate(World*);
+		template<typename... Components, typename... ArgTuples> friend Dynarray<EntityID> DeferredTaskSystem::SpawnEntitiesImmediate(World* w, size_t count, const ArgTuples&... args);
+		friend void DeferredTaskSystem::DestroyEntitiesImmediate(World* w, const Dynarray<EntityID>& entityIds);
+		friend void DeferredTaskSystem::DestroyEntityImmediate(World* w, const EntityID& entityId);
+		template<typename T, typename ...Args> friend void DeferredTaskSystem::AddComponentImmediate(World* w, const EntityID & entityId, Args && ...args);
 		template<typename T, typename ...Args> friend void DeferredTaskSystem::AddWorldComponentImmediate(World* w, Args && ...args);
 		template<typename T> friend void DeferredTaskSystem::RemoveWorldComponentImmediate(World* w);
 
 		//------------------------------------------------------------------------------
-		UniqueID SpawnEntity();
+		EntityID SpawnEntity() { return SpawnEntity(ReserveEntityID()); }
+		EntityID SpawnEntity(const EntityID& reservedId);
+
+		//------------------------------------------------------------------------------
+		// Reserves count IDs at once and appends them to ids.
+		void ReserveEntityIDs(size_t count, Dynarray<EntityID>& ids);
 
 		//------------------------------------------------------------------------------
-		void DestroyEntity(const UniqueID& entityId);
+		// Spawns count entities owning all Components, constructed from matching tuples of constructor arguments.
+		// Component IDs, pools and the archetype are resolved once for the whole batch and every entity is placed
+		// directly in its final archetype.
+		template<typename... Components, typename... ArgTuples>
+		void SpawnEntities(size_t count, Dynarray<EntityID>& ids, const ArgTuples&... args)
+		{
+			STATIC_ASSERTE(sizeof...(Components) > 0, "SpawnEntities needs at least one component.");
+			STATIC_ASSERTE(sizeof...(Components) == sizeof...(ArgTuples), "Every component needs a tuple of constructor arguments.");
+			const std::array<size_t, sizeof...(Components)> componentIDs = {{ gEngine->GetComponentID<Components>()... }};
+			ComponentSignature signature;
+			for (size_t id : componentIDs)
+			{
+				HEAVY_ASSERTE(!signature[id], "Component listed twice!");
+				signature.set(id);
+			}
+
+			Archetype* archetype = nullptr;
+			std::tuple<IterablePoolAllocator<Components>*...> pools;
+			if (Storage == eComponentStorage::ARCHETYPE)
+			{
+				Dynarray<ComponentTypeInfo> types = { ComponentTypeInfo::Create<Components>(gEngine->GetComponentID<Components>())... };
+				std::sort(types.Begin(), types.End(), [](const ComponentTypeInfo& a, const ComponentTypeInfo& b) { return a.ID < b.ID; });
+				archetype = GetArchetype(signature, types);
+			}
+			else
+				pools = std::make_tuple(GetComponentAllocator<Components>()...);
+
+			const size_t first = ids.GetSize();
+			ReserveEntityIDs(count, ids);
+			for (size_t i = first; i < ids.GetSize(); ++i)
+			{
+				SpawnEntity(ids[i]);
+				Entity* ent = EntitySlots[ids[i].Index].Ent;
+				if (archetype)
+				{
+					ent->EntityArchetype = archetype;
+					ent->ArchetypeRow = archetype->AddRow(ent);
+				}
+				ConstructComponents(ent, componentIDs, pools, std::index_sequence_for<Components...>(), args...);
+				UpdateQueryCaches(ent);
+			}
+		}
+
+		//------------------------------------------------------------------------------
+		// Type erased version of the above, used when component types are known only at runtime.
+		// types have to be sorted by ID, construct(entity, type, memory) has to construct component of types[type]
+		// for entity-th entity of the batch in given memory.
+		typedef std::function<void(size_t, size_t, void*)> ComponentConstructor;
+		void SpawnEntities(size_t count, const Dynarray<ComponentTypeInfo>& types, const ComponentConstructor& construct, Dynarray<EntityID>& ids);
+		// Same as above for count entities with already reserved IDs.
+		void SpawnReservedEntities(const EntityID* ids, size_t count, const Dynarray<ComponentTypeInfo>& types, const ComponentConstructor& construct);
+
+		template<typename... Components, size_t... Idx, typename... ArgTuples>
+		void ConstructComponents(Entity* ent, const std::array<size_t, sizeof...(Components)>& componentIDs,
+			const std::tuple<IterablePoolAllocator<Components>*...>& pools, std::index_sequence<Idx...>, const ArgTuples&... args)
+		{
+			int expand[] = { 0, (ConstructComponent(ent, componentIDs[Idx], std::get<Idx>(pools), args, std::make_index_sequence<std::tuple_size<ArgTuples>::value>()), 0)... };
+			UNUSED(expand);
+		}
+
+		template<typename T, typename... Args, size_t... Idx>
+		void ConstructComponent(Entity* ent, size_t componentID, IterablePoolAllocator<T>* pool, const std::tuple<Args...>& args, std::index_sequence<Idx...>)
+		{
+			STATIC_ASSERTE(Impl::ComponentTraits<T>::IsValid, "Components that do not derive from ComponentBase have to be trivially copyable and destructible.");
+			T* ptr = ent->EntityArchetype ? static_cast<T*>(ent->EntityArchetype->GetComponent(componentID, ent->ArchetypeRow)) : (pool ? pool->Alloc() : nullptr);
+			if (Impl::ComponentTraits<T>::Kind != eComponentKind::TAG)
+				::new(ptr) T(std::get<Idx>(args)...);
+			ent->AddComponentSlot(componentID, Impl::AsComponentBase(ptr));
+			AttachComponent(ent, ptr, std::is_base_of<ComponentBase, T>());
+			RecordAddition(ent, componentID);
+		}
+
+		//------------------------------------------------------------------------------
+		void DestroyEntity(const EntityID& entityId);
+
+		//------------------------------------------------------------------------------
+		// Destroys all alive entities from the list. Entities destroyed earlier as children of others are skipped.
+		void DestroyEntities(const Dynarray<EntityID>& entityIds);
 
 		//------------------------------------------------------------------------------
 		template<typename T, typename... Args>
-		void AddComponent(const UniqueID& entityId, Args&&... args)
+		void AddComponent(const EntityID& entityId, Args&&... args)
 		{
-			T* ptr = GetComponentAllocator<T>()->Alloc();
-			::new(ptr) T(std::forward<Args>(args)...);
-			Entity* ent = IDToEntityMap[entityId];
-			HEAVY_ASSERTE(ent, "Invalid entity ID");
-			HEAVY_ASSERTE(!ent->HasComponent(gEngine->GetComponentID<T>()), "Failed at AddComponent() - a component of a given UniqueID already exists!");
-			ent->ComponentPosessionFlags.set(gEngine->GetComponentID<T>(), true);
-			ent->Components[gEngine->GetComponentID<T>()] = ptr;
-			ptr->Owner = ent;
-			HEAVY_ASSERTE(ent->HasComponent(gEngine->GetComponentID<T>()), "Failed at AddComponent() - the component was not added!");
+			STATIC_ASSERTE(Impl::ComponentTraits<T>::IsValid, "Components that do not derive from ComponentBase have to be trivially copyable and destructible.");
+			MarkStructureChanged();
+			Entity* ent = GetEntity(entityId);
+			const size_t componentID = gEngine->GetComponentID<T>();
+			HEAVY_ASSERTE(!ent->HasComponent(componentID), "Failed at AddComponent() - a component of a given EntityID already exists!");
+			T* ptr = nullptr;
+			if (Storage == eComponentStorage::ARCHETYPE)
+			{
+				MoveToArchetype(ent, GetArchetypeWith(ent->EntityArchetype, ComponentTypeInfo::Create<T>(componentID)));
+				ptr = static_cast<T*>(ent->EntityArchetype->GetComponent(componentID, ent->ArchetypeRow));
+			}
+			else if (IterablePoolAllocator<T>* pool = GetComponentAllocator<T>())
+				ptr = pool->Alloc();
+			if (Impl::ComponentTraits<T>::Kind != eComponentKind::TAG)
+				::new(ptr) T(std::forward<Args>(args)...);
+			ent->AddComponentSlot(componentID, Impl::AsComponentBase(ptr));
+			AttachComponent(ent, ptr, std::is_base_of<ComponentBase, T>());
+			RecordAddition(ent, componentID);
+			UpdateQueryCaches(ent);
+			HEAVY_ASSERTE(ent->HasComponent(componentID), "Failed at AddComponent() - the component was not added!");
 		}
 
 		//------------------------------------------------------------------------------
 		template<typename T>
-		void RemoveComponent(const UniqueID& entityId)
-		{
-			Entity* ent = IDToEntityMap[entityId];
-			HEAVY_ASSERTE(ent, "Invalid entity ID");
-			HEAVY_ASSERTE(ent->HasComponent(gEngine->GetComponentID<T>()), "Failed at RemoveComponent() - a component of a given UniqueID does not exist!");
-			ent->ComponentPosessionFlags.set(gEngine->GetComponentID<T>(), false);
-			T* component = static_cast<T*>(ent->Components[gEngine->GetComponentID<T>()]);
-			ent->Components[gEngine->GetComponentID<T>()] = nullptr;
+		void RemoveComponent(const EntityID& entityId)
+		{
+			MarkStructureChanged();
+			Entity* ent = GetEntity(entityId);
+			const size_t componentID = gEngine->GetComponentID<T>();
+			HEAVY_ASSERTE(ent->HasComponent(componentID), "Failed at RemoveComponent() - a component of a given EntityID does not exist!");
+			T* component = Impl::ComponentCast<T>(ent->GetComponentById(componentID));
+			RecordRemoval(ent, componentID);
+			ent->RemoveComponentSlot(componentID);
+			UpdateQueryCaches(ent);
 			component->~T();
-			GetComponentAllocator<T>()->Free(component);
-			HEAVY_ASSERTE(!ent->HasComponent(gEngine->GetComponentID<T>()), "Failed at AddComponent() - the component was not removed!");
+			if (Storage == eComponentStorage::ARCHETYPE)
+				MoveToArchetype(ent, GetArchetypeWithout(ent->EntityArchetype, componentID));
+			else if (IterablePoolAllocator<T>* pool = GetComponentAllocator<T>())
+				pool->Free(component);
+			HEAVY_ASSERTE(!ent->HasComponent(componentID), "Failed at AddComponent() - the component was not removed!");
 		}
 
 		//------------------------------------------------------------------------------
+		// Returns pool of given component type, tags have none and nullptr is returned for them.
 		template<typename T>
 		IterablePoolAllocator<T>* GetComponentAllocator()
 		{
 			size_t componentID = gEngine->GetComponentID<T>();
 			HEAVY_ASSERTE(componentID < MAX_COMPONENTS_COUNT, "Invalid component ID");
-			if (ComponentAllocators[componentID] == nullptr)
-				ComponentAllocators[componentID] = new IterablePoolAllocator<T>(MAX_ENTITY_COUNT);
+			if (ComponentAllocators[componentID] == nullptr && !TagComponentIDs[componentID])
+				RegisterPoolComponentType(ComponentTypeInfo::Create<T>(componentID));
 			return static_cast<IterablePoolAllocator<T>*>(ComponentAllocators[componentID]);
 		}
 
+		// Creates pool for the type, tags are only recorded in TagComponentIDs
+		void RegisterPoolComponentType(const ComponentTypeInfo& type);
+
+		// Components deriving from ComponentBase get their owner and are stamped as changed, plain components and tags keep neither
+		static void AttachComponent(Entity* ent, ComponentBase* component, std::true_type) { component->Owner = ent; component->MarkChanged(); }
+		static void AttachComponent(Entity*, void*, std::false_type) {}
+
 		//------------------------------------------------------------------------------
 		template<typename T, typename... Args>
 		void AddWorldComponent(Args&&... args)
@@ -209,25 +568,150 @@ namespace Poly {
 			component->~T();
 		}
 
-		std::unordered_map<UniqueID, Entity*> IDToEntityMap;
+		//------------------------------------------------------------------------------
+		Entity* GetEntity(const EntityID& entityId) const
+		{
+			HEAVY_ASSERTE(IsEntityAlive(entityId), "Invalid entityId - entity with that ID does not exist!");
+			return EntitySlots[entityId.Index].Ent;
+		}
 
 		void RemoveComponentById(Entity* ent, size_t id);
 
+		//------------------------------------------------------------------------------
+		// Returns the smallest pool of given components that knows owners of its cells, nullptr if there is none
+		const IterablePoolAllocatorBase* GetSmallestPool(const ComponentSignature& components) const;
+		QueryCache* GetQueryCache(const QueryFilter& filter);
+		SortedQueryCache* GetSortedQueryCache(const QueryFilter& filter, size_t keyComponentID, SortedQueryCache::KeyFunctionID keyID, const SortedQueryCache::KeyFunction& key);
+
+		//------------------------------------------------------------------------------
+		// Part of component storage processed by a single task of ParallelForEach(). Rows of an archetype or cells of a pool.
+		struct ComponentRange
+		{
+			Archetype* RangeArchetype = nullptr;
+			size_t Begin = 0;
+			size_t End = 0;
+		};
+		// With pool storage entities is set instead of pool when there are only plain components and tags, ranges are indices into it then
+		Dynarray<ComponentRange> SplitIntoRanges(const ComponentSignature& components, size_t grainSize, const IterablePoolAllocatorBase*& pool, const Dynarray<Entity*>*& entities);
+
+		template<typename... Components, typename Function, size_t... Idx>
+		static void InvokeForRow(const Function& function, const Archetype* archetype, size_t row, const std::array<size_t, sizeof...(Components)>& ids, std::index_sequence<Idx...>)
+		{
+			function(static_cast<Components*>(archetype->GetComponent(ids[Idx], row))...);
+		}
+
+		template<typename... Components, typename Function, size_t... Idx>
+		static void InvokeForEntity(const Function& function, const Entity* entity, const std::array<size_t, sizeof...(Components)>& ids, std::index_sequence<Idx...>)
+		{
+			function(Impl::ComponentCast<Components>(entity->GetComponentById(ids[Idx]))...);
+		}
+		void UpdateQueryCaches(Entity* ent);
+
+		//------------------------------------------------------------------------------
+		Archetype* GetArchetypeWith(Archetype* archetype, const ComponentTypeInfo& type);
+		Archetype* GetArchetypeWithout(Archetype* archetype, size_t componentID);
+		Archetype* GetArchetype(const ComponentSignature& signature, const Dynarray<ComponentTypeInfo>& types);
+		void MoveToArchetype(Entity* ent, Archetype* archetype);
+
+		// Gives the world a new unique structure version and invalidates transform hierarchy, called by every spawn, destroy and component addition or removal.
+		void MarkStructureChanged();
+
+		//------------------------------------------------------------------------------
+		// Observers of a single component type and events collected for them since the last dispatch
+		typedef std::function<void(World*, const Dynarray<EntityID>&)> ObserverFunction;
+		struct ComponentObservers
+		{
+			Dynarray<ObserverFunction> OnAdd;
+			Dynarray<ObserverFunction> OnRemove;
+			Dynarray<EntityID> Added;
+			Dynarray<EntityID> Removed;
+		};
+		ComponentObservers& GetObservers(size_t componentID);
+
+		void RecordAddition(const Entity* ent, size_t componentID)
+		{
+			if (ObservedAdditions[componentID])
+				Observers[componentID]->Added.PushBack(ent->GetID());
+		}
+		void RecordRemoval(const Entity* ent, size_t componentID)
+		{
+			if (ObservedRemovals[componentID])
+				Observers[componentID]->Removed.PushBack(ent->GetID());
+		}
+
+		const eComponentStorage Storage;
+		const size_t MaxEntityCount;
+		const bool UseHugePages;
+
+		// Entity slot table, EntityID indexes into it. Slots are committed on demand and zero initialized,
+		// so slot stores count of entities destroyed in it and handles use that count plus one as generation.
+		struct EntitySlot
+		{
+			Entity* Ent;
+			uint32_t Version;
+		};
+		VirtualMemoryRange EntitySlotMemory;
+		EntitySlot* EntitySlots = nullptr;
+		std::atomic<size_t> EntitySlotCount;
+		// Stack of indices of slots released by destroyed entities
+		VirtualMemoryRange FreeEntitySlotMemory;
+		size_t* FreeEntitySlots = nullptr;
+		std::atomic<size_t> FreeEntitySlotCount;
+
 		// Allocators
 		PoolAllocator<Entity> EntitiesAllocator;
 		IterablePoolAllocatorBase* ComponentAllocators[MAX_COMPONENTS_COUNT];
+		// Type of components kept in each allocator, used when pooled components are handled without knowing their static type
+		ComponentTypeInfo PoolComponentTypes[MAX_COMPONENTS_COUNT];
+		// Tags used with pool storage, entities do not keep pointers for them
+		ComponentSignature TagComponentIDs;
+		// Plain components and tags used with pool storage, their cells do not know their owners
+		ComponentSignature OwnerlessComponentIDs;
+
+		// Archetype storage
+		Dynarray<Archetype*> Archetypes;
+		std::unordered_map<ComponentSignature, Archetype*> ArchetypesBySignature;
 
 		ComponentBase* WorldComponents[MAX_COMPONENTS_COUNT];
+
+		// Starts from 1, so components added at any time are newer than the default changedSince
+		std::atomic<uint32_t> ChangeVersion;
+
+		// Equal versions mean equal sets of entities and components, also across worlds. Used by snapshots to copy only changed components.
+		uint64_t StructureVersion = 0;
+
+		TransformHierarchy Hierarchy;
+
+		std::unique_ptr<ComponentObservers> Observers[MAX_COMPONENTS_COUNT];
+		ComponentSignature ObservedAdditions;
+		ComponentSignature ObservedRemovals;
+
+		Dynarray<QueryCache*> QueryCaches;
+		Dynarray<SortedQueryCache*> SortedQueryCaches;
+		// Cached queries can be created by update phase functions running concurrently
+		std::mutex QueryCachesMutex;
 	};
 
 	//defined here due to circular inclusion problem; FIXME: circular inclusion
 	template<typename T>
 	T* Entity::GetComponent()
 	{
-		if (HasComponent(gEngine->GetComponentID<T>()))
-			return static_cast<T*>(Components[gEngine->GetComponentID<T>()]);
-		else
+		return Impl::ComponentCast<T>(GetComponentById(gEngine->GetComponentID<T>()));
+	}
+
+	//defined here due to circular inclusion problem; FIXME: circular inclusion
+	inline ComponentBase* Entity::GetComponentById(size_t componentID) const
+	{
+		HEAVY_ASSERTE(componentID < MAX_COMPONENTS_COUNT, "Invalid component ID - greater than MAX_COMPONENTS_COUNT.");
+		if (!ComponentPosessionFlags[componentID])
 			return nullptr;
+		if (EntityArchetype)
+			return static_cast<ComponentBase*>(EntityArchetype->GetComponent(componentID, ArchetypeRow));
+		// tags have no storage, any valid address will do for them
+		const ComponentSignature& tags = EntityWorld->TagComponentIDs;
+		if (tags[componentID])
+			return reinterpret_cast<ComponentBase*>(const_cast<ComponentSignature*>(&ComponentPosessionFlags));
+		return Components[ComponentRank(ComponentPosessionFlags & ~tags, componentID)];
 	}
 
 } //namespace Poly
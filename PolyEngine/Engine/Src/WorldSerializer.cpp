@@ -0,0 +1,464 @@
+#include "EnginePCH.hpp"
+
+#include "WorldSerializer.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	constexpr uint32_t WORLD_DATA_MAGIC = 0x444C5750; // "PWLD"
+	constexpr uint32_t WORLD_DATA_VERSION = 1;
+	constexpr uint32_t NO_PATH_ID = std::numeric_limits<uint32_t>::max();
+
+	void WriteVector(BinaryWriter& writer, const Vector& v)
+	{
+		writer.Write(v.X);
+		writer.Write(v.Y);
+		writer.Write(v.Z);
+	}
+
+	Vector ReadVector(BinaryReader& reader)
+	{
+		const float x = reader.Read<float>();
+		const float y = reader.Read<float>();
+		const float z = reader.Read<float>();
+		return Vector(x, y, z);
+	}
+
+	void WriteQuaternion(BinaryWriter& writer, const Quaternion& q)
+	{
+		writer.Write(q.X);
+		writer.Write(q.Y);
+		writer.Write(q.Z);
+		writer.Write(q.W);
+	}
+
+	Quaternion ReadQuaternion(BinaryReader& reader)
+	{
+		Quaternion q;
+		q.X = reader.Read<float>();
+		q.Y = reader.Read<float>();
+		q.Z = reader.Read<float>();
+		q.W = reader.Read<float>();
+		return q;
+	}
+}
+
+//------------------------------------------------------------------------------
+uint32_t WorldSaveContext::GetPathID(const String& path)
+{
+	// worlds refer to few distinct resources, so linear search is fine
+	const size_t idx = Paths.FindIdx(path);
+	if (idx < Paths.GetSize())
+		return static_cast<uint32_t>(idx);
+	Paths.PushBack(path);
+	return static_cast<uint32_t>(Paths.GetSize() - 1);
+}
+
+//------------------------------------------------------------------------------
+const String& WorldLoadContext::GetPath(uint32_t pathID) const
+{
+	if (pathID >= Paths.GetSize())
+		throw FileIOException("Invalid resource path ID!");
+	return Paths[pathID];
+}
+
+//------------------------------------------------------------------------------
+WorldSerializer::WorldSerializer()
+{
+	RegisterEngineComponents();
+}
+
+//------------------------------------------------------------------------------
+void WorldSerializer::AddSerializer(ComponentSerializer&& serializer)
+{
+	const size_t componentID = serializer.Type.ID;
+	HEAVY_ASSERTE(componentID < MAX_COMPONENTS_COUNT, "Invalid component ID");
+	ASSERTE(!Registered[componentID], "Component is already registered for serialization!");
+	for (const ComponentSerializer& other : Serializers)
+		ASSERTE(!(serializer.Name == other.Name), "Serialization name is already used by other component!");
+	Registered.set(componentID);
+	SerializerByID[componentID] = Serializers.GetSize();
+	Serializers.PushBack(std::move(serializer));
+}
+
+//------------------------------------------------------------------------------
+void WorldSerializer::RegisterEngineComponents()
+{
+	RegisterComponent<TransformComponent>("Transform",
+		[](const TransformComponent& transform, BinaryWriter& writer, WorldSaveContext&)
+		{
+			WriteVector(writer, transform.GetLocalTranslation());
+			WriteQuaternion(writer, transform.GetLocalRotation());
+			WriteVector(writer, transform.GetLocalScale());
+		},
+		[](BinaryReader& reader, const WorldLoadContext&)
+		{
+			// parents are attached after all entities are spawned
+			TransformComponent transform;
+			transform.SetLocalTranslation(ReadVector(reader));
+			transform.SetLocalRotation(ReadQuaternion(reader));
+			transform.SetLocalScale(ReadVector(reader));
+			return transform;
+		});
+
+	RegisterComponent<CameraComponent>("Camera",
+		[](const CameraComponent& camera, BinaryWriter& writer, WorldSaveContext&)
+		{
+			writer.Write<uint8_t>(camera.IsPerspective ? 1 : 0);
+			writer.Write(camera.Fov.AsRadians());
+			writer.Write(camera.Top);
+			writer.Write(camera.Bottom);
+			writer.Write(camera.Left);
+			writer.Write(camera.Right);
+			writer.Write(camera.Near);
+			writer.Write(camera.Far);
+		},
+		[](BinaryReader& reader, const WorldLoadContext&)
+		{
+			const bool isPerspective = reader.Read<uint8_t>() != 0;
+			const Angle fov = Angle::FromRadians(reader.Read<float>());
+			const float top = reader.Read<float>();
+			const float bottom = reader.Read<float>();
+			const float left = reader.Read<float>();
+			const float right = reader.Read<float>();
+			const float zNear = reader.Read<float>();
+			const float zFar = reader.Read<float>();
+			return isPerspective ? CameraComponent(fov, zNear, zFar) : CameraComponent(top, bottom, left, right, zNear, zFar);
+		});
+
+	RegisterComponent<MeshRenderingComponent>("MeshRendering",
+		[](const MeshRenderingComponent& meshRendering, BinaryWriter& writer, WorldSaveContext& context)
+		{
+			writer.Write<uint32_t>(meshRendering.GetMesh() ? context.GetPathID(meshRendering.GetMesh()->GetPath()) : NO_PATH_ID);
+		},
+		[](BinaryReader& reader, const WorldLoadContext& context)
+		{
+			// mesh that failed to load is stored without path and fails to load again
+			const uint32_t pathID = reader.Read<uint32_t>();
+			return MeshRenderingComponent(pathID != NO_PATH_ID ? context.GetPath(pathID) : String());
+		});
+
+	RegisterPlainComponent<FreeFloatMovementComponent>("FreeFloatMovement");
+}
+
+//------------------------------------------------------------------------------
+Dynarray<uint8_t> WorldSerializer::Save(World* world) const
+{
+	// group entities by the set of serializable components, every group is spawned by a single batch when loading
+	struct Group
+	{
+		ComponentSignature Signature;
+		Dynarray<const Entity*> Entities;
+	};
+	Dynarray<Group> groups;
+	std::unordered_map<ComponentSignature, size_t> groupBySignature;
+	ComponentSignature usedComponents;
+
+	const size_t slotCount = std::min(world->EntitySlotCount.load(), world->MaxEntityCount);
+	for (size_t i = 0; i < slotCount; ++i)
+	{
+		const Entity* ent = world->EntitySlots[i].Ent;
+		if (!ent)
+			continue;
+		const ComponentSignature signature = ent->ComponentPosessionFlags & Registered;
+		auto it = groupBySignature.find(signature);
+		if (it == groupBySignature.end())
+		{
+			it = groupBySignature.emplace(signature, groups.GetSize()).first;
+			groups.PushBack(Group());
+			groups[it->second].Signature = signature;
+			usedComponents |= signature;
+		}
+		groups[it->second].Entities.PushBack(ent);
+	}
+
+	// entities are stored group by group, hierarchy refers to them by position in that order
+	Dynarray<uint32_t> entityIndexBySlot;
+	entityIndexBySlot.Resize(slotCount);
+	uint32_t entityCount = 0;
+	for (const Group& group : groups)
+		for (const Entity* ent : group.Entities)
+			entityIndexBySlot[ent->GetID().GetIndex()] = entityCount++;
+
+	WorldSaveContext context;
+	BinaryWriter body;
+	body.Write<uint32_t>(entityCount);
+	body.Write<uint32_t>(static_cast<uint32_t>(groups.GetSize()));
+	for (const Group& group : groups)
+	{
+		const size_t count = group.Entities.GetSize();
+		body.Write<uint32_t>(static_cast<uint32_t>(count));
+		body.Write<uint32_t>(static_cast<uint32_t>(group.Signature.count()));
+		for (size_t id = NextComponentID(group.Signature, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(group.Signature, id + 1))
+			body.Write<uint32_t>(static_cast<uint32_t>(ComponentRank(usedComponents, id)));
+
+		// one array per component type, prefixed with its size so loaders can skip unknown types
+		for (size_t id = NextComponentID(group.Signature, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(group.Signature, id + 1))
+		{
+			const ComponentSerializer& serializer = Serializers[SerializerByID[id]];
+			const size_t sizeOffset = body.GetSize();
+			body.Write<uint32_t>(0);
+			if (serializer.IsPlain)
+			{
+				uint8_t* dst = body.Grow(serializer.PlainSize * count);
+				for (const Entity* ent : group.Entities)
+				{
+					memcpy(dst, reinterpret_cast<const uint8_t*>(ent->GetComponentById(id)) + serializer.PlainOffset, serializer.PlainSize);
+					dst += serializer.PlainSize;
+				}
+			}
+			else
+			{
+				for (const Entity* ent : group.Entities)
+					serializer.Save(ent->GetComponentById(id), body, context);
+			}
+			body.Patch<uint32_t>(sizeOffset, static_cast<uint32_t>(body.GetSize() - sizeOffset - sizeof(uint32_t)));
+		}
+	}
+
+	// hierarchy as (child, parent) pairs, children of every parent keep their order
+	const size_t linkCountOffset = body.GetSize();
+	uint32_t linkCount = 0;
+	body.Write<uint32_t>(0);
+	if (Registered[gEngine->GetComponentID<TransformComponent>()])
+	{
+		for (const Group& group : groups)
+			for (const Entity* ent : group.Entities)
+			{
+				const TransformComponent* transform = static_cast<const TransformComponent*>(ent->GetComponentById(gEngine->GetComponentID<TransformComponent>()));
+				if (!transform)
+					continue;
+				for (const TransformComponent* child : transform->GetChildren())
+				{
+					body.Write<uint32_t>(entityIndexBySlot[child->GetOwnerID().GetIndex()]);
+					body.Write<uint32_t>(entityIndexBySlot[ent->GetID().GetIndex()]);
+					++linkCount;
+				}
+			}
+	}
+	body.Patch<uint32_t>(linkCountOffset, linkCount);
+
+	// header and tables go first, so loader knows all types and paths before reading components
+	BinaryWriter writer;
+	writer.Write<uint32_t>(WORLD_DATA_MAGIC);
+	writer.Write<uint32_t>(WORLD_DATA_VERSION);
+	writer.Write<uint32_t>(static_cast<uint32_t>(context.Paths.GetSize()));
+	for (const String& path : context.Paths)
+		writer.WriteString(path);
+	writer.Write<uint32_t>(static_cast<uint32_t>(usedComponents.count()));
+	for (size_t id = NextComponentID(usedComponents, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(usedComponents, id + 1))
+	{
+		const ComponentSerializer& serializer = Serializers[SerializerByID[id]];
+		writer.WriteString(serializer.Name);
+		writer.Write<uint8_t>(serializer.IsPlain ? 1 : 0);
+		writer.Write<uint32_t>(static_cast<uint32_t>(serializer.PlainSize));
+	}
+	writer.WriteBytes(body.GetBuffer().GetData(), body.GetSize());
+	return writer.GetBuffer();
+}
+
+//------------------------------------------------------------------------------
+Dynarray<EntityID> WorldSerializer::Load(World* world, const Dynarray<uint8_t>& data) const
+{
+	BinaryReader reader(data);
+	if (reader.Read<uint32_t>() != WORLD_DATA_MAGIC || reader.Read<uint32_t>() != WORLD_DATA_VERSION)
+		throw FileIOException("Invalid world data!");
+
+	WorldLoadContext context;
+	const uint32_t pathCount = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < pathCount; ++i)
+		context.Paths.PushBack(reader.ReadString());
+
+	// serializer for every saved type, nullptr for types that are not registered here - their data is skipped
+	Dynarray<const ComponentSerializer*> savedTypes;
+	const uint32_t typeCount = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < typeCount; ++i)
+	{
+		String name = reader.ReadString();
+		const bool isPlain = reader.Read<uint8_t>() != 0;
+		const uint32_t plainSize = reader.Read<uint32_t>();
+		const ComponentSerializer* found = nullptr;
+		for (const ComponentSerializer& serializer : Serializers)
+			if (name == serializer.Name)
+				found = &serializer;
+		if (found && (found->IsPlain != isPlain || (isPlain && found->PlainSize != plainSize)))
+			throw FileIOException("Saved component layout does not match the registered one!");
+		savedTypes.PushBack(found);
+	}
+
+	// Decode everything before spawning, so invalid data throws before the world is modified.
+	// Custom components are constructed in an arena and relocated into the world later, plain ones are copied straight from data.
+	struct DecodedColumn
+	{
+		const ComponentSerializer* Serializer = nullptr;
+		const uint8_t* PlainData = nullptr;
+		uint8_t* Objects = nullptr;
+		size_t ConstructedCount = 0;
+	};
+	struct DecodedGroup
+	{
+		size_t EntityCount = 0;
+		size_t FirstEntity = 0;
+		Dynarray<DecodedColumn> Columns;
+	};
+	// destroys decoded components that were not moved into the world, also when decoding throws
+	struct DecodedData
+	{
+		~DecodedData()
+		{
+			for (DecodedGroup& group : Groups)
+				for (DecodedColumn& column : group.Columns)
+					for (size_t i = 0; i < column.ConstructedCount; ++i)
+						column.Serializer->Type.Destroy(column.Objects + i * column.Serializer->Type.Size);
+		}
+		LinearAllocator Arena;
+		Dynarray<DecodedGroup> Groups;
+	} decoded;
+
+	const uint32_t entityCount = reader.Read<uint32_t>();
+	const uint32_t groupCount = reader.Read<uint32_t>();
+	// parent of every saved entity, filled from the hierarchy table
+	const uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+	const uint32_t NO_TRANSFORM = NO_PARENT - 1;
+	Dynarray<uint32_t> parents;
+	size_t decodedEntityCount = 0;
+	for (uint32_t g = 0; g < groupCount; ++g)
+	{
+		decoded.Groups.PushBack(DecodedGroup());
+		DecodedGroup& group = decoded.Groups[decoded.Groups.GetSize() - 1];
+		group.EntityCount = reader.Read<uint32_t>();
+		group.FirstEntity = decodedEntityCount;
+		decodedEntityCount += group.EntityCount;
+		if (decodedEntityCount > entityCount)
+			throw FileIOException("Invalid world data!");
+
+		const uint32_t groupTypeCount = reader.Read<uint32_t>();
+		Dynarray<const ComponentSerializer*> groupTypes;
+		for (uint32_t t = 0; t < groupTypeCount; ++t)
+		{
+			const uint32_t typeIdx = reader.Read<uint32_t>();
+			if (typeIdx >= savedTypes.GetSize())
+				throw FileIOException("Invalid world data!");
+			groupTypes.PushBack(savedTypes[typeIdx]);
+		}
+
+		for (const ComponentSerializer* serializer : groupTypes)
+		{
+			const uint32_t size = reader.Read<uint32_t>();
+			const uint8_t* columnData = reader.ReadBytes(size);
+			if (!serializer)
+				continue;
+
+			group.Columns.PushBack(DecodedColumn());
+			DecodedColumn& column = group.Columns[group.Columns.GetSize() - 1];
+			column.Serializer = serializer;
+			if (serializer->IsPlain)
+			{
+				if (size != serializer->PlainSize * group.EntityCount)
+					throw FileIOException("Invalid world data!");
+				column.PlainData = columnData;
+				continue;
+			}
+
+			column.Objects = static_cast<uint8_t*>(decoded.Arena.Alloc(serializer->Type.Size * group.EntityCount, serializer->Type.Alignment));
+			BinaryReader columnReader(columnData, size);
+			for (size_t i = 0; i < group.EntityCount; ++i)
+			{
+				serializer->Load(column.Objects + i * serializer->Type.Size, columnReader, context);
+				++column.ConstructedCount;
+			}
+			if (!columnReader.IsAtEnd())
+				throw FileIOException("Invalid world data!");
+		}
+
+		// component IDs of this build can be ordered differently than in the saving one
+		std::sort(group.Columns.Begin(), group.Columns.End(), [](const DecodedColumn& a, const DecodedColumn& b) { return a.Serializer->Type.ID < b.Serializer->Type.ID; });
+		for (size_t i = 1; i < group.Columns.GetSize(); ++i)
+			if (group.Columns[i - 1].Serializer == group.Columns[i].Serializer)
+				throw FileIOException("Invalid world data!");
+
+		bool hasTransform = false;
+		for (const DecodedColumn& column : group.Columns)
+			hasTransform |= column.Serializer->Type.ID == gEngine->GetComponentID<TransformComponent>();
+		for (size_t i = 0; i < group.EntityCount; ++i)
+			parents.PushBack(hasTransform ? NO_PARENT : NO_TRANSFORM);
+	}
+	if (decodedEntityCount != entityCount)
+		throw FileIOException("Invalid world data!");
+
+	Dynarray<uint32_t> links;
+	const uint32_t linkCount = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < linkCount; ++i)
+	{
+		const uint32_t child = reader.Read<uint32_t>();
+		const uint32_t parent = reader.Read<uint32_t>();
+		if (child >= entityCount || parent >= entityCount || parents[child] != NO_PARENT || parents[parent] == NO_TRANSFORM)
+			throw FileIOException("Invalid world hierarchy!");
+		parents[child] = parent;
+		links.PushBack(child);
+		links.PushBack(parent);
+	}
+	if (!reader.IsAtEnd())
+		throw FileIOException("Invalid world data!");
+
+	// every entity has at most one parent, so a cycle is found by walking up from every entity once
+	// 0 - not visited, 1 - on the current path, 2 - known to lead to a root
+	Dynarray<uint8_t> visited;
+	for (uint32_t i = 0; i < entityCount; ++i)
+		visited.PushBack(0);
+	for (uint32_t i = 0; i < entityCount; ++i)
+	{
+		uint32_t e = i;
+		while (visited[e] == 0)
+		{
+			visited[e] = 1;
+			if (parents[e] >= entityCount)
+				break;
+			e = parents[e];
+		}
+		if (visited[e] == 1 && parents[e] < entityCount)
+			throw FileIOException("Invalid world hierarchy!");
+		for (e = i; visited[e] == 1; e = parents[e])
+		{
+			visited[e] = 2;
+			if (parents[e] >= entityCount)
+				break;
+		}
+	}
+
+	// nothing below can fail
+	Dynarray<EntityID> ids;
+	ids.Reserve(entityCount);
+	for (DecodedGroup& group : decoded.Groups)
+	{
+		Dynarray<ComponentTypeInfo> types;
+		for (const DecodedColumn& column : group.Columns)
+			types.PushBack(column.Serializer->Type);
+
+		world->SpawnEntities(group.EntityCount, types, [&group](size_t entity, size_t type, void* memory)
+		{
+			const DecodedColumn& column = group.Columns[type];
+			const ComponentSerializer* serializer = column.Serializer;
+			if (serializer->IsPlain)
+			{
+				serializer->Construct(memory);
+				memcpy(static_cast<uint8_t*>(memory) + serializer->PlainOffset, column.PlainData + entity * serializer->PlainSize, serializer->PlainSize);
+			}
+			else
+				serializer->Type.Relocate(memory, column.Objects + entity * serializer->Type.Size);
+		}, ids);
+
+		// relocation destroyed decoded objects
+		for (DecodedColumn& column : group.Columns)
+			column.ConstructedCount = 0;
+	}
+
+	for (size_t i = 0; i < links.GetSize(); i += 2)
+	{
+		TransformComponent* child = world->GetComponent<TransformComponent>(ids[links[i]]);
+		TransformComponent* parent = world->GetComponent<TransformComponent>(ids[links[i + 1]]);
+		child->AttachToParent(parent);
+	}
+	return ids;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <Core.hpp>
+
+#include "Archetype.hpp"
+#include "ComponentBase.hpp"
+#include "EntityID.hpp"
+
+namespace Poly
+{
+	class World;
+
+	/// <summary>State of a single <see cref="WorldSerializer.Save()"/> call, passed to component save functions.</summary>
+	class ENGINE_DLLEXPORT WorldSaveContext : public BaseObject<>
+	{
+	public:
+		/// <summary>Returns ID of resource path in the path table of saved data.
+		/// Equal paths get equal IDs, so every resource path is stored once no matter how many components refer to it.</summary>
+		uint32_t GetPathID(const String& path);
+
+	private:
+		Dynarray<String> Paths;
+		friend class WorldSerializer;
+	};
+
+	/// <summary>State of a single <see cref="WorldSerializer.Load()"/> call, passed to component load functions.</summary>
+	class ENGINE_DLLEXPORT WorldLoadContext : public BaseObject<>
+	{
+	public:
+		/// <summary>Returns resource path stored with WorldSaveContext::GetPathID(). Throws FileIOException for unknown IDs.</summary>
+		const String& GetPath(uint32_t pathID) const;
+
+	private:
+		Dynarray<String> Paths;
+		friend class WorldSerializer;
+	};
+
+	/// <summary>Saves all entities of a world into a compact binary blob and spawns them back into any world.</summary>
+	/// <para>Entities are grouped by the set of serializable components they own and every group stores one array per component type,
+	/// so loading spawns each group in a single batch that is placed directly in its final archetype.
+	/// Components registered as plain are stored as raw bytes and copied with memcpy, others use their own save and load functions.
+	/// Resources are referenced by path IDs from a path table and TransformComponent hierarchy is stored as a table of entity indices,
+	/// so no pointers are written. Components of types that were not registered are not saved.</para>
+	/// <para>Saved data uses native byte order and layout, so it is meant for save games and level streaming on the same platform,
+	/// not for data exchange. Component types are matched by registration name, so component IDs may change between builds.</para>
+	class ENGINE_DLLEXPORT WorldSerializer : public BaseObject<>
+	{
+	public:
+		/// <summary>Creates serializer with all serializable engine components registered.</summary>
+		WorldSerializer();
+
+		/// <summary>Registers component that is stored as a raw copy of its bytes following ComponentBase.
+		/// Loaded components are default constructed and then overwritten, so the type must be default constructible
+		/// and its members must be trivially copyable (no pointers, containers or strings).
+		/// Plain components and tags, which do not derive from ComponentBase, are copied whole.</summary>
+		/// <param name="name">Name identifying the type in saved data.</param>
+		template<typename T>
+		void RegisterPlainComponent(const String& name)
+		{
+			STATIC_ASSERTE(std::is_default_constructible<T>::value, "Plain components have to be default constructible.");
+			ComponentSerializer serializer;
+			serializer.Name = name;
+			serializer.Type = ComponentTypeInfo::Create<T>(gEngine->GetComponentID<T>());
+			serializer.IsPlain = true;
+			serializer.PlainOffset = Impl::ComponentTraits<T>::Kind == eComponentKind::REGULAR ? sizeof(ComponentBase) : 0;
+			serializer.PlainSize = Impl::ComponentTraits<T>::Kind == eComponentKind::TAG ? 0 : sizeof(T) - serializer.PlainOffset;
+			serializer.Construct = [](void* memory) { ::new(memory) T(); };
+			AddSerializer(std::move(serializer));
+		}
+
+		/// <summary>Registers component that is stored with custom functions.</summary>
+		/// <param name="name">Name identifying the type in saved data.</param>
+		/// <param name="save">Callable taking (const T&, BinaryWriter&, WorldSaveContext&) that writes the component.</param>
+		/// <param name="load">Callable taking (BinaryReader&, const WorldLoadContext&) that reads data written by save and returns T.
+		/// It can throw on invalid data, the world is not modified then.</param>
+		template<typename T, typename SaveFunction, typename LoadFunction>
+		void RegisterComponent(const String& name, const SaveFunction& save, const LoadFunction& load)
+		{
+			STATIC_ASSERTE((std::is_base_of<ComponentBase, T>::value), "Only components can be serialized.");
+			ComponentSerializer serializer;
+			serializer.Name = name;
+			serializer.Type = ComponentTypeInfo::Create<T>(gEngine->GetComponentID<T>());
+			serializer.Save = [save](const ComponentBase* component, BinaryWriter& writer, WorldSaveContext& context) { save(*static_cast<const T*>(component), writer, context); };
+			serializer.Load = [load](void* memory, BinaryReader& reader, const WorldLoadContext& context) { ::new(memory) T(load(reader, context)); };
+			AddSerializer(std::move(serializer));
+		}
+
+		/// <summary>Saves all entities of the world.</summary>
+		Dynarray<uint8_t> Save(World* world) const;
+
+		/// <summary>Spawns entities saved with Save() into the world, next to entities it already has.
+		/// Data is decoded before anything is spawned, so on invalid data FileIOException is thrown and the world is left untouched.</summary>
+		/// <returns>IDs of spawned entities in the order of saving.</returns>
+		Dynarray<EntityID> Load(World* world, const Dynarray<uint8_t>& data) const;
+
+		void SaveToFile(World* world, const String& path) const { SaveBinaryFile(path, Save(world)); }
+		Dynarray<EntityID> LoadFromFile(World* world, const String& path) const { return Load(world, LoadBinaryFile(path)); }
+
+	private:
+		struct ComponentSerializer
+		{
+			String Name;
+			ComponentTypeInfo Type;
+			bool IsPlain = false;
+			// Bytes of plain components copied, starting after ComponentBase if they derive from it
+			size_t PlainOffset = 0;
+			size_t PlainSize = 0;
+			void (*Construct)(void* memory) = nullptr;
+			std::function<void(const ComponentBase*, BinaryWriter&, WorldSaveContext&)> Save;
+			std::function<void(void*, BinaryReader&, const WorldLoadContext&)> Load;
+		};
+
+		void AddSerializer(ComponentSerializer&& serializer);
+		void RegisterEngineComponents();
+
+		Dynarray<ComponentSerializer> Serializers;
+		// IDs of registered components and index of serializer for each of them
+		ComponentSignature Registered;
+		std::array<size_t, MAX_COMPONENTS_COUNT> SerializerByID;
+	};
+}
@@ -0,0 +1,375 @@
+#include "EnginePCH.hpp"
+
+#include "WorldSnapshot.hpp"
+
+using namespace Poly;
+
+namespace
+{
+	TransformComponent* GetTransform(World* world, const EntityID& id)
+	{
+		return world->GetComponent<TransformComponent>(id);
+	}
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::Clear()
+{
+	for (Group& group : Groups)
+	{
+		for (Column& column : group.Columns)
+		{
+			if (!column.Copies)
+				continue;
+			for (size_t i = 0; i < group.EntityCount; ++i)
+				column.Type.Destroy(column.Copies + i * column.Type.Size);
+			DefaultFree(column.Copies);
+		}
+	}
+	Groups.Clear();
+	Entities.Clear();
+	HierarchyLinks.Clear();
+	SlotTable.Clear();
+	FreeSlots.Clear();
+	SlotCount = 0;
+	Source = nullptr;
+	StructureVersion = 0;
+	ChangeVersion = 0;
+}
+
+//------------------------------------------------------------------------------
+bool WorldSnapshot::HasStructureOf(const World* world) const
+{
+	// reserving IDs changes the slot table without changing the structure version
+	return Source == world && StructureVersion == world->StructureVersion
+		&& SlotCount == std::min(world->EntitySlotCount.load(), world->MaxEntityCount)
+		&& FreeSlots.GetSize() == world->FreeEntitySlotCount.load();
+}
+
+//------------------------------------------------------------------------------
+template<typename Function>
+void WorldSnapshot::ForEachChangedComponent(World* world, const Function& function) const
+{
+	for (size_t groupIdx = 0; groupIdx < Groups.GetSize(); ++groupIdx)
+	{
+		const Group& group = Groups[groupIdx];
+		const Archetype* archetype = group.SourceArchetype;
+		// plain components are not change tracked, they are always treated as changed
+		bool hasPlainColumns = false;
+		for (const Column& column : group.Columns)
+			hasPlainColumns |= column.Type.Kind == eComponentKind::PLAIN;
+
+		// archetype rows are visited chunk by chunk, so chunks without changes are skipped at once
+		const size_t step = archetype ? archetype->GetChunkCapacity() : group.EntityCount;
+		for (size_t begin = 0; begin < group.EntityCount; begin += step)
+		{
+			if (archetype && !hasPlainColumns && archetype->GetChunkChangeVersion(begin) <= ChangeVersion)
+				continue;
+			const size_t end = std::min(begin + step, group.EntityCount);
+			for (size_t entityIdx = begin; entityIdx < end; ++entityIdx)
+			{
+				const Entity* ent = archetype ? nullptr : world->GetEntity(Entities[group.FirstEntity + entityIdx]);
+				for (size_t columnIdx = 0; columnIdx < group.Columns.GetSize(); ++columnIdx)
+				{
+					const ComponentTypeInfo& type = group.Columns[columnIdx].Type;
+					if (type.Kind == eComponentKind::TAG)
+						continue;
+					ComponentBase* component = archetype ? static_cast<ComponentBase*>(archetype->GetComponent(type.ID, entityIdx)) : ent->GetComponentById(type.ID);
+					if (type.Kind == eComponentKind::PLAIN || component->GetChangeVersion() > ChangeVersion)
+						function(groupIdx, columnIdx, entityIdx, component);
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+WorldSnapshot::Group& WorldSnapshot::AddGroup(const Dynarray<ComponentTypeInfo>& types, size_t entityCount)
+{
+	const size_t transformID = gEngine->GetComponentID<TransformComponent>();
+	Group group;
+	group.FirstEntity = Entities.GetSize();
+	group.EntityCount = entityCount;
+	for (const ComponentTypeInfo& type : types)
+	{
+		Column column;
+		column.Type = type;
+		column.IsTransform = type.ID == transformID;
+		if (column.IsTransform)
+			group.Transforms.Resize(entityCount);
+		else
+		{
+			ASSERTE(type.CopyConstructRange && type.CopyAssignRange, "Component type can not be copied into a snapshot!");
+			// tags have no state to copy
+			if (type.Size > 0)
+				column.Copies = static_cast<uint8_t*>(DefaultAlloc(type.Size * entityCount));
+		}
+		group.Columns.PushBack(column);
+	}
+	Groups.PushBack(std::move(group));
+	return Groups[Groups.GetSize() - 1];
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::Capture(World* world)
+{
+	if (HasStructureOf(world))
+	{
+		CaptureChanges(world);
+		return;
+	}
+
+	Clear();
+	Source = world;
+	StructureVersion = world->StructureVersion;
+	ChangeVersion = world->AdvanceChangeVersion();
+
+	// slot table is plain data, entity pointers in it are cleared when restoring
+	SlotCount = std::min(world->EntitySlotCount.load(), world->MaxEntityCount);
+	SlotTable.Resize(SlotCount * sizeof(World::EntitySlot));
+	if (SlotCount > 0)
+		memcpy(SlotTable.GetData(), world->EntitySlots, SlotTable.GetSize());
+	FreeSlots.Resize(world->FreeEntitySlotCount.load());
+	if (!FreeSlots.IsEmpty())
+		memcpy(FreeSlots.GetData(), world->FreeEntitySlots, sizeof(size_t) * FreeSlots.GetSize());
+
+	// every archetype becomes a group, its columns are copied in ranges of whole chunks
+	if (world->Storage == eComponentStorage::ARCHETYPE)
+	{
+		for (Archetype* archetype : world->Archetypes)
+		{
+			const size_t count = archetype->GetSize();
+			if (count == 0)
+				continue;
+			Group& group = AddGroup(archetype->GetComponentTypes(), count);
+			group.SourceArchetype = archetype;
+			for (size_t row = 0; row < count; ++row)
+				Entities.PushBack(archetype->GetEntity(row)->GetID());
+
+			const size_t chunkCapacity = archetype->GetChunkCapacity();
+			for (Column& column : group.Columns)
+			{
+				for (size_t begin = 0; begin < count; begin += chunkCapacity)
+				{
+					const size_t end = std::min(begin + chunkCapacity, count);
+					if (column.IsTransform)
+					{
+						for (size_t row = begin; row < end; ++row)
+							CaptureTransform(group.Transforms[row], static_cast<const TransformComponent*>(archetype->GetComponent(column.Type.ID, row)));
+					}
+					else
+						column.Type.CopyConstructRange(column.Copies + begin * column.Type.Size, archetype->GetComponent(column.Type.ID, begin), end - begin);
+				}
+			}
+		}
+	}
+
+	// pooled entities, and entities without components in archetype storage, are grouped by component set in slot order
+	std::unordered_map<ComponentSignature, size_t> bucketBySignature;
+	Dynarray<Dynarray<Entity*>> buckets;
+	for (size_t i = 0; i < SlotCount; ++i)
+	{
+		Entity* ent = world->EntitySlots[i].Ent;
+		if (!ent || ent->EntityArchetype)
+			continue;
+		auto it = bucketBySignature.find(ent->ComponentPosessionFlags);
+		if (it == bucketBySignature.end())
+		{
+			it = bucketBySignature.emplace(ent->ComponentPosessionFlags, buckets.GetSize()).first;
+			buckets.PushBack(Dynarray<Entity*>());
+		}
+		buckets[it->second].PushBack(ent);
+	}
+
+	for (const Dynarray<Entity*>& bucket : buckets)
+	{
+		const ComponentSignature& signature = bucket[0]->ComponentPosessionFlags;
+		Dynarray<ComponentTypeInfo> types;
+		for (size_t id = NextComponentID(signature, 0); id < MAX_COMPONENTS_COUNT; id = NextComponentID(signature, id + 1))
+			types.PushBack(world->PoolComponentTypes[id]);
+
+		Group& group = AddGroup(types, bucket.GetSize());
+		for (size_t i = 0; i < bucket.GetSize(); ++i)
+		{
+			Entities.PushBack(bucket[i]->GetID());
+			for (Column& column : group.Columns)
+			{
+				const ComponentBase* component = bucket[i]->GetComponentById(column.Type.ID);
+				if (column.IsTransform)
+					CaptureTransform(group.Transforms[i], static_cast<const TransformComponent*>(component));
+				else
+					column.Type.CopyConstructRange(column.Copies + i * column.Type.Size, component, 1);
+			}
+		}
+	}
+
+	CaptureHierarchy(world);
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::CaptureChanges(World* world)
+{
+	bool hierarchyChanged = false;
+	ForEachChangedComponent(world, [this, &hierarchyChanged](size_t groupIdx, size_t columnIdx, size_t entityIdx, const ComponentBase* component)
+	{
+		Group& group = Groups[groupIdx];
+		const Column& column = group.Columns[columnIdx];
+		if (column.IsTransform)
+		{
+			TransformState& state = group.Transforms[entityIdx];
+			const EntityID prevParent = state.Parent;
+			CaptureTransform(state, static_cast<const TransformComponent*>(component));
+			hierarchyChanged |= !(state.Parent == prevParent);
+		}
+		else
+			column.Type.CopyAssignRange(column.Copies + entityIdx * column.Type.Size, component, 1);
+	});
+
+	if (hierarchyChanged)
+		CaptureHierarchy(world);
+	ChangeVersion = world->AdvanceChangeVersion();
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::CaptureHierarchy(World* world)
+{
+	HierarchyLinks.Clear();
+	for (const Group& group : Groups)
+	{
+		if (group.Transforms.IsEmpty())
+			continue;
+		for (size_t i = 0; i < group.EntityCount; ++i)
+		{
+			const EntityID& parentID = Entities[group.FirstEntity + i];
+			for (const TransformComponent* child : GetTransform(world, parentID)->GetChildren())
+			{
+				HierarchyLinks.PushBack(child->GetOwnerID());
+				HierarchyLinks.PushBack(parentID);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::RestoreTo(World* world) const
+{
+	ASSERTE(Source == world, "Snapshot can be restored only into the world it was taken from!");
+	if (HasStructureOf(world))
+	{
+		RestoreChanges(world);
+		return;
+	}
+
+	// destroying an entity destroys its children too, so check the slot every time
+	const size_t slotCount = std::min(world->EntitySlotCount.load(), world->MaxEntityCount);
+	for (size_t i = 0; i < slotCount; ++i)
+	{
+		if (world->EntitySlots[i].Ent)
+			world->DestroyEntity(world->EntitySlots[i].Ent->GetID());
+	}
+
+	// with slot table restored entities get their old IDs back and handles invalid at the time of the snapshot stay invalid
+	if (SlotCount > 0)
+	{
+		world->EntitySlotMemory.Commit(SlotTable.GetSize());
+		memcpy(world->EntitySlots, SlotTable.GetData(), SlotTable.GetSize());
+		for (size_t i = 0; i < SlotCount; ++i)
+			world->EntitySlots[i].Ent = nullptr;
+	}
+	world->EntitySlotCount.store(SlotCount);
+	if (!FreeSlots.IsEmpty())
+	{
+		world->FreeEntitySlotMemory.Commit(sizeof(size_t) * FreeSlots.GetSize());
+		memcpy(world->FreeEntitySlots, FreeSlots.GetData(), sizeof(size_t) * FreeSlots.GetSize());
+	}
+	world->FreeEntitySlotCount.store(FreeSlots.GetSize());
+
+	for (const Group& group : Groups)
+	{
+		Dynarray<ComponentTypeInfo> types;
+		for (const Column& column : group.Columns)
+			types.PushBack(column.Type);
+		world->SpawnReservedEntities(Entities.GetData() + group.FirstEntity, group.EntityCount, types, [&group](size_t entityIdx, size_t columnIdx, void* memory)
+		{
+			const Column& column = group.Columns[columnIdx];
+			if (column.IsTransform)
+				RestoreTransform(::new(memory) TransformComponent(), group.Transforms[entityIdx]);
+			else
+				column.Type.CopyConstructRange(memory, column.Copies + entityIdx * column.Type.Size, 1);
+		});
+	}
+
+	for (size_t i = 0; i < HierarchyLinks.GetSize(); i += 2)
+		GetTransform(world, HierarchyLinks[i])->AttachToParent(GetTransform(world, HierarchyLinks[i + 1]));
+
+	// world has exactly the captured structure again, so the next restore or capture can copy only changed components
+	world->StructureVersion = StructureVersion;
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::RestoreChanges(World* world) const
+{
+	bool hierarchyChanged = false;
+	ForEachChangedComponent(world, [this, world, &hierarchyChanged](size_t groupIdx, size_t columnIdx, size_t entityIdx, ComponentBase* component)
+	{
+		const Group& group = Groups[groupIdx];
+		const Column& column = group.Columns[columnIdx];
+		if (column.IsTransform)
+		{
+			TransformComponent* transform = static_cast<TransformComponent*>(component);
+			const TransformState& state = group.Transforms[entityIdx];
+			RestoreTransform(transform, state);
+			const EntityID parentID = transform->Parent ? transform->Parent->GetOwnerID() : EntityID();
+			if (!(parentID == state.Parent))
+			{
+				if (transform->Parent)
+					transform->DetachFromParent();
+				if (state.Parent)
+					transform->AttachToParent(GetTransform(world, state.Parent));
+				hierarchyChanged = true;
+			}
+			transform->MarkChanged();
+		}
+		else if (column.Type.Kind == eComponentKind::PLAIN)
+			column.Type.CopyAssignRange(component, column.Copies + entityIdx * column.Type.Size, 1);
+		else
+		{
+			// copies keep owners from the time of capture, entity objects may have been recreated since
+			Entity* owner = component->Owner;
+			column.Type.CopyAssignRange(component, column.Copies + entityIdx * column.Type.Size, 1);
+			component->Owner = owner;
+			component->MarkChanged();
+		}
+	});
+
+	if (!hierarchyChanged)
+		return;
+
+	// parents have the captured children now, put them back in the captured order
+	for (size_t i = 0; i < HierarchyLinks.GetSize(); i += 2)
+	{
+		TransformComponent* parent = GetTransform(world, HierarchyLinks[i + 1]);
+		TransformComponent* child = GetTransform(world, HierarchyLinks[i]);
+		parent->UnlinkChild(child);
+		parent->LinkChild(child);
+	}
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::CaptureTransform(TransformState& state, const TransformComponent* transform)
+{
+	state.Translation = transform->LocalTranslation;
+	state.Rotation = transform->LocalRotation;
+	state.Scale = transform->LocalScale;
+	state.Parent = transform->Parent ? transform->Parent->GetOwnerID() : EntityID();
+}
+
+//------------------------------------------------------------------------------
+void WorldSnapshot::RestoreTransform(TransformComponent* transform, const TransformState& state)
+{
+	transform->LocalTranslation = state.Translation;
+	transform->LocalRotation = state.Rotation;
+	transform->LocalScale = state.Scale;
+	transform->LocalDirty = true;
+	transform->SetGlobalDirty();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Core.hpp>
+
+#include "Archetype.hpp"
+#include "EntityID.hpp"
+
+namespace Poly
+{
+	class World;
+	class ComponentBase;
+	class TransformComponent;
+
+	/// <summary>Copy of all entities and components of a world, taken with <see cref="World.Snapshot()"/> and brought back
+	/// with <see cref="World.Restore()"/>. Used for rollback, speculative simulation and deterministic replays.</summary>
+	/// <para>Components are copied type by type in whole ranges - archetype chunk columns or runs of entities with equal component sets,
+	/// entity slot table is copied as raw memory. Pointers are never restored from the copy: component owners stay as they are
+	/// and TransformComponent hierarchy is stored as entity IDs. Snapshot should be reused, taking it again or restoring it
+	/// without structural changes in between copies only components changed since.</para>
+	class ENGINE_DLLEXPORT WorldSnapshot : public BaseObject<>
+	{
+	public:
+		WorldSnapshot() = default;
+		~WorldSnapshot() { Clear(); }
+
+		WorldSnapshot(const WorldSnapshot&) = delete;
+		WorldSnapshot& operator=(const WorldSnapshot&) = delete;
+
+		/// <summary>Returns true if no state was captured.</summary>
+		bool IsEmpty() const { return Source == nullptr; }
+
+		/// <summary>Returns count of captured entities.</summary>
+		size_t GetEntityCount() const { return Entities.GetSize(); }
+
+		/// <summary>Releases captured state.</summary>
+		void Clear();
+
+	private:
+		// Copies of one component type for all entities of a group
+		struct Column
+		{
+			ComponentTypeInfo Type;
+			bool IsTransform = false;
+			uint8_t* Copies = nullptr;
+		};
+
+		// TransformComponent can not be copied as it links to other transforms, its local transformation and parent are kept instead
+		struct TransformState
+		{
+			Vector Translation;
+			Quaternion Rotation;
+			Vector Scale;
+			EntityID Parent;
+		};
+
+		// Entities with equal component sets. With archetype storage a group is a whole archetype and entities are in row order.
+		struct Group
+		{
+			Archetype* SourceArchetype = nullptr;
+			size_t FirstEntity = 0;
+			size_t EntityCount = 0;
+			Dynarray<Column> Columns;
+			Dynarray<TransformState> Transforms;
+		};
+
+		void Capture(World* world);
+		void CaptureChanges(World* world);
+		void RestoreTo(World* world) const;
+		void RestoreChanges(World* world) const;
+		void CaptureHierarchy(World* world);
+		// True if the world has exactly the entities and components that were captured, so only changed components have to be copied
+		bool HasStructureOf(const World* world) const;
+		// Appends group of entityCount entities, whose IDs have to be appended to Entities next
+		Group& AddGroup(const Dynarray<ComponentTypeInfo>& types, size_t entityCount);
+
+		static void CaptureTransform(TransformState& state, const TransformComponent* transform);
+		static void RestoreTransform(TransformComponent* transform, const TransformState& state);
+
+		// Calls function(group index, column index, entity index in group, live component) for components changed after ChangeVersion
+		template<typename Function>
+		void ForEachChangedComponent(World* world, const Function& function) const;
+
+		World* Source = nullptr;
+		uint64_t StructureVersion = 0;
+		uint32_t ChangeVersion = 0;
+
+		Dynarray<uint8_t> SlotTable;
+		size_t SlotCount = 0;
+		Dynarray<size_t> FreeSlots;
+
+		Dynarray<EntityID> Entities;
+		Dynarray<Group> Groups;
+		// Pairs of child and parent, children of every parent in their order
+		Dynarray<EntityID> HierarchyLinks;
+
+		friend class World;
+	};
+}
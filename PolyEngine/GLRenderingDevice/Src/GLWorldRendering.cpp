@@ -17,6 +17,13 @@
 
 using namespace Poly;
 
+//------------------------------------------------------------------------------
+// Meshes are batched by resource, which also groups their textures
+static uint64_t GetMeshSortKey(const MeshRenderingComponent* meshCmp)
+{
+	return reinterpret_cast<uintptr_t>(meshCmp->GetMesh());
+}
+
 //------------------------------------------------------------------------------
 void GLRenderingDevice::RenderWorld(World * world)
 {
@@ -48,51 +55,59 @@ void GLRenderingDevice::RenderWorld(World * world)
 		// Get camera MVP matrix
 		const Matrix& mvp = kv.second.GetCamera()->GetMVP();
 
-		// Render meshes
-		for (auto componentsTuple : world->IterateComponents<MeshRenderingComponent, TransformComponent>())
+		// Render meshes, sorted so instances of a mesh are drawn one after another
+		const MeshResource* boundMesh = nullptr;
+		for (auto componentsTuple : world->SortedQuery<With<MeshRenderingComponent, TransformComponent>>(&GetMeshSortKey))
 		{
 			const MeshRenderingComponent* meshCmp = std::get<MeshRenderingComponent*>(componentsTuple);
 			const TransformComponent* transCmp = std::get<TransformComponent*>(componentsTuple);
 
-			const Matrix& objTransform = transCmp->GetGlobalTransformationMatrix();
+			const AffineMatrix& objTransform = transCmp->GetGlobalTransformation();
 			Matrix screenTransform = mvp * objTransform;
 			GetProgram(eShaderProgramType::TEST).SetUniform("uTransform", screenTransform);
-			for (const MeshResource::SubMesh* subMesh : meshCmp->GetMesh()->GetSubMeshes())
-			{
-				const GLMeshDeviceProxy* meshProxy = static_cast<const GLMeshDeviceProxy*>(subMesh->GetMeshProxy());
 
-				glBindVertexArray(meshProxy->VAO);
-
-				if (subMesh->GetMeshData().GetDiffTexture())
+			// single part meshes keep their buffers and texture bound for following instances
+			const MeshResource* mesh = meshCmp->GetMesh();
+			const bool bound = mesh == boundMesh && mesh->GetSubMeshes().GetSize() == 1;
+			for (const MeshResource::SubMesh* subMesh : mesh->GetSubMeshes())
+			{
+				if (!bound)
 				{
+					const GLMeshDeviceProxy* meshProxy = static_cast<const GLMeshDeviceProxy*>(subMesh->GetMeshProxy());
+					glBindVertexArray(meshProxy->VAO);
+
 					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, static_cast<const GLTextureDeviceProxy*>(subMesh->GetMeshData().GetDiffTexture()->GetTextureProxy())->TextureID);
+					if (subMesh->GetMeshData().GetDiffTexture())
+						glBindTexture(GL_TEXTURE_2D, static_cast<const GLTextureDeviceProxy*>(subMesh->GetMeshData().GetDiffTexture()->GetTextureProxy())->TextureID);
+					else
+						glBindTexture(GL_TEXTURE_2D, 0);
 				}
 
 				glDrawElements(GL_TRIANGLES, (GLsizei)subMesh->GetMeshData().GetTriangleCount() * 3, GL_UNSIGNED_INT, NULL);
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glBindVertexArray(0);
 			}
+			boundMesh = mesh;
 		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindVertexArray(0);
 		CHECK_GL_ERR();
 
 		// Draw debug normals
 		if (gCoreConfig.DebugNormalsFlag)
 		{
-			const Matrix& mModelView = kv.second.GetCamera()->GetModelViewMatrix();
+			const AffineMatrix& mModelView = kv.second.GetCamera()->GetModelViewMatrix();
 			const Matrix& mProjection = kv.second.GetCamera()->GetProjectionMatrix();
 
 			GetProgram(eShaderProgramType::DEBUG_NORMALS).BindProgram();
 			GetProgram(eShaderProgramType::DEBUG_NORMALS).SetUniform("u_projection", mProjection);
 
-			for (auto componentsTuple : world->IterateComponents<MeshRenderingComponent, TransformComponent>())
+			for (auto componentsTuple : world->CachedQuery<With<MeshRenderingComponent, TransformComponent>>())
 			{
 				const MeshRenderingComponent* meshCmp = std::get<MeshRenderingComponent*>(componentsTuple);
 				const TransformComponent* transCmp = std::get<TransformComponent*>(componentsTuple);
 
-				const Matrix& objTransform = transCmp->GetGlobalTransformationMatrix();
+				const AffineMatrix& objTransform = transCmp->GetGlobalTransformation();
 				Matrix MVPTransform = mvp * objTransform;
-				Matrix mNormalMatrix = (mModelView * objTransform).GetInversed().GetTransposed();
+				Matrix mNormalMatrix = (mModelView * objTransform).GetInversed().ToMatrix().GetTransposed();
 				GetProgram(eShaderProgramType::DEBUG_NORMALS).SetUniform("u_MVP", MVPTransform);
 				GetProgram(eShaderProgramType::DEBUG_NORMALS).SetUniform("u_normalMatrix4x4", mNormalMatrix);
 				for (const MeshResource::SubMesh* subMesh : meshCmp->GetMesh()->GetSubMeshes())
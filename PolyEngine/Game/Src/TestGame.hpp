@@ -18,8 +18,8 @@ class GAME_DLLEXPORT TestGame : public Poly::IGame {
 	void Deinit() override;
 
 private:
-	Poly::UniqueID Camera;
+	Poly::EntityID Camera;
 
-	Poly::Dynarray<Poly::UniqueID> GameEntities;
+	Poly::Dynarray<Poly::EntityID> GameEntities;
 	Poly::Engine* Engine;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <catch.hpp>
+
+#include <AffineMatrix.hpp>
+#include <Quaternion.hpp>
+
+using namespace Poly;
+
+namespace
+{
+	Matrix CreateTRS(const Vector& translation, const Quaternion& rotation, const Vector& scale)
+	{
+		Matrix t, s;
+		t.SetTranslation(translation);
+		s.SetScale(scale);
+		return t * (Matrix)rotation * s;
+	}
+}
+
+TEST_CASE("AffineMatrix constructors", "[AffineMatrix]") {
+	// empty constructor
+	AffineMatrix m1;
+	for (int i = 0; i < 12; ++i)
+		REQUIRE(m1.Data[i] == (i % 5 == 0 ? 1 : 0));
+	REQUIRE(m1.ToMatrix() == Matrix());
+
+	// basic constructor
+	float data[] = { 0,1,2,3,
+		4,5,6,7,
+		8,9,10,11 };
+	AffineMatrix m2(data);
+	for (int i = 0; i < 12; ++i)
+		REQUIRE(m2.Data[i] == i);
+	REQUIRE(m2.GetTranslation() == Vector(3, 7, 11));
+
+	// conversions
+	Matrix m3 = m2.ToMatrix();
+	for (int i = 0; i < 12; ++i)
+		REQUIRE(m3.Data[i] == i);
+	REQUIRE(m3.m30 == 0);
+	REQUIRE(m3.m31 == 0);
+	REQUIRE(m3.m32 == 0);
+	REQUIRE(m3.m33 == 1);
+	REQUIRE(AffineMatrix(m3) == m2);
+
+	// translation, rotation and scale
+	const Vector trans(1, 2, 3);
+	const Quaternion rot(Vector(1, 1, 1).GetNormalized(), 45_deg);
+	const Vector scale(2, 3, 4);
+	AffineMatrix m4(trans, rot, scale);
+	REQUIRE(m4.ToMatrix() == CreateTRS(trans, rot, scale));
+
+	Vector t, s;
+	Quaternion r;
+	REQUIRE(m4.Decompose(t, r, s));
+	REQUIRE(t == trans);
+	REQUIRE(r == rot);
+	REQUIRE(s == scale);
+}
+
+TEST_CASE("AffineMatrix multiplication operators", "[AffineMatrix]") {
+	const Matrix a = CreateTRS(Vector(1, -2, 3), Quaternion(Vector(0, 1, 0), 30_deg), Vector(2, 1, 0.5f));
+	const Matrix b = CreateTRS(Vector(-4, 0.5f, 2), Quaternion(Vector(1, 1, 0).GetNormalized(), 70_deg), Vector(1, 3, 1));
+
+	// composition matches 4x4 multiplication
+	AffineMatrix ab = AffineMatrix(a) * AffineMatrix(b);
+	REQUIRE(ab.ToMatrix() == a * b);
+	AffineMatrix ab2(a);
+	ab2 *= AffineMatrix(b);
+	REQUIRE(ab2 == ab);
+	REQUIRE(AffineMatrix(b) * AffineMatrix(a) != ab);
+
+	// projection applied to affine transformation
+	Matrix projection;
+	projection.SetPerspective(60_deg, 1.5f, 0.1f, 100.f);
+	REQUIRE(projection * AffineMatrix(a) == projection * a);
+
+	// points and directions
+	const Vector v(3, -1, 2);
+	REQUIRE(AffineMatrix(a).TransformPoint(v) == a * v);
+	REQUIRE(AffineMatrix(a).TransformPoint(Vector(3, -1, 2, 0)) == a * v);
+	const Vector d = AffineMatrix(a).TransformVector(v);
+	const Vector expected = a * Vector(3, -1, 2, 0);
+	REQUIRE(d == Vector(expected.X, expected.Y, expected.Z, 0));
+	REQUIRE(d.W == 0);
+}
+
+TEST_CASE("AffineMatrix inverse", "[AffineMatrix]") {
+	SECTION("Affine inverse") {
+		const Matrix m = CreateTRS(Vector(1, -2, 3), Quaternion(Vector(1, 1, 1).GetNormalized(), 45_deg), Vector(2, 3, 4));
+		AffineMatrix a(m);
+		REQUIRE(a.GetInversed().ToMatrix() == m.GetInversed());
+		REQUIRE(a * a.GetInversed() == AffineMatrix());
+		REQUIRE(a.GetInversed() * a == AffineMatrix());
+
+		const Vector p(5, 6, 7);
+		REQUIRE(a.GetInversed().TransformPoint(a.TransformPoint(p)) == p);
+
+		AffineMatrix b = a;
+		b.Inverse();
+		REQUIRE(b == a.GetInversed());
+	}
+
+	SECTION("Rigid inverse") {
+		const AffineMatrix a(Vector(1, -2, 3), Quaternion(Vector(0, 0, 1), 60_deg), Vector(1, 1, 1));
+		REQUIRE(a.GetRigidInversed() == a.GetInversed());
+		REQUIRE(a * a.GetRigidInversed() == AffineMatrix());
+	}
+}
@@ -2,6 +2,8 @@
 
 #include <PoolAllocator.hpp>
 #include <IterablePoolAllocator.hpp>
+#include <LinearAllocator.hpp>
+#include <Dynarray.hpp>
 
 using namespace Poly;
 
@@ -98,4 +100,158 @@ TEST_CASE("Iterable pool allocator corner case test", "[Allocator]") {
 	size_t* e = allocator.Alloc();
 	REQUIRE(e != nullptr);
 	REQUIRE(allocator.GetSize() == 3);
-}
\ No newline at end of file
+}
+TEST_CASE("Iterable pool allocator iteration", "[Allocator]") {
+	const size_t count = 200;
+	IterablePoolAllocator<size_t> allocator(count);
+	size_t* ptrs[count];
+	for (size_t i = 0; i < count; ++i)
+	{
+		ptrs[i] = allocator.Alloc();
+		*ptrs[i] = i;
+	}
+	REQUIRE(allocator.Alloc() == nullptr);
+
+	// free every cell that is not a multiple of 3, so iteration has to cross empty bitmap words
+	for (size_t i = 0; i < count; ++i)
+		if (i % 3 != 0 || (i > 64 && i < 192))
+			allocator.Free(ptrs[i]);
+	REQUIRE(allocator.GetSize() == 25);
+
+	Dynarray<size_t> values;
+	for (size_t val : allocator)
+		values.PushBack(val);
+	REQUIRE(values.GetSize() == allocator.GetSize());
+	for (size_t i = 1; i < values.GetSize(); ++i)
+		REQUIRE(values[i - 1] < values[i]);
+	REQUIRE(values[0] == 0);
+	REQUIRE(values[values.GetSize() - 1] == 198);
+
+	// backward iteration
+	size_t idx = values.GetSize();
+	auto it = allocator.End();
+	while (it != allocator.Begin())
+	{
+		--it;
+		REQUIRE(*it == values[--idx]);
+	}
+	REQUIRE(idx == 0);
+
+	// freeing element under the iterator does not break iteration
+	size_t visited = 0;
+	for (auto iter = allocator.Begin(); iter != allocator.End(); ++iter, ++visited)
+		allocator.Free(&*iter);
+	REQUIRE(visited == 25);
+	REQUIRE(allocator.GetSize() == 0);
+	REQUIRE(allocator.Begin() == allocator.End());
+}
+
+TEST_CASE("Pool allocators of small types", "[Allocator]")
+{
+	PoolAllocator<uint8_t> pool(4);
+	uint8_t* a = pool.Alloc();
+	uint8_t* b = pool.Alloc();
+	REQUIRE(a != nullptr);
+	REQUIRE(b != nullptr);
+	REQUIRE(a != b);
+	pool.Free(a);
+	REQUIRE(pool.Alloc() == a);
+	REQUIRE(pool.GetSize() == 2);
+
+	// small cells are packed without padding, free ones are reused lowest first
+	const size_t count = 150;
+	IterablePoolAllocator<uint16_t> allocator(count);
+	uint16_t* ptrs[count];
+	for (size_t i = 0; i < count; ++i)
+	{
+		ptrs[i] = allocator.Alloc();
+		REQUIRE(ptrs[i] == ptrs[0] + i);
+		*ptrs[i] = static_cast<uint16_t>(i);
+	}
+	REQUIRE(allocator.Alloc() == nullptr);
+
+	for (size_t i = 0; i < count; i += 2)
+		allocator.Free(ptrs[i]);
+	REQUIRE(allocator.GetSize() == count / 2);
+	size_t expected = 1;
+	for (uint16_t val : allocator)
+	{
+		REQUIRE(val == expected);
+		expected += 2;
+	}
+
+	allocator.Free(ptrs[101]);
+	for (size_t i = 0; i < count; ++i)
+		if (i % 2 == 0 || i == 101)
+			REQUIRE(allocator.Alloc() == ptrs[i]);
+	REQUIRE(allocator.Alloc() == nullptr);
+	REQUIRE(allocator.GetSize() == count);
+}
+
+TEST_CASE("Virtual memory range", "[Allocator]")
+{
+	for (bool hugePages : { false, true })
+	{
+		// reserving a lot of address space commits nothing
+		const size_t reserved = size_t(1) << 30;
+		VirtualMemoryRange range(reserved, hugePages);
+		REQUIRE(range.GetReservedSize() >= reserved);
+		REQUIRE(range.GetCommittedSize() == 0);
+
+		range.Commit(100);
+		REQUIRE(range.GetCommittedSize() >= 100);
+		REQUIRE(range.GetCommittedSize() % range.GetCommitGranularity() == 0);
+		REQUIRE(range.GetCommittedSize() < reserved);
+
+		// committed memory is zeroed and stays in place when more is committed
+		uint8_t* data = range.GetData();
+		REQUIRE(data[0] == 0);
+		REQUIRE(data[99] == 0);
+		data[0] = 42;
+		const size_t committed = range.GetCommittedSize();
+		range.Commit(committed + 1);
+		REQUIRE(range.GetCommittedSize() > committed);
+		REQUIRE(range.GetData() == data);
+		REQUIRE(data[0] == 42);
+		REQUIRE(data[committed] == 0);
+	}
+
+	// pools commit memory only for used cells
+	IterablePoolAllocator<size_t> allocator(size_t(1) << 24);
+	for (size_t i = 0; i < 10; ++i)
+		*allocator.Alloc() = i;
+	REQUIRE(allocator.GetSize() == 10);
+	REQUIRE(allocator.GetInitializedCount() == 10);
+}
+
+TEST_CASE("Linear allocator", "[Allocator]")
+{
+	LinearAllocator allocator(256);
+	REQUIRE(allocator.GetReservedSize() == 0);
+
+	// allocations are aligned and do not overlap
+	uint8_t* previous = nullptr;
+	for (size_t i = 0; i < 100; ++i)
+	{
+		uint8_t* p = static_cast<uint8_t*>(allocator.Alloc(i % 7 + 1, size_t(1) << (i % 5)));
+		REQUIRE(reinterpret_cast<size_t>(p) % (size_t(1) << (i % 5)) == 0);
+		if (previous)
+			REQUIRE(p != previous);
+		memset(p, 0xAB, i % 7 + 1);
+		previous = p;
+	}
+	void* big = allocator.Alloc(1000, 16);
+	REQUIRE(big != nullptr);
+	const size_t reserved = allocator.GetReservedSize();
+	REQUIRE(reserved >= 1000 + 256);
+
+	// reset reuses the same blocks
+	for (int frame = 0; frame < 5; ++frame)
+	{
+		allocator.Reset();
+		for (size_t i = 0; i < 100; ++i)
+			allocator.Alloc(i % 7 + 1, size_t(1) << (i % 5));
+		allocator.Alloc(1000, 16);
+		REQUIRE(allocator.GetReservedSize() == reserved);
+	}
+}
@@ -0,0 +1,133 @@
+#include <catch.hpp>
+
+#include <Archetype.hpp>
+
+using namespace Poly;
+
+namespace
+{
+	struct TestComponentA
+	{
+		TestComponentA(int value) : Value(value) { ++AliveCount; }
+		TestComponentA(TestComponentA&& rhs) : Value(rhs.Value) { ++AliveCount; }
+		~TestComponentA() { --AliveCount; }
+
+		int Value;
+		static int AliveCount;
+	};
+	int TestComponentA::AliveCount = 0;
+
+	struct alignas(16) TestComponentB
+	{
+		TestComponentB(float value) : Value(value) {}
+		float Value;
+	};
+
+	Entity* FakeEntity(size_t i) { return reinterpret_cast<Entity*>((i + 1) * sizeof(void*)); }
+}
+
+TEST_CASE("Archetype rows", "[Archetype]")
+{
+	ComponentSignature signature;
+	signature.set(1);
+	signature.set(5);
+	Dynarray<ComponentTypeInfo> types;
+	types.PushBack(ComponentTypeInfo::Create<TestComponentA>(1));
+	types.PushBack(ComponentTypeInfo::Create<TestComponentB>(5));
+
+	{
+		Archetype archetype(signature, types);
+		REQUIRE(archetype.GetSize() == 0);
+		REQUIRE(archetype.HasComponent(1));
+		REQUIRE(archetype.HasComponent(5));
+		REQUIRE(!archetype.HasComponent(2));
+		REQUIRE(archetype.GetChunkCapacity() > 0);
+
+		// fill more than a single chunk
+		const size_t count = archetype.GetChunkCapacity() * 2 + 3;
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t row = archetype.AddRow(FakeEntity(i));
+			REQUIRE(row == i);
+			::new(archetype.GetComponent(1, row)) TestComponentA(static_cast<int>(i));
+			::new(archetype.GetComponent(5, row)) TestComponentB(static_cast<float>(i));
+		}
+		REQUIRE(archetype.GetSize() == count);
+		REQUIRE(TestComponentA::AliveCount == static_cast<int>(count));
+		REQUIRE(archetype.GetComponent(2, 0) == nullptr);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			REQUIRE(archetype.GetEntity(i) == FakeEntity(i));
+			REQUIRE(static_cast<TestComponentA*>(archetype.GetComponent(1, i))->Value == static_cast<int>(i));
+			REQUIRE(reinterpret_cast<size_t>(archetype.GetComponent(5, i)) % alignof(TestComponentB) == 0);
+		}
+
+		SECTION("Remove last row")
+		{
+			REQUIRE(archetype.RemoveRow(count - 1, true) == nullptr);
+			REQUIRE(archetype.GetSize() == count - 1);
+			REQUIRE(TestComponentA::AliveCount == static_cast<int>(count - 1));
+		}
+
+		SECTION("Remove row from the middle")
+		{
+			REQUIRE(archetype.RemoveRow(1, true) == FakeEntity(count - 1));
+			REQUIRE(archetype.GetSize() == count - 1);
+			REQUIRE(archetype.GetEntity(1) == FakeEntity(count - 1));
+			REQUIRE(static_cast<TestComponentA*>(archetype.GetComponent(1, 1))->Value == static_cast<int>(count - 1));
+			REQUIRE(static_cast<TestComponentB*>(archetype.GetComponent(5, 1))->Value == static_cast<float>(count - 1));
+			REQUIRE(TestComponentA::AliveCount == static_cast<int>(count - 1));
+		}
+	}
+	REQUIRE(TestComponentA::AliveCount == 0);
+}
+
+TEST_CASE("Archetype cursor", "[Archetype]")
+{
+	ComponentSignature sigA, sigB, sigAB;
+	sigA.set(1);
+	sigB.set(5);
+	sigAB.set(1);
+	sigAB.set(5);
+	Dynarray<ComponentTypeInfo> typesA, typesB, typesAB;
+	typesA.PushBack(ComponentTypeInfo::Create<TestComponentA>(1));
+	typesB.PushBack(ComponentTypeInfo::Create<TestComponentB>(5));
+	typesAB.PushBack(ComponentTypeInfo::Create<TestComponentA>(1));
+	typesAB.PushBack(ComponentTypeInfo::Create<TestComponentB>(5));
+
+	Archetype a(sigA, typesA), b(sigB, typesB), empty(sigAB, typesAB), ab(sigAB, typesAB);
+	for (size_t i = 0; i < 3; ++i)
+		::new(a.GetComponent(1, a.AddRow(FakeEntity(i)))) TestComponentA(static_cast<int>(i));
+	::new(b.GetComponent(5, b.AddRow(FakeEntity(3)))) TestComponentB(3.0f);
+	for (size_t i = 4; i < 6; ++i)
+	{
+		size_t row = ab.AddRow(FakeEntity(i));
+		::new(ab.GetComponent(1, row)) TestComponentA(static_cast<int>(i));
+		::new(ab.GetComponent(5, row)) TestComponentB(static_cast<float>(i));
+	}
+
+	Dynarray<Archetype*> archetypes;
+	archetypes.PushBack(&a);
+	archetypes.PushBack(&b);
+	archetypes.PushBack(&empty);
+	archetypes.PushBack(&ab);
+
+	// iteration over component 1 skips archetype without it and the empty one
+	Dynarray<int> values;
+	ArchetypeCursor end(&archetypes, 1, archetypes.GetSize());
+	for (ArchetypeCursor it(&archetypes, 1, 0); it != end; it.Next())
+		values.PushBack(static_cast<TestComponentA*>(it.GetArchetype()->GetComponent(1, it.GetRow()))->Value);
+	REQUIRE((values == Dynarray<int>{ 0, 1, 2, 4, 5 }));
+
+	// backward iteration
+	values.Clear();
+	ArchetypeCursor begin(&archetypes, 1, 0);
+	ArchetypeCursor it = end;
+	while (it != begin)
+	{
+		it.Prev();
+		values.PushBack(static_cast<TestComponentA*>(it.GetArchetype()->GetComponent(1, it.GetRow()))->Value);
+	}
+	REQUIRE((values == Dynarray<int>{ 5, 4, 2, 1, 0 }));
+}
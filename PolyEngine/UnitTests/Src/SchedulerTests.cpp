@@ -0,0 +1,75 @@
+#include <catch.hpp>
+
+#include <ThreadPool.hpp>
+#include <SystemScheduler.hpp>
+
+using namespace Poly;
+
+TEST_CASE("Thread pool", "[Scheduler]")
+{
+	for (size_t workerCount : { 0, 1, 3 })
+	{
+		ThreadPool pool(workerCount);
+		REQUIRE(pool.GetWorkerCount() == workerCount);
+
+		// every task is executed exactly once
+		const size_t count = 1000;
+		std::atomic<int> executed[count];
+		for (auto& e : executed)
+			e = 0;
+		for (int batch = 0; batch < 3; ++batch)
+			pool.Run(count, [&executed](size_t i) { ++executed[i]; });
+		for (auto& e : executed)
+			REQUIRE(e == 3);
+
+		// batches started from inside of a task run serially
+		std::atomic<size_t> nested(0);
+		pool.Run(4, [&pool, &nested](size_t) { pool.Run(10, [&nested](size_t) { ++nested; }); });
+		REQUIRE(nested == 40);
+	}
+}
+
+TEST_CASE("System scheduler", "[Scheduler]")
+{
+	SystemAccess readA = SystemAccess().ReadComponent(0);
+	SystemAccess writeA = SystemAccess().WriteComponent(0);
+	SystemAccess writeB = SystemAccess().WriteComponent(1).ReadWorldComponent(0);
+	SystemAccess writeWorld = SystemAccess().WriteWorldComponent(0);
+
+	REQUIRE(!readA.ConflictsWith(readA));
+	REQUIRE(readA.ConflictsWith(writeA));
+	REQUIRE(writeA.ConflictsWith(readA));
+	REQUIRE(!writeA.ConflictsWith(writeB));
+	REQUIRE(writeB.ConflictsWith(writeWorld));
+	REQUIRE(!writeA.ConflictsWith(writeWorld));
+	REQUIRE(SystemAccess::Exclusive().ConflictsWith(SystemAccess()));
+	REQUIRE(SystemAccess().ConflictsWith(SystemAccess::Exclusive()));
+
+	ThreadPool pool(3);
+	SystemScheduler scheduler;
+	std::mutex mutex;
+	Dynarray<int> order;
+	auto system = [&mutex, &order](int id) { return [&mutex, &order, id](World*) { std::lock_guard<std::mutex> lock(mutex); order.PushBack(id); }; };
+
+	scheduler.AddSystem(system(0), writeA);					// level 0
+	scheduler.AddSystem(system(1), writeB);					// level 0
+	scheduler.AddSystem(system(2), readA);					// level 1, after 0
+	scheduler.AddSystem(system(3), writeWorld);				// level 1, after 1
+	scheduler.AddSystem(system(4), SystemAccess::Exclusive());	// level 2, alone
+	scheduler.AddSystem(system(5), readA);					// level 3, after exclusive
+	REQUIRE(scheduler.GetSystemCount() == 6);
+	REQUIRE(scheduler.GetLevelCount() == 4);
+
+	for (int frame = 0; frame < 10; ++frame)
+	{
+		order.Clear();
+		scheduler.Execute(nullptr, &pool);
+		REQUIRE(order.GetSize() == 6);
+
+		auto position = [&order](int id) { return std::find(order.Begin(), order.End(), id) - order.Begin(); };
+		REQUIRE(position(0) < position(2));
+		REQUIRE(position(1) < position(3));
+		REQUIRE(position(4) == 4);
+		REQUIRE(position(5) == 5);
+	}
+}
@@ -103,6 +103,24 @@ TEST_CASE("TransformComponent with parent", "[TransformComponent]")
 		REQUIRE(Cmpf(child.GetGlobalRotation().Z, rotation1.Z));
 		REQUIRE(Cmpf(child.GetGlobalRotation().W, rotation1.W));
 	}
+
+	SECTION("Composed rotation and scale")
+	{
+		parent.SetLocalRotation(Quaternion(EulerAngles{ 10_deg, 20_deg, 30_deg }));
+		parent.SetLocalScale(2);
+		child.SetLocalRotation(Quaternion(EulerAngles{ 40_deg, 50_deg, 60_deg }));
+		child.SetLocalScale(Vector(1, 2, 3));
+
+		// with parent rotation and uniform scale known they are composed, matrix is decomposed otherwise
+		const Quaternion parentRotation = parent.GetGlobalRotation();
+		Vector translation, scale;
+		Quaternion rotation;
+		REQUIRE(child.GetGlobalTransformationMatrix().Decompose(translation, rotation, scale));
+		REQUIRE(child.GetGlobalScale() == scale);
+		REQUIRE(child.GetGlobalRotation() * Vector(1, 2, 3) == rotation * Vector(1, 2, 3));
+		REQUIRE(child.GetGlobalTranslation() == translation);
+		REQUIRE(parent.GetGlobalRotation() * Vector(1, 2, 3) == parentRotation * Vector(1, 2, 3));
+	}
 }
 
 TEST_CASE("Multi-layer hierarchy", "[TransformComponent]")
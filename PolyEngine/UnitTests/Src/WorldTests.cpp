@@ -0,0 +1,1157 @@
+#include <catch.hpp>
+#include <map>
+
+#include <Engine.hpp>
+#include <World.hpp>
+#include <DeferredTaskSystem.hpp>
+#include <TransformComponent.hpp>
+#include <TransformSystem.hpp>
+#include <FreeFloatMovementComponent.hpp>
+#include <TimeWorldComponent.hpp>
+#include <ViewportWorldComponent.hpp>
+#include <CameraComponent.hpp>
+#include <WorldSerializer.hpp>
+#include <WorldSnapshot.hpp>
+#include <CoreConfig.hpp>
+
+using namespace Poly;
+
+namespace
+{
+	class DummyGame : public IGame
+	{
+	public:
+		void RegisterEngine(Engine* /*engine*/) override {}
+		void Init() override {}
+		void Deinit() override {}
+	};
+
+	class DummyRenderingDevice : public IRenderingDevice
+	{
+	public:
+		void Resize(const ScreenSize& size) override { Size = size; }
+		const ScreenSize& GetScreenSize() const override { return Size; }
+		void RenderWorld(World* /*world*/) override {}
+		std::unique_ptr<ITextureDeviceProxy> CreateTexture(size_t /*width*/, size_t /*height*/, eTextureUsageType /*usage*/) override { return nullptr; }
+		std::unique_ptr<ITextFieldBufferDeviceProxy> CreateTextFieldBuffer() override { return nullptr; }
+		std::unique_ptr<IMeshDeviceProxy> CreateMesh() override { return nullptr; }
+
+		ScreenSize Size;
+	};
+
+	class TestComponentA : public ComponentBase
+	{
+	public:
+		TestComponentA(int value) : Value(value) {}
+		int Value;
+	};
+
+	class TestComponentB : public ComponentBase
+	{
+	public:
+		TestComponentB(int value) : Value(value) {}
+		int Value;
+	};
+
+	class TestComponentC : public ComponentBase
+	{
+	public:
+		TestComponentC(int value) : Value(value) {}
+		int Value;
+	};
+
+	class TestComponentHighID : public ComponentBase
+	{
+	public:
+		TestComponentHighID(int value) : Value(value) {}
+		int Value;
+	};
+
+	// stored without ComponentBase
+	struct TestPlainComponent
+	{
+		int16_t Value;
+	};
+
+	struct TestTag {};
+
+	enum class eTestComponents
+	{
+		A = (int)eEngineComponents::_COUNT,
+		B,
+		C,
+		_COUNT
+	};
+
+	/// Creates engine with test components registered for the duration of a test.
+	struct TestEngine
+	{
+		TestEngine(eComponentStorage storage)
+		{
+			gCoreConfig.ComponentStorage = storage;
+			EnginePtr = std::make_unique<Engine>(std::make_unique<DummyGame>(), std::make_unique<DummyRenderingDevice>());
+			EnginePtr->RegisterComponent<TestComponentA>((size_t)eTestComponents::A);
+			EnginePtr->RegisterComponent<TestComponentB>((size_t)eTestComponents::B);
+			EnginePtr->RegisterComponent<TestComponentC>((size_t)eTestComponents::C);
+		}
+		~TestEngine()
+		{
+			EnginePtr.reset();
+			gCoreConfig.ComponentStorage = eComponentStorage::POOL;
+		}
+
+		World* GetWorld() { return EnginePtr->GetWorld(); }
+
+		std::unique_ptr<Engine> EnginePtr;
+	};
+
+	EntityID Spawn(World* world, int a, int b, int c)
+	{
+		EntityID id = DeferredTaskSystem::SpawnEntityImmediate(world);
+		if (a >= 0)
+			DeferredTaskSystem::AddComponentImmediate<TestComponentA>(world, id, a);
+		if (b >= 0)
+			DeferredTaskSystem::AddComponentImmediate<TestComponentB>(world, id, b);
+		if (c >= 0)
+			DeferredTaskSystem::AddComponentImmediate<TestComponentC>(world, id, c);
+		return id;
+	}
+
+	// engine update needs a camera in the viewport
+	void AddCamera(World* world)
+	{
+		EntityID camera = DeferredTaskSystem::SpawnEntityImmediate(world);
+		DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, camera);
+		DeferredTaskSystem::AddComponentImmediate<CameraComponent>(world, camera, 60_deg, 1.0f, 1000.f);
+		world->GetWorldComponent<ViewportWorldComponent>()->SetCamera(0, world->GetComponent<CameraComponent>(camera));
+	}
+
+	template<typename QueryResultType>
+	Dynarray<int> CollectValues(const QueryResultType& result)
+	{
+		Dynarray<int> values;
+		for (auto components : result)
+			values.PushBack(std::get<0>(components)->Value);
+		std::sort(values.Begin(), values.End());
+		return values;
+	}
+}
+
+TEST_CASE("World entity handles", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		EntityID a = Spawn(world, 1, -1, -1);
+		EntityID b = Spawn(world, 2, 3, -1);
+		REQUIRE(a != b);
+		REQUIRE(world->IsEntityAlive(a));
+		REQUIRE(world->IsEntityAlive(b));
+		REQUIRE(world->GetComponent<TestComponentA>(b)->Value == 2);
+		REQUIRE(world->GetComponent<TestComponentB>(b)->Value == 3);
+		REQUIRE(world->GetComponent<TestComponentB>(a) == nullptr);
+
+		DeferredTaskSystem::DestroyEntityImmediate(world, a);
+		REQUIRE(!world->IsEntityAlive(a));
+		REQUIRE(world->GetComponent<TestComponentA>(b)->Value == 2);
+
+		// slot of destroyed entity is reused with a new generation
+		EntityID c = Spawn(world, 4, -1, -1);
+		REQUIRE(c.GetIndex() == a.GetIndex());
+		REQUIRE(c != a);
+		REQUIRE(!world->IsEntityAlive(a));
+		REQUIRE(world->IsEntityAlive(c));
+
+		REQUIRE(!world->IsEntityAlive(EntityID()));
+	}
+}
+
+TEST_CASE("World entity limit", "[World]")
+{
+	TestEngine engine(eComponentStorage::POOL);
+	REQUIRE(engine.GetWorld()->GetMaxEntityCount() == DEFAULT_MAX_ENTITY_COUNT);
+
+	// worlds with their own limits can coexist with the engine world
+	World small(eComponentStorage::ARCHETYPE, 16, true);
+	REQUIRE(small.GetMaxEntityCount() == 16);
+	DeferredTaskSystem::AddWorldComponentImmediate<DeferredTaskWorldComponent>(&small);
+	Dynarray<EntityID> ids;
+	for (int i = 0; i < 16; ++i)
+		ids.PushBack(Spawn(&small, i, i, -1));
+	for (const EntityID& id : ids)
+		REQUIRE(small.IsEntityAlive(id));
+	REQUIRE((CollectValues(small.Query<With<TestComponentB>>()).GetSize() == 16));
+
+	// destroyed slots are reused, so the limit applies to entities that exist at once
+	for (size_t i = 0; i < 8; ++i)
+		DeferredTaskSystem::DestroyEntityImmediate(&small, ids[i]);
+	for (int i = 0; i < 8; ++i)
+		Spawn(&small, i, -1, -1);
+	REQUIRE((CollectValues(small.Query<With<TestComponentA>>()).GetSize() == 16));
+}
+
+TEST_CASE("World queries", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		Spawn(world, 1, -1, -1);
+		EntityID ab = Spawn(world, 2, 20, -1);
+		Spawn(world, 3, 30, 300);
+		Spawn(world, -1, 40, -1);
+		Spawn(world, 5, -1, 500);
+
+		// cached query is created before the changes below, so its results have to be updated incrementally
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentA, TestComponentB>, Without<TestComponentC>>()) == Dynarray<int>{ 2 }));
+
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>>()) == Dynarray<int>{ 1, 2, 3, 5 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentB>>()) == Dynarray<int>{ 20, 30, 40 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentB>>()) == Dynarray<int>{ 2, 3 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>, Without<TestComponentC>>()) == Dynarray<int>{ 1, 2 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentC>, Without<TestComponentA>>()) == Dynarray<int>{}));
+
+		// optional components are returned when present
+		size_t withOptional = 0;
+		for (auto components : world->Query<With<TestComponentA>, Optional<TestComponentC>>())
+		{
+			TestComponentA* a = std::get<TestComponentA*>(components);
+			TestComponentC* c = std::get<TestComponentC*>(components);
+			REQUIRE(a != nullptr);
+			if (c)
+			{
+				REQUIRE(c->Value == a->Value * 100);
+				++withOptional;
+			}
+		}
+		REQUIRE(withOptional == 2);
+
+		EntityID newAb = Spawn(world, 6, 60, -1);
+		DeferredTaskSystem::AddComponentImmediate<TestComponentC>(world, ab, 200);
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentA, TestComponentB>, Without<TestComponentC>>()) == Dynarray<int>{ 6 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentB>, Without<TestComponentC>>()) == Dynarray<int>{ 6 }));
+
+		DeferredTaskSystem::DestroyEntityImmediate(world, newAb);
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentA, TestComponentB>, Without<TestComponentC>>()) == Dynarray<int>{}));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentB>, Without<TestComponentC>>()) == Dynarray<int>{}));
+	}
+}
+
+TEST_CASE("World parallel for each", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		const int count = 1000;
+		for (int i = 0; i < count; ++i)
+			Spawn(world, i, i % 3 ? i : -1, i % 5 ? -1 : i);
+
+		// every matching entity is visited exactly once, Catch assertions are not thread safe so errors are only counted
+		std::atomic<int> visited(0);
+		std::atomic<int> mismatched(0);
+		world->ParallelForEach<TestComponentA, TestComponentB>([&visited, &mismatched](TestComponentA* a, TestComponentB* b)
+		{
+			if (a->Value != b->Value)
+				++mismatched;
+			b->Value += count;
+			++visited;
+		}, 16);
+		REQUIRE(mismatched == 0);
+		REQUIRE(visited == count - (count + 2) / 3);
+		for (auto components : world->Query<With<TestComponentA, TestComponentB>>())
+			REQUIRE(std::get<TestComponentB*>(components)->Value == std::get<TestComponentA*>(components)->Value + count);
+
+		// structural changes are scheduled as deferred tasks
+		world->ParallelForEach<TestComponentC>([world](TestComponentC* c) { DeferredTaskSystem::DestroyEntity(world, c->GetOwnerID()); }, 8);
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentC>>()).GetSize() == count / 5));
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentC>>()).GetSize() == 0));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>>()).GetSize() == count - count / 5));
+	}
+}
+
+TEST_CASE("World batch spawn and destroy", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		// batch is placed next to entities spawned one by one
+		EntityID single = Spawn(world, 1, 1, -1);
+		Dynarray<EntityID> ids = DeferredTaskSystem::SpawnEntitiesImmediate<TestComponentA, TestComponentB>(world, 100, std::make_tuple(7), std::make_tuple(8));
+		REQUIRE(ids.GetSize() == 100);
+		for (const EntityID& id : ids)
+		{
+			REQUIRE(world->IsEntityAlive(id));
+			REQUIRE(id != single);
+			REQUIRE(world->GetComponent<TestComponentA>(id)->Value == 7);
+			REQUIRE(world->GetComponent<TestComponentB>(id)->Value == 8);
+			REQUIRE(world->GetComponent<TestComponentA>(id)->GetOwnerID() == id);
+			REQUIRE(!world->GetComponent<TestComponentC>(id));
+		}
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestComponentB>>()).GetSize() == 101));
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentB>>()).GetSize() == 101));
+
+		// batch destroy releases slots that the next batch reuses
+		Dynarray<EntityID> destroyed;
+		for (size_t i = 0; i < ids.GetSize(); i += 2)
+			destroyed.PushBack(ids[i]);
+		DeferredTaskSystem::DestroyEntitiesImmediate(world, destroyed);
+		for (const EntityID& id : destroyed)
+			REQUIRE(!world->IsEntityAlive(id));
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentB>>()).GetSize() == 51));
+
+		Dynarray<EntityID> reused = DeferredTaskSystem::SpawnEntitiesImmediate<TestComponentC>(world, 60, std::make_tuple(3));
+		size_t reusedSlots = 0;
+		for (const EntityID& id : reused)
+		{
+			REQUIRE(world->GetComponent<TestComponentC>(id)->Value == 3);
+			for (const EntityID& old : destroyed)
+				if (old.GetIndex() == id.GetIndex())
+					++reusedSlots;
+		}
+		REQUIRE(reusedSlots == destroyed.GetSize());
+		REQUIRE((CollectValues(world->Query<With<TestComponentC>>()).GetSize() == 60));
+
+		// already destroyed entities are skipped
+		DeferredTaskSystem::DestroyEntitiesImmediate(world, destroyed);
+		DeferredTaskSystem::DestroyEntitiesImmediate(world, reused);
+		REQUIRE((CollectValues(world->Query<With<TestComponentC>>()).GetSize() == 0));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>>()).GetSize() == 51));
+	}
+}
+
+TEST_CASE("World deferred tasks", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		ThreadPool* pool = engine.EnginePtr->GetThreadPool();
+
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			// tasks are recorded to buffers of the threads that schedule them
+			const int count = 500;
+			EntityID ids[count];
+			pool->Run(count, [world, &ids](size_t i)
+			{
+				ids[i] = DeferredTaskSystem::SpawnEntity(world);
+				DeferredTaskSystem::AddComponent<TestComponentA>(world, ids[i], static_cast<int>(i));
+			});
+			for (const EntityID& id : ids)
+				REQUIRE(!world->IsEntityAlive(id));
+
+			// entities reserved on other threads can be used on the main thread in the same frame
+			for (int i = 0; i < count; i += 2)
+				DeferredTaskSystem::AddComponent<TestComponentB>(world, ids[i], -i);
+
+			DeferredTaskSystem::DeferredTaskPhase(world);
+			for (int i = 0; i < count; ++i)
+			{
+				REQUIRE(world->IsEntityAlive(ids[i]));
+				REQUIRE(world->GetComponent<TestComponentA>(ids[i])->Value == i);
+				if (i % 2 == 0)
+					REQUIRE(world->GetComponent<TestComponentB>(ids[i])->Value == -i);
+			}
+
+			for (const EntityID& id : ids)
+				DeferredTaskSystem::DestroyEntity(world, id);
+			DeferredTaskSystem::DeferredTaskPhase(world);
+			for (const EntityID& id : ids)
+				REQUIRE(!world->IsEntityAlive(id));
+		}
+	}
+}
+
+TEST_CASE("World change tracking", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		const int count = 1000;
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < count; ++i)
+			ids.PushBack(Spawn(world, i, i, -1));
+
+		// added components count as changed
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentA>>()).GetSize() == count));
+		REQUIRE((CollectValues(world->CachedQuery<Changed<TestComponentA>, With<TestComponentB>>()).GetSize() == count));
+
+		uint32_t since = world->AdvanceChangeVersion();
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentA>>(since)).GetSize() == 0));
+		REQUIRE((CollectValues(world->CachedQuery<Changed<TestComponentA>, With<TestComponentB>>()).GetSize() == 0));
+
+		world->GetComponent<TestComponentA>(ids[5])->MarkChanged();
+		world->GetComponent<TestComponentA>(ids[700])->MarkChanged();
+		world->GetComponent<TestComponentB>(ids[6])->MarkChanged();
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentA>>(since)) == Dynarray<int>{ 5, 700 }));
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentA, TestComponentB>>(since)) == Dynarray<int>{ 5, 6, 700 }));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>, Changed<TestComponentB>>(since)) == Dynarray<int>{ 6 }));
+
+		// cached query remembers its previous call
+		REQUIRE((CollectValues(world->CachedQuery<Changed<TestComponentA>, With<TestComponentB>>()) == Dynarray<int>{ 5, 700 }));
+		REQUIRE((CollectValues(world->CachedQuery<Changed<TestComponentA>, With<TestComponentB>>()).GetSize() == 0));
+
+		// changes survive moving components between archetypes and chunks
+		since = world->AdvanceChangeVersion();
+		world->GetComponent<TestComponentA>(ids[count - 1])->MarkChanged();
+		world->GetComponent<TestComponentA>(ids[10])->MarkChanged();
+		DeferredTaskSystem::AddComponentImmediate<TestComponentC>(world, ids[10], 10);
+		DeferredTaskSystem::DestroyEntityImmediate(world, ids[0]);
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentA>>(since)) == Dynarray<int>{ 10, count - 1 }));
+		REQUIRE((CollectValues(world->Query<Changed<TestComponentC>>(since)) == Dynarray<int>{ 10 }));
+		REQUIRE((CollectValues(world->CachedQuery<Changed<TestComponentA>, With<TestComponentB>>()) == Dynarray<int>{ 10, count - 1 }));
+
+		// transform setters mark the transform, its children are marked by TransformUpdatePhase
+		EntityID parent = DeferredTaskSystem::SpawnEntityImmediate(world);
+		DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, parent);
+		EntityID child = DeferredTaskSystem::SpawnEntityImmediate(world);
+		DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, child, world->GetComponent<TransformComponent>(parent));
+		since = world->AdvanceChangeVersion();
+		REQUIRE(world->Query<Changed<TransformComponent>>(since).Begin() == world->Query<Changed<TransformComponent>>(since).End());
+		world->GetComponent<TransformComponent>(parent)->SetLocalTranslation(Vector(1.f, 2.f, 3.f));
+		const auto countChangedTransforms = [&]()
+		{
+			size_t changedTransforms = 0;
+			for (auto components : world->Query<Changed<TransformComponent>>(since))
+			{
+				UNUSED(components);
+				++changedTransforms;
+			}
+			return changedTransforms;
+		};
+		REQUIRE(countChangedTransforms() == 1);
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(countChangedTransforms() == 2);
+	}
+}
+
+TEST_CASE("World compact entities", "[World]")
+{
+	// entity keeps only a mask and a pointer, not a table of all component types
+	REQUIRE(sizeof(Entity) <= 80);
+
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		const size_t highID = MAX_COMPONENTS_COUNT - 1;
+		engine.EnginePtr->RegisterComponent<TestComponentHighID>(highID);
+
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < 100; ++i)
+		{
+			// components are added out of ID order, packed lists have to stay sorted
+			EntityID id = Spawn(world, -1, -1, i);
+			DeferredTaskSystem::AddComponentImmediate<TestComponentHighID>(world, id, 1000 + i);
+			DeferredTaskSystem::AddComponentImmediate<TestComponentA>(world, id, i);
+			if (i % 2)
+				DeferredTaskSystem::AddComponentImmediate<TestComponentB>(world, id, -i);
+			ids.PushBack(id);
+		}
+
+		for (int i = 0; i < 100; ++i)
+		{
+			REQUIRE(world->GetComponent<TestComponentA>(ids[i])->Value == i);
+			REQUIRE(world->GetComponent<TestComponentC>(ids[i])->Value == i);
+			REQUIRE(world->GetComponent<TestComponentHighID>(ids[i])->Value == 1000 + i);
+			REQUIRE(world->GetComponent<TestComponentHighID>(ids[i])->GetOwnerID() == ids[i]);
+			if (i % 2)
+				REQUIRE(world->GetComponent<TestComponentB>(ids[i])->Value == -i);
+			else
+				REQUIRE(world->GetComponent<TestComponentB>(ids[i]) == nullptr);
+		}
+		REQUIRE((CollectValues(world->Query<With<TestComponentHighID>, Without<TestComponentB>>()).GetSize() == 50));
+		REQUIRE((CollectValues(world->CachedQuery<With<TestComponentB, TestComponentHighID>>()).GetSize() == 50));
+
+		// removing a component in the middle keeps the others reachable
+		for (int i = 0; i < 100; i += 3)
+			DeferredTaskSystem::RemoveComponent<TestComponentC>(world, ids[i]);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		for (int i = 0; i < 100; ++i)
+		{
+			REQUIRE((world->GetComponent<TestComponentC>(ids[i]) == nullptr) == (i % 3 == 0));
+			REQUIRE(world->GetComponent<TestComponentA>(ids[i])->Value == i);
+			REQUIRE(world->GetComponent<TestComponentHighID>(ids[i])->Value == 1000 + i);
+		}
+
+		for (const EntityID& id : ids)
+			DeferredTaskSystem::DestroyEntityImmediate(world, id);
+		REQUIRE((CollectValues(world->Query<With<TestComponentHighID>>()).GetSize() == 0));
+	}
+}
+
+TEST_CASE("World serialization", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		WorldSerializer serializer;
+		serializer.RegisterComponent<TestComponentA>("TestA",
+			[](const TestComponentA& a, BinaryWriter& writer, WorldSaveContext&) { writer.Write(a.Value); },
+			[](BinaryReader& reader, const WorldLoadContext&) { return TestComponentA(reader.Read<int>()); });
+
+		// binary tree of transforms, every third entity moves, component B is not serializable
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < 100; ++i)
+		{
+			EntityID id = Spawn(world, i, i % 5 == 0 ? i : -1, -1);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id);
+			TransformComponent* transform = world->GetComponent<TransformComponent>(id);
+			if (i > 0)
+				transform->SetParent(world->GetComponent<TransformComponent>(ids[(i - 1) / 2]));
+			transform->SetLocalTranslation(Vector((float)i, 1.0f, 0.0f));
+			transform->SetLocalScale(i % 2 ? 1.0f : 2.0f);
+			if (i % 3 == 0)
+				DeferredTaskSystem::AddComponentImmediate<FreeFloatMovementComponent>(world, id, (float)i, (float)-i);
+			ids.PushBack(id);
+		}
+		// entity without serializable components is still saved
+		DeferredTaskSystem::SpawnEntityImmediate(world);
+
+		const Dynarray<uint8_t> data = serializer.Save(world);
+		World loaded(storage);
+		const Dynarray<EntityID> loadedIds = serializer.Load(&loaded, data);
+		REQUIRE(loadedIds.GetSize() == 101);
+
+		// entities are saved grouped by components, find them by value of A
+		std::map<int, EntityID> loadedByValue;
+		for (auto components : loaded.Query<With<TestComponentA, TransformComponent>>())
+			loadedByValue[std::get<0>(components)->Value] = std::get<0>(components)->GetOwnerID();
+		REQUIRE(loadedByValue.size() == 100);
+		REQUIRE((CollectValues(loaded.Query<With<TestComponentB>>()).GetSize() == 0));
+
+		for (int i = 0; i < 100; ++i)
+		{
+			const EntityID id = loadedByValue[i];
+			const TransformComponent* original = world->GetComponent<TransformComponent>(ids[i]);
+			const TransformComponent* transform = loaded.GetComponent<TransformComponent>(id);
+			REQUIRE(transform->GetLocalTranslation() == original->GetLocalTranslation());
+			REQUIRE(transform->GetLocalScale() == original->GetLocalScale());
+			REQUIRE(transform->GetGlobalTransformationMatrix() == original->GetGlobalTransformationMatrix());
+			if (i > 0)
+				REQUIRE(transform->GetParent()->GetOwnerID() == loadedByValue[(i - 1) / 2]);
+			else
+				REQUIRE(transform->GetParent() == nullptr);
+			REQUIRE(transform->GetChildren().GetSize() == original->GetChildren().GetSize());
+
+			const FreeFloatMovementComponent* movement = loaded.GetComponent<FreeFloatMovementComponent>(id);
+			REQUIRE((movement != nullptr) == (i % 3 == 0));
+			if (movement)
+			{
+				REQUIRE(movement->GetMovementSpeed() == (float)i);
+				REQUIRE(movement->GetRotationSpeed() == (float)-i);
+			}
+		}
+
+		// saving loaded world gives the same data
+		REQUIRE(serializer.Save(&loaded) == data);
+
+		// invalid data is rejected before anything is spawned
+		World rejected(storage);
+		Dynarray<uint8_t> truncated = data;
+		truncated.Resize(data.GetSize() - 3);
+		REQUIRE_THROWS_AS(serializer.Load(&rejected, truncated), FileIOException);
+		Dynarray<uint8_t> corrupted = data;
+		corrupted[0] ^= 0xFF;
+		REQUIRE_THROWS_AS(serializer.Load(&rejected, corrupted), FileIOException);
+		REQUIRE((CollectValues(rejected.Query<With<TestComponentA>>()).GetSize() == 0));
+
+		// serializer without TestA skips its data
+		WorldSerializer engineOnly;
+		World partial(storage);
+		REQUIRE(engineOnly.Load(&partial, data).GetSize() == 101);
+		REQUIRE((CollectValues(partial.Query<With<TestComponentA>>()).GetSize() == 0));
+		size_t movementCount = 0;
+		for (auto components : partial.Query<With<FreeFloatMovementComponent, TransformComponent>>())
+		{
+			UNUSED(components);
+			++movementCount;
+		}
+		REQUIRE(movementCount == 34);
+	}
+}
+
+TEST_CASE("World snapshot", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		// first ten transforms form a chain, every fourth entity owns B
+		const int count = 1000;
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < count; ++i)
+		{
+			EntityID id = Spawn(world, i, i % 4 == 0 ? i : -1, -1);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id);
+			TransformComponent* transform = world->GetComponent<TransformComponent>(id);
+			if (i > 0 && i < 10)
+				transform->SetParent(world->GetComponent<TransformComponent>(ids[i - 1]));
+			transform->SetLocalTranslation(Vector((float)i, 0.0f, 0.0f));
+			ids.PushBack(id);
+		}
+		const EntityID destroyed = Spawn(world, -1, -1, 7);
+		DeferredTaskSystem::DestroyEntityImmediate(world, destroyed);
+		const Matrix leafGlobal = world->GetComponent<TransformComponent>(ids[9])->GetGlobalTransformationMatrix();
+
+		WorldSnapshot snapshot;
+		REQUIRE(snapshot.IsEmpty());
+		world->Snapshot(snapshot);
+		REQUIRE(snapshot.GetEntityCount() == count);
+
+		// modified components are brought back
+		world->GetComponent<TestComponentA>(ids[5])->Value = -5;
+		world->GetComponent<TestComponentA>(ids[5])->MarkChanged();
+		world->GetComponent<TestComponentB>(ids[400])->Value = -400;
+		world->GetComponent<TestComponentB>(ids[400])->MarkChanged();
+		world->GetComponent<TransformComponent>(ids[0])->SetLocalTranslation(Vector(100.0f, 0.0f, 0.0f));
+		world->GetComponent<TransformComponent>(ids[5])->ResetParent();
+		world->Restore(snapshot);
+		REQUIRE(world->GetComponent<TestComponentA>(ids[5])->Value == 5);
+		REQUIRE(world->GetComponent<TestComponentB>(ids[400])->Value == 400);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[5])->GetParent()->GetOwnerID() == ids[4]);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[4])->GetChildren().GetSize() == 1);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[9])->GetGlobalTransformationMatrix() == leafGlobal);
+
+		// spawned and destroyed entities are brought back with their IDs
+		const EntityID spawned = Spawn(world, 5000, -1, -1);
+		DeferredTaskSystem::DestroyEntityImmediate(world, ids[3]);
+		REQUIRE(!world->IsEntityAlive(ids[9]));
+		world->Restore(snapshot);
+		REQUIRE(!world->IsEntityAlive(spawned));
+		REQUIRE(!world->IsEntityAlive(destroyed));
+		for (int i = 0; i < count; ++i)
+		{
+			REQUIRE(world->IsEntityAlive(ids[i]));
+			REQUIRE(world->GetComponent<TestComponentA>(ids[i])->Value == i);
+		}
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>>()).GetSize() == count));
+		REQUIRE((CollectValues(world->Query<With<TestComponentB>>()).GetSize() == count / 4));
+		for (int i = 1; i < 10; ++i)
+			REQUIRE(world->GetComponent<TransformComponent>(ids[i])->GetParent()->GetOwnerID() == ids[i - 1]);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[9])->GetGlobalTransformationMatrix() == leafGlobal);
+
+		// taking the snapshot again copies changes only
+		world->GetComponent<TestComponentA>(ids[7])->Value = 77;
+		world->GetComponent<TestComponentA>(ids[7])->MarkChanged();
+		world->GetComponent<TransformComponent>(ids[8])->ResetParent();
+		world->GetComponent<TransformComponent>(ids[8])->SetParent(world->GetComponent<TransformComponent>(ids[500]));
+		world->Snapshot(snapshot);
+		world->GetComponent<TestComponentA>(ids[7])->Value = 0;
+		world->GetComponent<TestComponentA>(ids[7])->MarkChanged();
+		world->GetComponent<TransformComponent>(ids[8])->ResetParent();
+		world->Restore(snapshot);
+		REQUIRE(world->GetComponent<TestComponentA>(ids[7])->Value == 77);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[8])->GetParent()->GetOwnerID() == ids[500]);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[7])->GetChildren().IsEmpty());
+
+		// replay after restore spawns the same entities
+		REQUIRE(Spawn(world, 5000, -1, -1) == spawned);
+
+		snapshot.Clear();
+		REQUIRE(snapshot.IsEmpty());
+	}
+}
+
+TEST_CASE("World background loading", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		Engine* enginePtr = engine.EnginePtr.get();
+		AddCamera(engine.GetWorld());
+		Spawn(engine.GetWorld(), 1, -1, -1);
+
+		// simulation worlds are independent from the active one
+		std::unique_ptr<World> simulation = enginePtr->CreateWorld();
+		REQUIRE(simulation->GetWorldComponent<TimeWorldComponent>() != nullptr);
+		Spawn(simulation.get(), 2, -1, -1);
+		REQUIRE((CollectValues(engine.GetWorld()->Query<With<TestComponentA>>()) == Dynarray<int>{ 1 }));
+		REQUIRE((CollectValues(simulation->Query<With<TestComponentA>>()) == Dynarray<int>{ 2 }));
+
+		std::atomic<bool> buildOnMainThread(true);
+		std::atomic<bool> taskOnMainThread(false);
+		enginePtr->LoadWorldAsync([&](World* world)
+		{
+			buildOnMainThread = enginePtr->IsMainThread();
+			AddCamera(world);
+			DeferredTaskSystem::SpawnEntitiesImmediate<TestComponentA>(world, 1000, std::make_tuple(3));
+			enginePtr->RunOnMainThread([&]() { taskOnMainThread = enginePtr->IsMainThread(); });
+		});
+		REQUIRE(enginePtr->IsLoadingWorld());
+
+		// active world keeps running until the new one is ready
+		size_t frames = 0;
+		while (enginePtr->IsLoadingWorld())
+		{
+			REQUIRE((CollectValues(engine.GetWorld()->Query<With<TestComponentA>>()) == Dynarray<int>{ 1 }));
+			enginePtr->Update();
+			++frames;
+		}
+		REQUIRE(frames > 0);
+		REQUIRE(!buildOnMainThread);
+		REQUIRE(taskOnMainThread);
+		REQUIRE((CollectValues(engine.GetWorld()->Query<With<TestComponentA>>()).GetSize() == 1000));
+
+		// engine destroyed during loading waits for the loader
+		enginePtr->LoadWorldAsync([&](World* world)
+		{
+			Spawn(world, 4, -1, -1);
+			enginePtr->RunOnMainThread([]() {});
+		});
+	}
+}
+
+TEST_CASE("World observers", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		size_t addBatches = 0;
+		Dynarray<int> added;
+		Dynarray<EntityID> removed;
+		Dynarray<int> chained;
+		world->OnAdd<TestComponentA>([&](World* w, const Dynarray<TestComponentA*>& components)
+		{
+			++addBatches;
+			for (TestComponentA* component : components)
+			{
+				added.PushBack(component->Value);
+				// observers can change the world, following events are delivered in the same dispatch
+				if (component->Value == 0)
+					DeferredTaskSystem::AddComponentImmediate<TestComponentC>(w, component->GetOwnerID(), 100);
+			}
+		});
+		world->OnRemove<TestComponentA>([&](World*, const Dynarray<EntityID>& ids)
+		{
+			for (const EntityID& id : ids)
+				removed.PushBack(id);
+		});
+		world->OnAdd<TestComponentC>([&](World*, const Dynarray<TestComponentC*>& components)
+		{
+			for (TestComponentC* component : components)
+				chained.PushBack(component->Value);
+		});
+
+		// nothing is delivered before the dispatch, then everything in one batch per type
+		Dynarray<EntityID> ids = DeferredTaskSystem::SpawnEntitiesImmediate<TestComponentA, TestComponentB>(world, 100, std::make_tuple(1), std::make_tuple(2));
+		const EntityID single = Spawn(world, 0, -1, -1);
+		const EntityID deferred = DeferredTaskSystem::SpawnEntity(world);
+		DeferredTaskSystem::AddComponent<TestComponentA>(world, deferred, 3);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		REQUIRE(addBatches == 0);
+		world->DispatchObserverEvents();
+		REQUIRE(addBatches == 1);
+		REQUIRE(added.GetSize() == 102);
+		REQUIRE(std::count(added.Begin(), added.End(), 1) == 100);
+		REQUIRE((chained == Dynarray<int>{ 100 }));
+		REQUIRE(world->GetComponent<TestComponentC>(single)->Value == 100);
+		REQUIRE(removed.IsEmpty());
+
+		// events are delivered once
+		world->DispatchObserverEvents();
+		REQUIRE(addBatches == 1);
+
+		// components removed before the dispatch are not delivered as added, removals include destroyed entities
+		added.Clear();
+		const EntityID transient = Spawn(world, 5, -1, -1);
+		DeferredTaskSystem::DestroyEntityImmediate(world, transient);
+		DeferredTaskSystem::DestroyEntityImmediate(world, ids[7]);
+		DeferredTaskSystem::RemoveComponent<TestComponentA>(world, single);
+		DeferredTaskSystem::RemoveComponent<TestComponentB>(world, ids[8]);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		world->DispatchObserverEvents();
+		REQUIRE(added.IsEmpty());
+		REQUIRE(addBatches == 1);
+		REQUIRE(removed.GetSize() == 3);
+		REQUIRE(std::find(removed.Begin(), removed.End(), transient) != removed.End());
+		REQUIRE(std::find(removed.Begin(), removed.End(), ids[7]) != removed.End());
+		REQUIRE(std::find(removed.Begin(), removed.End(), single) != removed.End());
+	}
+}
+
+TEST_CASE("World sorted query", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		uint64_t (*key)(const TestComponentA*) = [](const TestComponentA* a) { return (uint64_t)a->Value; };
+
+		// visits exactly the expected entities (by slot), ordered by key and then by slot
+		const auto checkOrder = [&](const std::map<size_t, int>& expected)
+		{
+			size_t count = 0;
+			int prevValue = -1;
+			size_t prevIndex = 0;
+			for (auto it = world->SortedQuery<With<TestComponentA>, Without<TestComponentC>>(key).Begin(); it != world->SortedQuery<With<TestComponentA>, Without<TestComponentC>>(key).End(); ++it)
+			{
+				const int value = std::get<TestComponentA*>(*it)->Value;
+				const EntityID id = it.GetEntityID();
+				REQUIRE(expected.find(id.GetIndex()) != expected.end());
+				REQUIRE(expected.at(id.GetIndex()) == value);
+				REQUIRE((value > prevValue || (value == prevValue && id.GetIndex() > prevIndex)));
+				prevValue = value;
+				prevIndex = id.GetIndex();
+				++count;
+			}
+			REQUIRE(count == expected.size());
+		};
+
+		std::map<size_t, int> expected;
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < 200; ++i)
+		{
+			ids.PushBack(Spawn(world, (i * 37) % 50, i % 3 == 0 ? 1 : -1, i % 10 == 0 ? 1 : -1));
+			if (i % 10 != 0)
+				expected[ids[i].GetIndex()] = (i * 37) % 50;
+		}
+		checkOrder(expected);
+
+		// key changes of marked components, additions and removals between queries
+		for (int i = 1; i < 200; i += 7)
+		{
+			TestComponentA* a = world->GetComponent<TestComponentA>(ids[i]);
+			a->Value = 100 - a->Value;
+			a->MarkChanged();
+			if (expected.count(ids[i].GetIndex()))
+				expected[ids[i].GetIndex()] = a->Value;
+		}
+		for (int i = 2; i < 200; i += 11)
+		{
+			DeferredTaskSystem::DestroyEntityImmediate(world, ids[i]);
+			expected.erase(ids[i].GetIndex());
+		}
+		for (int i = 0; i < 200; i += 20)
+		{
+			DeferredTaskSystem::RemoveComponent<TestComponentC>(world, ids[i]);
+			DeferredTaskSystem::DeferredTaskPhase(world);
+			expected[ids[i].GetIndex()] = world->GetComponent<TestComponentA>(ids[i])->Value;
+		}
+		for (int i = 0; i < 20; ++i)
+		{
+			const EntityID id = Spawn(world, i, -1, -1);
+			expected[id.GetIndex()] = i;
+		}
+		checkOrder(expected);
+
+		// entity matched again before the query is not visited twice
+		DeferredTaskSystem::AddComponentImmediate<TestComponentC>(world, ids[1], 0);
+		DeferredTaskSystem::RemoveComponent<TestComponentC>(world, ids[1]);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		checkOrder(expected);
+	}
+}
+
+TEST_CASE("World transform hierarchy", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		TransformHierarchy& hierarchy = world->GetTransformHierarchy();
+
+		// checks that every node follows its parent, levels are contiguous and children match transform links
+		const auto checkHierarchy = [&](size_t expectedSize)
+		{
+			REQUIRE(!hierarchy.IsValid());
+			hierarchy.Update(world);
+			REQUIRE(hierarchy.IsValid());
+			REQUIRE(hierarchy.GetSize() == expectedSize);
+			for (size_t depth = 0; depth < hierarchy.GetDepthCount(); ++depth)
+			{
+				REQUIRE(hierarchy.GetDepthBegin(depth) < hierarchy.GetDepthEnd(depth));
+				for (size_t node = hierarchy.GetDepthBegin(depth); node < hierarchy.GetDepthEnd(depth); ++node)
+				{
+					const TransformComponent* transform = hierarchy.GetTransform(node);
+					const size_t parent = hierarchy.GetParent(node);
+					if (depth == 0)
+						REQUIRE(parent == TransformHierarchy::NO_PARENT);
+					else
+					{
+						REQUIRE(parent >= hierarchy.GetDepthBegin(depth - 1));
+						REQUIRE(parent < hierarchy.GetDepthEnd(depth - 1));
+						REQUIRE(hierarchy.GetTransform(parent) == transform->GetParent());
+					}
+					REQUIRE(hierarchy.GetChildCount(node) == transform->GetChildCount());
+					const Dynarray<TransformComponent*> children = transform->GetChildren();
+					for (size_t i = 0; i < children.GetSize(); ++i)
+						REQUIRE(hierarchy.GetTransform(hierarchy.GetFirstChild(node) + i) == children[i]);
+				}
+			}
+			REQUIRE(hierarchy.GetDepthEnd(hierarchy.GetDepthCount() - 1) == expectedSize);
+		};
+
+		// binary tree and a long chain, components added later move transforms between archetypes
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < 300; ++i)
+		{
+			EntityID id = Spawn(world, i, -1, -1);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id);
+			if (i > 0 && i < 100)
+				world->GetComponent<TransformComponent>(id)->SetParent(world->GetComponent<TransformComponent>(ids[(i - 1) / 2]));
+			else if (i > 100)
+				world->GetComponent<TransformComponent>(id)->SetParent(world->GetComponent<TransformComponent>(ids[i - 1]));
+			if (i % 3 == 0)
+				DeferredTaskSystem::AddComponentImmediate<TestComponentB>(world, id, i);
+			ids.PushBack(id);
+		}
+		checkHierarchy(300);
+		REQUIRE(hierarchy.GetDepthCount() == 200);
+		REQUIRE(hierarchy.GetDepthEnd(0) == 2);
+
+		// hierarchy edits invalidate the order
+		hierarchy.Update(world);
+		world->GetComponent<TransformComponent>(ids[1])->ResetParent();
+		world->GetComponent<TransformComponent>(ids[150])->ResetParent();
+		world->GetComponent<TransformComponent>(ids[150])->SetParent(world->GetComponent<TransformComponent>(ids[2]));
+		checkHierarchy(300);
+		REQUIRE(hierarchy.GetDepthEnd(0) == 3);
+
+		// destroying an entity destroys its whole subtree (50 entities of the chain and 63 of the tree), deep chains do not recurse
+		DeferredTaskSystem::DestroyEntityImmediate(world, ids[100]);
+		DeferredTaskSystem::DestroyEntityImmediate(world, ids[1]);
+		for (int i = 100; i < 150; ++i)
+			REQUIRE(!world->IsEntityAlive(ids[i]));
+		REQUIRE(world->IsEntityAlive(ids[150]));
+		REQUIRE(!world->IsEntityAlive(ids[3]));
+		REQUIRE(world->IsEntityAlive(ids[2]));
+		checkHierarchy(300 - 50 - 63);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[2])->GetChildCount() == 3);
+
+		// removing a transform makes its children roots, their global transformations become the local ones
+		world->GetComponent<TransformComponent>(ids[2])->SetLocalTranslation(Vector(10.f, 0.f, 0.f));
+		world->GetComponent<TransformComponent>(ids[5])->SetLocalTranslation(Vector(0.f, 1.f, 0.f));
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[5])->GetGlobalTranslation() == Vector(10.f, 1.f, 0.f));
+		DeferredTaskSystem::RemoveComponent<TransformComponent>(world, ids[2]);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[5])->GetParent() == nullptr);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[5])->GetGlobalTranslation() == Vector(0.f, 1.f, 0.f));
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(world->GetComponent<TransformComponent>(ids[5])->GetGlobalTranslation() == Vector(0.f, 1.f, 0.f));
+		REQUIRE(world->GetComponent<TransformComponent>(ids[6])->GetGlobalTranslation() == world->GetComponent<TransformComponent>(ids[6])->GetLocalTranslation());
+	}
+}
+
+TEST_CASE("World transform update phase", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		// binary tree, every node moved by its index along X, so global X is the sum of indices of its ancestors
+		Dynarray<EntityID> ids;
+		Dynarray<float> expectedX;
+		for (int i = 0; i < 127; ++i)
+		{
+			EntityID id = Spawn(world, i, -1, -1);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id);
+			TransformComponent* transform = world->GetComponent<TransformComponent>(id);
+			if (i > 0)
+				transform->SetParent(world->GetComponent<TransformComponent>(ids[(i - 1) / 2]));
+			transform->SetLocalTranslation(Vector((float)i, 1.f, 0.f));
+			ids.PushBack(id);
+			expectedX.PushBack(i > 0 ? expectedX[(i - 1) / 2] + i : 0.f);
+		}
+
+		const auto checkGlobals = [&](float rootX, float rootScale)
+		{
+			TransformSystem::TransformUpdatePhase(world);
+			for (size_t i = 0; i < ids.GetSize(); ++i)
+			{
+				const TransformComponent* transform = world->GetComponent<TransformComponent>(ids[i]);
+				const float depth = (float)FindLastSetBit(i + 1);
+				REQUIRE(transform->GetGlobalTranslation() == Vector(rootX + rootScale * expectedX[i], 1.f + rootScale * depth, 0.f));
+				REQUIRE(transform->GetGlobalScale() == Vector(rootScale, rootScale, rootScale));
+			}
+		};
+		checkGlobals(0.f, 1.f);
+
+		// changes of the root reach all descendants, repeated changes in one frame are applied once
+		TransformComponent* root = world->GetComponent<TransformComponent>(ids[0]);
+		root->SetLocalTranslation(Vector(5.f, 1.f, 0.f));
+		root->SetLocalTranslation(Vector(10.f, 1.f, 0.f));
+		root->SetLocalScale(2.f);
+		checkGlobals(10.f, 2.f);
+
+		// structural changes between updates rebuild the order
+		DeferredTaskSystem::AddComponentImmediate<TestComponentB>(world, ids[3], 3);
+		root->SetLocalScale(1.f);
+		checkGlobals(10.f, 1.f);
+
+		// deep chain, changes are O(1) and repeated ones are not counted, lazily read globals see changes of all ancestors
+		Dynarray<EntityID> chain;
+		for (int i = 0; i < 2000; ++i)
+		{
+			EntityID id = DeferredTaskSystem::SpawnEntityImmediate(world);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id, i > 0 ? world->GetComponent<TransformComponent>(chain[i - 1]) : nullptr);
+			world->GetComponent<TransformComponent>(id)->SetLocalTranslation(Vector(0.f, 0.f, 1.f));
+			chain.PushBack(id);
+		}
+		TransformSystem::TransformUpdatePhase(world);
+		TransformHierarchy& hierarchy = world->GetTransformHierarchy();
+		TransformComponent* chainRoot = world->GetComponent<TransformComponent>(chain[0]);
+		const TransformComponent* chainLeaf = world->GetComponent<TransformComponent>(chain[1999]);
+		REQUIRE(chainLeaf->GetGlobalTranslation() == Vector(0.f, 0.f, 2000.f));
+
+		const uint64_t changeCount = hierarchy.GetChangeCount();
+		for (int i = 1; i <= 3; ++i)
+			chainRoot->SetLocalTranslation(Vector((float)i, 0.f, 1.f));
+		REQUIRE(hierarchy.GetChangeCount() == changeCount + 1);
+		REQUIRE(chainLeaf->GetGlobalTranslation() == Vector(3.f, 0.f, 2000.f));
+		chainRoot->SetLocalTranslation(Vector(4.f, 0.f, 1.f));
+		REQUIRE(chainLeaf->GetGlobalTranslation() == Vector(4.f, 0.f, 2000.f));
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(world->GetComponent<TransformComponent>(chain[1000])->GetGlobalTranslation() == Vector(4.f, 0.f, 1001.f));
+	}
+}
+
+TEST_CASE("World parallel transform update phase", "[World]")
+{
+	// levels larger than a single task are split between workers even on machines with one core
+	const size_t workerThreadCount = gCoreConfig.WorkerThreadCount;
+	gCoreConfig.WorkerThreadCount = 3;
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+
+		// 4 roots with 600 children each, every child has 2 children of its own
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < 4 + 2400 + 4800; ++i)
+		{
+			EntityID id = DeferredTaskSystem::SpawnEntityImmediate(world);
+			TransformComponent* parent = i < 4 ? nullptr : world->GetComponent<TransformComponent>(ids[i < 2404 ? (i - 4) / 600 : 4 + (i - 2404) / 2]);
+			DeferredTaskSystem::AddComponentImmediate<TransformComponent>(world, id, parent);
+			TransformComponent* transform = world->GetComponent<TransformComponent>(id);
+			transform->SetLocalTranslation(Vector(0.1f * i, -0.3f * (i % 7), 1.7f));
+			transform->SetLocalRotation(Quaternion(Vector(1, 2, 3).GetNormalized(), Angle::FromDegrees((float)(i % 360))));
+			transform->SetLocalScale(1.f + 0.01f * (i % 5));
+			ids.PushBack(id);
+		}
+
+		// global transformations are computed exactly as serial composition of parent global and local transformation
+		const auto countMismatches = [&]()
+		{
+			size_t mismatches = 0;
+			for (const EntityID& id : ids)
+			{
+				const TransformComponent* transform = world->GetComponent<TransformComponent>(id);
+				const AffineMatrix expected = transform->GetParent()
+					? transform->GetParent()->GetGlobalTransformation() * transform->GetLocalTransformation()
+					: transform->GetLocalTransformation();
+				if (memcmp(transform->GetGlobalTransformation().GetDataPtr(), expected.GetDataPtr(), sizeof(float) * 12) != 0)
+					++mismatches;
+			}
+			return mismatches;
+		};
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(countMismatches() == 0);
+
+		// changed subtrees are processed by levels too, transforms changed together with their ancestors are updated once
+		const uint32_t since = world->AdvanceChangeVersion();
+		world->GetComponent<TransformComponent>(ids[1])->SetLocalScale(2.f);
+		for (int i = 604; i < 1204; i += 3)
+			world->GetComponent<TransformComponent>(ids[i])->SetLocalTranslation(Vector(1.f, 2.f, 3.f));
+		world->GetComponent<TransformComponent>(ids[7000])->SetLocalRotation(Quaternion(Vector(0, 1, 0), 30_deg));
+		TransformSystem::TransformUpdatePhase(world);
+		REQUIRE(countMismatches() == 0);
+
+		// the changed root with all its descendants and the changed leaf
+		size_t changedTransforms = 0;
+		for (auto components : world->Query<Changed<TransformComponent>>(since))
+		{
+			UNUSED(components);
+			++changedTransforms;
+		}
+		REQUIRE(changedTransforms == 1 + 600 + 1200 + 1);
+	}
+	gCoreConfig.WorkerThreadCount = workerThreadCount;
+}
+
+TEST_CASE("World tags and plain components", "[World]")
+{
+	for (eComponentStorage storage : { eComponentStorage::POOL, eComponentStorage::ARCHETYPE })
+	{
+		TestEngine engine(storage);
+		World* world = engine.GetWorld();
+		engine.EnginePtr->RegisterComponent<TestPlainComponent>((size_t)eTestComponents::_COUNT);
+		engine.EnginePtr->RegisterComponent<TestTag>((size_t)eTestComponents::_COUNT + 1);
+
+		// every second entity is tagged, every third one owns the plain component
+		const int count = 300;
+		Dynarray<EntityID> ids;
+		for (int i = 0; i < count; ++i)
+		{
+			EntityID id = Spawn(world, i, -1, i % 5 == 0 ? i : -1);
+			if (i % 2 == 0)
+				DeferredTaskSystem::AddComponentImmediate<TestTag>(world, id);
+			if (i % 3 == 0)
+				DeferredTaskSystem::AddComponentImmediate<TestPlainComponent>(world, id, TestPlainComponent{ (int16_t)i });
+			ids.PushBack(id);
+		}
+		REQUIRE(world->GetComponent<TestTag>(ids[0]) != nullptr);
+		REQUIRE(world->GetComponent<TestTag>(ids[1]) == nullptr);
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3])->Value == 3);
+		REQUIRE(world->GetComponent<TestComponentC>(ids[5])->Value == 5);
+		REQUIRE(world->GetComponent<TestComponentA>(ids[6])->Value == 6);
+
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestTag>>()).GetSize() == count / 2));
+		REQUIRE((CollectValues(world->Query<With<TestComponentA>, Without<TestTag>>()).GetSize() == count / 2));
+		Dynarray<int> plainValues;
+		for (auto components : world->Query<With<TestPlainComponent, TestTag>>())
+			plainValues.PushBack(std::get<TestPlainComponent*>(components)->Value);
+		REQUIRE(plainValues.GetSize() == count / 6);
+		for (int value : plainValues)
+			REQUIRE(value % 6 == 0);
+		size_t tagged = 0;
+		for (auto components : world->Query<With<TestTag>, Optional<TestComponentC>>())
+			tagged += std::get<TestComponentC*>(components) ? 1 : 0;
+		REQUIRE(tagged == count / 10);
+
+		std::atomic<int> visited(0);
+		world->ParallelForEach<TestPlainComponent>([&visited](TestPlainComponent* plain) { plain->Value += 1000; ++visited; }, 16);
+		REQUIRE(visited == count / 3);
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3])->Value == 1003);
+
+		// snapshots bring back tags and plain components, which are not change tracked
+		WorldSnapshot snapshot;
+		world->Snapshot(snapshot);
+		world->GetComponent<TestPlainComponent>(ids[3])->Value = 0;
+		world->Restore(snapshot);
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3])->Value == 1003);
+		DeferredTaskSystem::RemoveComponent<TestTag>(world, ids[0]);
+		DeferredTaskSystem::RemoveComponent<TestPlainComponent>(world, ids[3]);
+		DeferredTaskSystem::DeferredTaskPhase(world);
+		REQUIRE(world->GetComponent<TestTag>(ids[0]) == nullptr);
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3]) == nullptr);
+		REQUIRE(world->GetComponent<TestComponentA>(ids[3])->Value == 3);
+		world->Restore(snapshot);
+		REQUIRE(world->GetComponent<TestTag>(ids[0]) != nullptr);
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3])->Value == 1003);
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestTag>>()).GetSize() == count / 2));
+
+		for (int i = 0; i < count; i += 2)
+			DeferredTaskSystem::DestroyEntityImmediate(world, ids[i]);
+		REQUIRE((CollectValues(world->Query<With<TestComponentA, TestTag>>()).GetSize() == 0));
+		REQUIRE(world->Query<With<TestTag>>().begin() == world->Query<With<TestTag>>().end());
+		REQUIRE(world->GetComponent<TestPlainComponent>(ids[3])->Value == 1003);
+		REQUIRE(world->GetComponent<TestComponentC>(ids[5])->Value == 5);
+	}
+}